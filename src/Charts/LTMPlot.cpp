@@ -43,6 +43,7 @@
 #include "PaceZones.h"
 
 #include <QSettings>
+#include <QtConcurrent>
 
 #include <qwt_series_data.h>
 #include <qwt_scale_widget.h>
@@ -137,6 +138,7 @@ LTMPlot::LTMPlot(LTMWindow *parent, Context *context, int position) :
     curveColors = new CurveColors(this);
 
     settings = NULL;
+    preparing = NULL;
 
     configChanged(CONFIG_APPEARANCE); // set basic colors
 
@@ -148,6 +150,19 @@ LTMPlot::LTMPlot(LTMWindow *parent, Context *context, int position) :
 
 LTMPlot::~LTMPlot()
 {
+    // anything still being prepared writes to memory we own
+    QHashIterator<QFutureWatcher<void>*, LTMPreparing*> i(runs);
+    while (i.hasNext()) {
+        i.next();
+        i.value()->cancelled.store(1);
+    }
+    i.toFront();
+    while (i.hasNext()) {
+        i.next();
+        i.key()->waitForFinished();
+        delete i.value();
+        context->athlete->rideCache->release();
+    }
 }
 
 void
@@ -223,17 +238,6 @@ LTMPlot::setAxisTitle(QwtAxisId axis, QString label)
 void
 LTMPlot::setData(LTMSettings *set)
 {
-    QTime timer;
-    timer.start();
-
-    curveColors->isolated = false;
-    isolation = false;
-    int user=0;
-
-    bool haveBanister=false; // do we want to show the banister helper?
-
-    //qDebug()<<"Starting.."<<timer.elapsed();
-
     settings = set;
 
     // crop dates to at least within a year of the data available, but only if we have some data
@@ -271,6 +275,85 @@ LTMPlot::setData(LTMSettings *set)
 
     }
 
+    // anything still being prepared is out of date now
+    foreach(LTMPreparing *run, runs) run->cancelled.store(1);
+    preparing = NULL;
+
+    // metric and metadata curves are all built in a single pass over the
+    // rides on a worker thread, the rest is plotted once they are ready
+    LTMPreparing *run = new LTMPreparing;
+    run->settings = *settings;
+    run->data.resize(settings->metrics.count());
+
+    QList<LTMCurveJob> jobs;
+    if (settings->groupBy != LTM_TOD) {
+        for (int m=0; m<settings->metrics.count(); m++) {
+
+            MetricDetail metricDetail = settings->metrics[m];
+            if (metricDetail.type != METRIC_DB && metricDetail.type != METRIC_META) continue;
+
+            LTMCurveJob job;
+            job.metricDetail = metricDetail;
+            job.spec = curveSpecification(context, settings, metricDetail);
+            job.data = &run->data[m];
+            job.data->pending = true;
+            jobs << job;
+        }
+    }
+
+    // nothing to wait for
+    if (jobs.isEmpty()) {
+        plotData(run->data);
+        delete run;
+        emit plotted();
+        return;
+    }
+
+    // rides removed whilst we run must not be deleted under us
+    context->athlete->rideCache->hold();
+    run->rides = context->athlete->rideCache->rides();
+
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, SIGNAL(finished()), this, SLOT(metricsPrepared()));
+    runs.insert(watcher, run);
+    preparing = run;
+    watcher->setFuture(QtConcurrent::run(this, &LTMPlot::createMetricsData, context, &run->settings, jobs, false,
+                                         static_cast<const LTMPreparing*>(run)));
+}
+
+void
+LTMPlot::metricsPrepared()
+{
+    QFutureWatcher<void> *watcher = static_cast<QFutureWatcher<void>*>(sender());
+    LTMPreparing *run = runs.take(watcher);
+    watcher->deleteLater();
+
+    // done with the rides, superseded or not
+    if (run) context->athlete->rideCache->release();
+
+    // ignore those superseded by a later setData
+    if (run && run == preparing) {
+        preparing = NULL;
+        plotData(run->data);
+        emit plotted();
+    }
+    delete run;
+}
+
+void
+LTMPlot::plotData(const QVector<LTMCurveData> &prepared)
+{
+    QTime timer;
+    timer.start();
+
+    curveColors->isolated = false;
+    isolation = false;
+    int user=0;
+
+    bool haveBanister=false; // do we want to show the banister helper?
+
+    //qDebug()<<"Starting.."<<timer.elapsed();
+
     //setTitle(settings->title);
     if (settings->groupBy != LTM_TOD)
         setAxisTitle(xBottom, tr("Date"));
@@ -379,7 +462,9 @@ LTMPlot::setData(LTMSettings *set)
 
     int r=0;
 
-    foreach (MetricDetail metricDetail, settings->metrics) {
+    for (int m=0; m<settings->metrics.count(); m++) {
+
+        MetricDetail metricDetail = settings->metrics[m];
 
         // if we have at least one banister curve visible then helper is relevant
         if (metricDetail.hidden == false && metricDetail.type == METRIC_BANISTER) haveBanister=true;
@@ -393,7 +478,11 @@ LTMPlot::setData(LTMSettings *set)
             stackY.append(ydata);
 
             int count;
-            if (settings->groupBy != LTM_TOD)
+            if (m < prepared.count() && prepared[m].pending) {
+                *xdata = prepared[m].x;
+                *ydata = prepared[m].y;
+                count = prepared[m].count;
+            } else if (settings->groupBy != LTM_TOD)
                 createCurveData(context, settings, metricDetail, *xdata, *ydata, count);
             else
                 createTODCurveData(context, settings, metricDetail, *xdata, *ydata, count);
@@ -596,7 +685,11 @@ LTMPlot::setData(LTMSettings *set)
         QVector<double> xdata, ydata;
 
         int count;
-        if (settings->groupBy != LTM_TOD)
+        if (m < prepared.count() && prepared[m].pending) {
+            xdata = prepared[m].x;
+            ydata = prepared[m].y;
+            count = prepared[m].count;
+        } else if (settings->groupBy != LTM_TOD)
             createCurveData(context, settings, metricDetail, xdata, ydata, count);
         else
             createTODCurveData(context, settings, metricDetail, xdata, ydata, count);
@@ -2646,155 +2739,218 @@ void
 LTMPlot::createMetricData(Context *context, LTMSettings *settings, MetricDetail metricDetail,
                                               QVector<double>&x,QVector<double>&y,int&n, bool forceZero)
 {
+    LTMCurveData data;
+    LTMCurveJob job;
+    job.metricDetail = metricDetail;
+    job.spec = curveSpecification(context, settings, metricDetail);
+    job.data = &data;
 
-    // resize the curve array to maximum possible size
-    int maxdays = groupForDate(settings->end.date(), settings->groupBy)
-                  - groupForDate(settings->start.date(), settings->groupBy) + 1;
+    createMetricsData(context, settings, QList<LTMCurveJob>() << job, forceZero);
 
-    x.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
-    y.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
-
-    // do we aggregate ?
-    bool aggZero = metricDetail.metric ? metricDetail.metric->aggregateZero() : false;
-    n=-1;
-    int lastDay=0;
-    unsigned long secondsPerGroupBy=0;
-    bool wantZero = forceZero ? 1 : (metricDetail.curveStyle == QwtPlotCurve::Steps);
+    x = data.x;
+    y = data.y;
+    n = data.count;
+}
 
+Specification
+LTMPlot::curveSpecification(Context *context, LTMSettings *settings, MetricDetail metricDetail)
+{
     // curve specific filter
     Specification spec = settings->specification;
     if (!SearchFilterBox::isNull(metricDetail.datafilter))
         spec.addMatches(SearchFilterBox::matches(context, metricDetail.datafilter));
 
-    //
-    double ymean_prev=0.0;
+    return spec;
+}
 
-    foreach (RideItem *ride, context->athlete->rideCache->rides()) { 
+// aggregation state for each curve in createMetricsData
+struct LTMMetricState {
+    int index; // RideMetric::index() for the symbol
+    bool aggZero, wantZero, done;
+    int lastDay;
+    unsigned long secondsPerGroupBy;
+    double ymean_prev;
+};
 
-        // filter out unwanted stuff
-        if (!spec.pass(ride)) continue;
+void
+LTMPlot::createMetricsData(Context *context, LTMSettings *settings, QList<LTMCurveJob> jobs, bool forceZero, const LTMPreparing *run)
+{
+    // NOTE: this is called from a worker thread by setData, so it must only
+    //       read the rides it was given and never touch the plot or shared metrics
+    const QVector<RideItem*> &rides = run ? run->rides : context->athlete->rideCache->rides();
+    const QAtomicInt *cancelled = run ? &run->cancelled : NULL;
+
+    // resize the curve array to maximum possible size
+    int startGroup = groupForDate(settings->start.date(), settings->groupBy);
+    int maxdays = groupForDate(settings->end.date(), settings->groupBy) - startGroup + 1;
+
+    foreach(LTMCurveJob job, jobs) job.data->count = -1;
+    if (maxdays <= 0) return;
+
+    QVector<LTMMetricState> state(jobs.count());
+    for (int i=0; i<jobs.count(); i++) {
+
+        const MetricDetail &metricDetail = jobs[i].metricDetail;
+        LTMCurveData *data = jobs[i].data;
+
+        data->x.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
+        data->y.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
+
+        // do we aggregate ?
+        state[i].aggZero = metricDetail.metric ? metricDetail.metric->aggregateZero() : false;
+        state[i].wantZero = forceZero ? 1 : (metricDetail.curveStyle == QwtPlotCurve::Steps);
+        state[i].index = RideMetricFactory::instance().metricIndex(metricDetail.symbol);
+        state[i].done = false;
+        state[i].lastDay = 0;
+        state[i].secondsPerGroupBy = 0;
+        state[i].ymean_prev = 0.0;
+    }
+    int remaining = jobs.count();
+
+    foreach (RideItem *ride, rides) {
+
+        // all curves filled, or nobody wants them any more
+        if (remaining == 0 || (cancelled && cancelled->load())) break;
 
         // day we are on
         int currentDay = groupForDate(ride->dateTime.date(), settings->groupBy);
 
-        // value for day
-        double value;
-        if (metricDetail.type == METRIC_META)
-            value = ride->getText(metricDetail.name, "0.0").toDouble();
-        else
-            value = ride->getForSymbol(metricDetail.symbol);
+        for (int i=0; i<jobs.count(); i++) {
 
-        // check values are bounded to stop QWT going berserk
-        if (std::isnan(value) || std::isinf(value)) value = 0;
+            if (state[i].done) continue;
 
-        // skip unavailable values
-        if (value == RideFile::NA) continue;
+            const MetricDetail &metricDetail = jobs[i].metricDetail;
+            QVector<double> &x = jobs[i].data->x;
+            QVector<double> &y = jobs[i].data->y;
+            int &n = jobs[i].data->count;
+            LTMMetricState &s = state[i];
 
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metricDetail.metric && metricDetail.metric->symbol() == "average_temp" && value == RideFile::NA) {
-            value = 0;
-            aggZero = false;
-        }
+            // filter out unwanted stuff
+            if (!jobs[i].spec.pass(ride)) continue;
 
-        if (metricDetail.metric) {
-            // convert from stored metric value to imperial
-            if (context->athlete->useMetricUnits == false) {
-                value *= metricDetail.metric->conversion();
-                value += metricDetail.metric->conversionSum();
+            // value for day
+            double value;
+            if (metricDetail.type == METRIC_META)
+                value = ride->getText(metricDetail.name, "0.0").toDouble();
+            else
+                value = ride->getForMetric(s.index);
+
+            // check values are bounded to stop QWT going berserk
+            if (std::isnan(value) || std::isinf(value)) value = 0;
+
+            // skip unavailable values
+            if (value == RideFile::NA) continue;
+
+            // set aggZero to false and value to zero if is temperature and -255
+            if (metricDetail.metric && metricDetail.metric->symbol() == "average_temp" && value == RideFile::NA) {
+                value = 0;
+                s.aggZero = false;
             }
 
-            // convert seconds to hours
-            if (metricDetail.metric->units(true) == "seconds" ||
-                metricDetail.metric->units(true) == tr("seconds")) value /= 3600;
-        }
+            if (metricDetail.metric) {
+                // convert from stored metric value to imperial
+                if (context->athlete->useMetricUnits == false) {
+                    value *= metricDetail.metric->conversion();
+                    value += metricDetail.metric->conversionSum();
+                }
 
-        if (value || wantZero) {
-            unsigned long seconds = metricDetail.metric ? ride->getCountForSymbol(metricDetail.metric->symbol()) : 1;
-            if (currentDay > lastDay) {
-                if (lastDay && wantZero) {
-                    while (lastDay<currentDay && n<=maxdays) {
-                        lastDay++;
+                // convert seconds to hours
+                if (metricDetail.metric->units(true) == "seconds" ||
+                    metricDetail.metric->units(true) == tr("seconds")) value /= 3600;
+            }
+
+            if (value || s.wantZero) {
+                unsigned long seconds = metricDetail.metric ? ride->getCountForMetric(metricDetail.metric->index()) : 1;
+                if (currentDay > s.lastDay) {
+                    if (s.lastDay && s.wantZero) {
+                        while (s.lastDay<currentDay && n<=maxdays) {
+                            s.lastDay++;
+                            n++;
+                            x[n]=s.lastDay - startGroup;
+                            y[n]=0;
+                        }
+                    } else {
                         n++;
-                        x[n]=lastDay - groupForDate(settings->start.date(), settings->groupBy);
-                        y[n]=0;
                     }
-                } else {
-                    n++;
-                }
 
-                // drop out of roange
-                if (n>maxdays) break;
-                // first time thru
-                if (n<0) n=0;
+                    // drop out of roange
+                    if (n>maxdays) {
+                        s.done = true;
+                        remaining--;
+                        continue;
+                    }
+                    // first time thru
+                    if (n<0) n=0;
 
-                ymean_prev = ride->getStdMeanForSymbol(metricDetail.symbol);
+                    s.ymean_prev = ride->getStdMeanForMetric(s.index);
 
-                y[n] = value;
-                x[n] = currentDay - groupForDate(settings->start.date(), settings->groupBy);
+                    y[n] = value;
+                    x[n] = currentDay - startGroup;
 
-                // only increment counter if nonzero or we aggregate zeroes
-                if (value || aggZero) secondsPerGroupBy = seconds; 
+                    // only increment counter if nonzero or we aggregate zeroes
+                    if (value || s.aggZero) s.secondsPerGroupBy = seconds;
 
-            } else {
-                // sum totals, average averages and choose best for Peaks
-                int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
+                } else {
+                    // sum totals, average averages and choose best for Peaks
+                    int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
 
-                if (metricDetail.uunits == "Ramp" ||
-                    metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
+                    if (metricDetail.uunits == "Ramp" ||
+                        metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
 
-                if (metricDetail.type == METRIC_BEST) type = RideMetric::Peak;
+                    if (metricDetail.type == METRIC_BEST) type = RideMetric::Peak;
 
-                // first time thru
-                if (n<0) n=0;
+                    // first time thru
+                    if (n<0) n=0;
 
-                switch (type) {
-                case RideMetric::Total:
-                    y[n] += value;
-                    break;
-                case RideMetric::Average:
-                    {
-                    // average should be calculated taking into account
-                    // the duration of the ride, otherwise high value but
-                    // short rides will skew the overall average
-                    if (value || aggZero) y[n] = ((y[n]*secondsPerGroupBy)+(seconds*value)) / (secondsPerGroupBy+seconds);
-                    break;
-                    }
-                case RideMetric::Low:
-                    if (value < y[n]) y[n] = value;
-                    break;
-                case RideMetric::Peak:
-                    if (value > y[n]) y[n] = value;
-                    break;
-                case RideMetric::MeanSquareRoot:
-                    if (value) y[n] = sqrt((pow(y[n],2)*secondsPerGroupBy + pow(value,2)*seconds)/(secondsPerGroupBy+seconds));
-                    break;
-                case RideMetric::StdDev:
-                    if (value)
+                    switch (type) {
+                    case RideMetric::Total:
+                        y[n] += value;
+                        break;
+                    case RideMetric::Average:
                         {
-                            double ymean_next = ride->getStdMeanForSymbol(metricDetail.symbol);
-                            double ymean =  (secondsPerGroupBy*ymean_prev + ymean_next*seconds)/(secondsPerGroupBy + seconds);
-
-                            // Combining two standard deviations using
-                            // the formula:
-                            //
-                            //   sqrt(((n1-1)*S1^2+(n2-1)*S2^2+n1*(ymean_1-ymean)^2+n2*(ymean_2-ymean)^2)/(n1+n2))
-                            //
-                            // where:
-                            //
-                            //   ymean = (n1*ymean_1 + n2*ymean_2)/(n1+n2)
-
-                            y[n] = pow(y[n],2)*(secondsPerGroupBy-1) + pow(value,2)*(seconds-1);
-                            y[n] += pow(ymean_prev - ymean,2)*secondsPerGroupBy + pow(ymean_next - ymean,2)*seconds;
-                            y[n] /= (secondsPerGroupBy + seconds);
-                            y[n] = sqrt(y[n]);
-
-                            ymean_prev = ymean;
+                        // average should be calculated taking into account
+                        // the duration of the ride, otherwise high value but
+                        // short rides will skew the overall average
+                        if (value || s.aggZero) y[n] = ((y[n]*s.secondsPerGroupBy)+(seconds*value)) / (s.secondsPerGroupBy+seconds);
+                        break;
                         }
-                    break;
+                    case RideMetric::Low:
+                        if (value < y[n]) y[n] = value;
+                        break;
+                    case RideMetric::Peak:
+                        if (value > y[n]) y[n] = value;
+                        break;
+                    case RideMetric::MeanSquareRoot:
+                        if (value) y[n] = sqrt((pow(y[n],2)*s.secondsPerGroupBy + pow(value,2)*seconds)/(s.secondsPerGroupBy+seconds));
+                        break;
+                    case RideMetric::StdDev:
+                        if (value)
+                            {
+                                double ymean_next = ride->getStdMeanForMetric(s.index);
+                                double ymean =  (s.secondsPerGroupBy*s.ymean_prev + ymean_next*seconds)/(s.secondsPerGroupBy + seconds);
+
+                                // Combining two standard deviations using
+                                // the formula:
+                                //
+                                //   sqrt(((n1-1)*S1^2+(n2-1)*S2^2+n1*(ymean_1-ymean)^2+n2*(ymean_2-ymean)^2)/(n1+n2))
+                                //
+                                // where:
+                                //
+                                //   ymean = (n1*ymean_1 + n2*ymean_2)/(n1+n2)
+
+                                y[n] = pow(y[n],2)*(s.secondsPerGroupBy-1) + pow(value,2)*(seconds-1);
+                                y[n] += pow(s.ymean_prev - ymean,2)*s.secondsPerGroupBy + pow(ymean_next - ymean,2)*seconds;
+                                y[n] /= (s.secondsPerGroupBy + seconds);
+                                y[n] = sqrt(y[n]);
+
+                                s.ymean_prev = ymean;
+                            }
+                        break;
+                    }
+                    s.secondsPerGroupBy += seconds; // increment for same group
                 }
-                secondsPerGroupBy += seconds; // increment for same group
+                s.lastDay = currentDay;
             }
-            lastDay = currentDay;
         }
     }
 }
@@ -2814,6 +2970,7 @@ LTMPlot::createFormulaData(Context *context, LTMSettings *settings, MetricDetail
 
     // parse formula
     DataFilter parser(this, context, metricDetail.formula);
+    int workoutTime = RideMetricFactory::instance().metricIndex("workout_time");
 
     // do we aggregate ?
     bool aggZero = false;
@@ -2854,7 +3011,7 @@ LTMPlot::createFormulaData(Context *context, LTMSettings *settings, MetricDetail
             metricDetail.uunits == tr("seconds")) value /= 3600;
 
         if (value || wantZero) {
-            unsigned long seconds = ride->getForSymbol("workout_time");
+            unsigned long seconds = ride->getForMetric(workoutTime);
             if (currentDay > lastDay) {
                 if (lastDay && wantZero) {
                     while (lastDay<currentDay && n<=maxdays) {
@@ -36,7 +36,11 @@
 
 #include "Context.h"
 
+#include <QFutureWatcher>
+#include <QAtomicInt>
+
 class LTMPlotBackground;
+class RideItem;
 class LTMWindow;
 class LTMPlotZoneLabel;
 class LTMScaleDraw;
@@ -44,6 +48,36 @@ class CompareScaleDraw;
 class StressCalculator;
 class LTMToolTip;
 
+// curve data built ahead of plotting, possibly on a worker thread
+class LTMCurveData
+{
+    public:
+        LTMCurveData() : count(-1), pending(false) {}
+
+        QVector<double> x, y;
+        int count;
+        bool pending; // being prepared by createMetricsData
+};
+
+// a curve to build during a shared pass over the rides
+class LTMCurveJob
+{
+    public:
+        MetricDetail metricDetail;
+        Specification spec;
+        LTMCurveData *data;
+};
+
+// the metric curves for a call to setData, prepared in the background
+class LTMPreparing
+{
+    public:
+        LTMSettings settings;       // a copy, the original may change whilst we run
+        QVector<LTMCurveData> data; // one for each of settings.metrics
+        QVector<RideItem*> rides;   // taken on the gui thread, held until we finish
+        QAtomicInt cancelled;       // superseded by a later setData
+};
+
 class LTMPlot : public QwtPlot
 {
     Q_OBJECT
@@ -53,6 +87,8 @@ class LTMPlot : public QwtPlot
     public:
         LTMPlot(LTMWindow *, Context *context, int postition=0); // position in a stack
         ~LTMPlot();
+        // metric curves are prepared in the background so the
+        // plot is only updated later, when plotted() is emitted
         void setData(LTMSettings *);
         void setCompareData(LTMSettings *);
         void setAxisTitle(QwtAxisId axis, QString label);
@@ -65,6 +101,12 @@ class LTMPlot : public QwtPlot
         bool eventFilter(QObject *, QEvent *);
         virtual void replot();
 
+        // background preparation of metric curves completed
+        void metricsPrepared();
+
+    signals:
+        void plotted();
+
     protected:
         friend class ::LTMPlotBackground;
         friend class ::LTMPlotZoneLabel;
@@ -131,6 +173,17 @@ class LTMPlot : public QwtPlot
         void createMetricData(Context *,LTMSettings *, MetricDetail, QVector<double>&, QVector<double>&, int&, bool=false);
         void createFormulaData(Context *,LTMSettings *, MetricDetail, QVector<double>&, QVector<double>&, int&, bool=false);
 
+        // create curve data for several metric/metadata curves in a single pass over the rides
+        // this is thread-safe so setData() runs it in the background on the rides in run, it
+        // stops early if the run is cancelled. Without a run it reads the ride cache directly
+        void createMetricsData(Context *, LTMSettings *, QList<LTMCurveJob>, bool=false, const LTMPreparing *run=NULL);
+
+        // the rest of setData once the metric curves are ready
+        void plotData(const QVector<LTMCurveData> &prepared);
+        QHash<QFutureWatcher<void>*, LTMPreparing*> runs; // still running, some superseded
+        LTMPreparing *preparing; // the one to plot
+        Specification curveSpecification(Context *, LTMSettings *, MetricDetail);
+
         // create curve data from bests (from ridefile cache)
         void createBestsData(Context *,LTMSettings *, MetricDetail, QVector<double>&, QVector<double>&, int&, bool=false);
 
@@ -152,8 +152,7 @@ LTMPopup::setData(Specification spec, const RideMetric *metric, QString title)
 
         // metrics
         double d = item->getForSymbol(metric->symbol());
-        const_cast<RideMetric *>(metric)->setValue(d);
-        QString value = metric->toString(context->athlete->useMetricUnits);
+        QString value = metric->toString(context->athlete->useMetricUnits, d);
 
         h = new QTableWidgetItem(value,QTableWidgetItem::Type);
         h->setFlags(t->flags() & (~Qt::ItemIsEditable));
@@ -453,10 +452,7 @@ LTMPopup::setSummaryHTML(RideItem *item)
         // use getAggregate even if it's only 1 file to have consistent value treatment
         double d = item->getForSymbol(metricname, true);
         QString value;
-        if (metric) {
-            const_cast<RideMetric*>(metric)->setValue(d);
-            value = metric->toString(context->athlete->useMetricUnits);
-        }
+        if (metric) value = metric->toString(context->athlete->useMetricUnits, d);
 
         // Maximum Max and Average Average looks nasty, remove from name for display
         QString s = metric ? metric->name().replace(QRegExp(tr("^(Average|Max) ")), "") : "unknown";
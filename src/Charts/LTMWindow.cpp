@@ -353,6 +353,7 @@ LTMWindow::LTMWindow(Context *context) :
     // normal view
     connect(spanSlider, SIGNAL(lowerPositionChanged(int)), this, SLOT(spanSliderChanged()));
     connect(spanSlider, SIGNAL(upperPositionChanged(int)), this, SLOT(spanSliderChanged()));
+    connect(ltmPlot, SIGNAL(plotted()), this, SLOT(ltmPlotted()));
     connect(scrollLeft, SIGNAL(clicked()), this, SLOT(moveLeft()));
     connect(scrollRight, SIGNAL(clicked()), this, SLOT(moveRight()));
 
@@ -738,19 +739,24 @@ LTMWindow::refreshPlot()
 
                 // NORMAL PLOTS
                 plotted = DateRange(settings.start.date(), settings.end.date());
-                ltmPlot->setData(&settings);
+                ltmPlot->setData(&settings); // span slider is reset by ltmPlotted()
                 stackWidget->setCurrentIndex(0);
                 dirty = false;
-
-                spanSlider->setMinimum(ltmPlot->axisScaleDiv(QwtPlot::xBottom).lowerBound());
-                spanSlider->setMaximum(ltmPlot->axisScaleDiv(QwtPlot::xBottom).upperBound());
-                spanSlider->setLowerValue(spanSlider->minimum());
-                spanSlider->setUpperValue(spanSlider->maximum());
             }
         }
     }
 }
 
+void
+LTMWindow::ltmPlotted()
+{
+    // x axis is only known once the plot is complete
+    spanSlider->setMinimum(ltmPlot->axisScaleDiv(QwtPlot::xBottom).lowerBound());
+    spanSlider->setMaximum(ltmPlot->axisScaleDiv(QwtPlot::xBottom).upperBound());
+    spanSlider->setLowerValue(spanSlider->minimum());
+    spanSlider->setUpperValue(spanSlider->maximum());
+}
+
 void
 LTMWindow::refreshCompare()
 {
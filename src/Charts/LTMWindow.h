@@ -231,6 +231,7 @@ class LTMWindow : public GcChartWindow
 
         // user changed the date range
         void spanSliderChanged();
+        void ltmPlotted();
         void moveLeft();
         void moveRight();
 
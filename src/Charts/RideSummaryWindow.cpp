@@ -505,33 +505,6 @@ RideSummaryWindow::htmlSummary()
         << "max_cadence"
         << "skiba_wprime_max";
 
-    // show average and max temp if it is available (in ride summary mode)
-    if ((ridesummary && (ride->areDataPresent()->temp || ride->getTag("Temperature", "-") != "-")) ||
-       (!ridesummary && context->athlete->rideCache->getAggregate("average_temp", specification, true) != "-")) {
-        averageColumn << "average_temp";
-        maximumColumn << "max_temp";
-    }
-
-    // if o2 data is available show the average and max
-    if ((ridesummary && ride->areDataPresent()->smo2) || 
-       (!ridesummary && context->athlete->rideCache->getAggregate("average_smo2", specification, true) != "-")) {
-        averageColumn << "average_smo2";
-        maximumColumn << "max_smo2";
-        averageColumn << "average_tHb";
-        maximumColumn << "max_tHb";
-    }
-
-    // additional metrics for runs & swims
-    if (ridesummary) {
-        if (ride->isRun()) averageColumn << "average_run_cad";
-        if (ride->isRun()) maximumColumn << "max_run_cadence";
-        if (ride->isRun()) averageColumn << "pace";
-        if (ride->isSwim()) averageColumn << "pace_swim";
-    } else {
-        if (nRuns > 0) averageColumn << "pace";
-        if (nSwims > 0) averageColumn << "pace_swim";
-    }
-
     // users determine the metrics to display
     QString s = appsettings->value(this, GC_SETTINGS_SUMMARY_METRICS, GC_SETTINGS_SUMMARY_METRICS_DEFAULT).toString();
     if (s == "") s = GC_SETTINGS_SUMMARY_METRICS_DEFAULT;
@@ -603,6 +576,44 @@ RideSummaryWindow::htmlSummary()
         << "wcptime_in_zone_L3"
         << "wcptime_in_zone_L4";
 
+    // when summarising a date range aggregate everything we might
+    // show in a single pass through the rides
+    QHash<QString, double> aggregates;
+    if (!ridesummary) {
+        QStringList symbols = totalColumn + rtotalColumn + averageColumn + maximumColumn + metricColumn;
+        symbols << "average_temp" << "max_temp" << "average_smo2" << "max_smo2" << "average_tHb" << "max_tHb"
+                << "pace" << "pace_swim";
+        symbols += timeInZones + paceTimeInZones + timeInZonesHR + timeInZonesWBAL + workInZonesWBAL + timeInZonesCPWBAL;
+        aggregates = context->athlete->rideCache->getAggregates(symbols, specification);
+    }
+
+    // show average and max temp if it is available (in ride summary mode)
+    if ((ridesummary && (ride->areDataPresent()->temp || ride->getTag("Temperature", "-") != "-")) ||
+       (!ridesummary && context->athlete->rideCache->formatAggregate("average_temp", aggregates.value("average_temp"), true) != "-")) {
+        averageColumn << "average_temp";
+        maximumColumn << "max_temp";
+    }
+
+    // if o2 data is available show the average and max
+    if ((ridesummary && ride->areDataPresent()->smo2) || 
+       (!ridesummary && context->athlete->rideCache->formatAggregate("average_smo2", aggregates.value("average_smo2"), true) != "-")) {
+        averageColumn << "average_smo2";
+        maximumColumn << "max_smo2";
+        averageColumn << "average_tHb";
+        maximumColumn << "max_tHb";
+    }
+
+    // additional metrics for runs & swims
+    if (ridesummary) {
+        if (ride->isRun()) averageColumn << "average_run_cad";
+        if (ride->isRun()) maximumColumn << "max_run_cadence";
+        if (ride->isRun()) averageColumn << "pace";
+        if (ride->isSwim()) averageColumn << "pace_swim";
+    } else {
+        if (nRuns > 0) averageColumn << "pace";
+        if (nSwims > 0) averageColumn << "pace_swim";
+    }
+
     // Use pre-computed and saved metric values if the ride has not
     // been edited. Otherwise we need to re-compute every time.
     // this is only for ride summary, when showing for a date range
@@ -775,7 +786,7 @@ RideSummaryWindow::htmlSummary()
 
                  // get the value - from metrics or from data array
                  if (ridesummary) s = s.arg(time_to_string(rideItem->getForSymbol(symbol)));
-                 else s = s.arg(context->athlete->rideCache->getAggregate(symbol, specification, useMetricUnits));
+                 else s = s.arg(context->athlete->rideCache->formatAggregate(symbol, aggregates.value(symbol), useMetricUnits));
 
              } else {
                  if (m->units(useMetricUnits) != "") s = s.arg(" (" + m->units(useMetricUnits) + ")");
@@ -801,7 +812,7 @@ RideSummaryWindow::htmlSummary()
                             }
                             s = s.arg(v);
         
-                    } else s = s.arg(context->athlete->rideCache->getAggregate(symbol, specification, useMetricUnits));
+                    } else s = s.arg(context->athlete->rideCache->formatAggregate(symbol, aggregates.value(symbol), useMetricUnits));
                  }
             }
 
@@ -952,7 +963,7 @@ RideSummaryWindow::htmlSummary()
                 if (ridesummary) {
                     time_in_zone[i] = rideItem->getForSymbol(paceTimeInZones[i]);
                 } else {
-                    time_in_zone[i] = context->athlete->rideCache->getAggregate(paceTimeInZones[i], specification, useMetricUnits, true).toDouble();
+                    time_in_zone[i] = aggregates.value(paceTimeInZones[i]);
                 }
             }
 
@@ -1003,7 +1014,7 @@ RideSummaryWindow::htmlSummary()
 
                 // if using metrics or data
                 if (ridesummary) time_in_zone[i] = rideItem->getForSymbol(timeInZones[i]);
-                else time_in_zone[i] = context->athlete->rideCache->getAggregate(timeInZones[i], specification, useMetricUnits, true).toDouble();
+                else time_in_zone[i] = aggregates.value(timeInZones[i]);
             }
             summary += tr("<h3>Power Zones</h3>");
 
@@ -1023,9 +1034,9 @@ RideSummaryWindow::htmlSummary()
                     wwork_in_zone[i] = rideItem->getForSymbol(workInZonesWBAL[i]);
 
                 } else {
-                    wtime_in_zone[i] = context->athlete->rideCache->getAggregate(timeInZonesWBAL[i], specification, useMetricUnits, true).toDouble();
-                    wwork_in_zone[i] = context->athlete->rideCache->getAggregate(workInZonesWBAL[i], specification, useMetricUnits, true).toDouble();
-                    wcptime_in_zone[i] = context->athlete->rideCache->getAggregate(timeInZonesCPWBAL[i], specification, useMetricUnits, true).toDouble();
+                    wtime_in_zone[i] = aggregates.value(timeInZonesWBAL[i]);
+                    wwork_in_zone[i] = aggregates.value(workInZonesWBAL[i]);
+                    wcptime_in_zone[i] = aggregates.value(timeInZonesCPWBAL[i]);
                 }
             }
             summary += tr("<h3>W'bal Zones</h3>");
@@ -1065,7 +1076,7 @@ RideSummaryWindow::htmlSummary()
             for (int i = 0; i < numhrzones; ++i) {
                 // if using metrics or data
                 if (ridesummary) time_in_zone[i] = rideItem->getForSymbol(timeInZonesHR[i]);
-                else time_in_zone[i] = context->athlete->rideCache->getAggregate(timeInZonesHR[i], specification, useMetricUnits, true).toDouble();
+                else time_in_zone[i] = aggregates.value(timeInZonesHR[i]);
             }
 
             summary += tr("<h3>Heart Rate Zones</h3>");
@@ -2108,6 +2119,18 @@ RideSummaryWindow::htmlCompareSummary() const
 
     } else { // DATE RANGE COMPARE
 
+        // aggregate everything we might show for each date range, one pass
+        // through the rides for each, the first is needed for the deltas
+        QStringList symbols = totalColumn + metricColumn + averageColumn + maximumColumn;
+        symbols += timeInZones + paceTimeInZones + timeInZonesHR + timeInZonesWBAL;
+        QList<QHash<QString, double> > aggregates;
+        foreach (CompareDateRange dr, context->compareDateRanges) {
+            if (dr.isChecked() || aggregates.isEmpty())
+                aggregates << dr.context->athlete->rideCache->getAggregates(symbols, dr.specification);
+            else
+                aggregates << QHash<QString, double>();
+        }
+
         // LETS FORMAT THE HTML
         summary = GCColor::css(ridesummary);
         summary += "<center>";
@@ -2176,9 +2199,11 @@ RideSummaryWindow::htmlCompareSummary() const
 
             // then one row for each interval
             int counter = 0;
+            int index = -1;
             foreach (CompareDateRange dr, context->compareDateRanges) {
 
                 // skip if not checked
+                index++; // position in compareDateRanges
                 if (!dr.isChecked()) continue;
 
                 // alternating shading
@@ -2194,8 +2219,7 @@ RideSummaryWindow::htmlCompareSummary() const
                     const RideMetric *m = factory.rideMetric(symbol);
 
                     // get value and convert if needed (use local context for units)
-                    double value = dr.context->athlete->rideCache->getAggregate(symbol, dr.specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
+                    double value = m->value(aggregates[index].value(symbol), context->athlete->useMetricUnits);
 
                     // use right precision
                     QString strValue = QString("%1").arg(value, 0, 'f', m->precision());
@@ -2210,9 +2234,7 @@ RideSummaryWindow::htmlCompareSummary() const
                     if (counter) {
 
                         // calculate me vs the original
-                        double value0 = context->compareDateRanges[0].context->athlete->rideCache->getAggregate(symbol,
-                                                                                 context->compareDateRanges[0].specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
+                        double value0 = m->value(aggregates[0].value(symbol), context->athlete->useMetricUnits);
 
                         value -= value0; // delta
 
@@ -2279,9 +2301,11 @@ RideSummaryWindow::htmlCompareSummary() const
 
                 // now the summary
                 int counter = 0;
+                int index = -1;
                 foreach (CompareDateRange dr, context->compareDateRanges) {
 
                     // skip if not checked
+                    index++; // position in compareDateRanges
                     if (!dr.isChecked()) continue;
 
                     if (counter%2) summary += "<tr bgcolor='" + altColor.name() + "'>";
@@ -2293,12 +2317,8 @@ RideSummaryWindow::htmlCompareSummary() const
                     int idx=0;
                     foreach (ZoneInfo zone, zones) {
 
-                        int timeZone = dr.context->athlete->rideCache->getAggregate(timeInZones[idx], dr.specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
-
-                        int dt = timeZone - context->compareDateRanges[0].context->athlete->rideCache->getAggregate(timeInZones[idx],
-                                                                        context->compareDateRanges[0].specification,
-                                                                        context->athlete->useMetricUnits, true).toDouble();
+                        int timeZone = aggregates[index].value(timeInZones[idx]);
+                        int dt = timeZone - aggregates[0].value(timeInZones[idx]);
 
                         idx++;
 
@@ -2336,9 +2356,11 @@ RideSummaryWindow::htmlCompareSummary() const
 
                 // now the summary
                 counter = 0;
+                index = -1;
                 foreach (CompareDateRange dr, context->compareDateRanges) {
 
                     // skip if not checked
+                    index++; // position in compareDateRanges
                     if (!dr.isChecked()) continue;
 
                     if (counter%2) summary += "<tr bgcolor='" + altColor.name() + "'>";
@@ -2361,12 +2383,8 @@ RideSummaryWindow::htmlCompareSummary() const
 #endif // See bug #1305
 
                         // all W'bal time in zone
-                        int timeZone = dr.context->athlete->rideCache->getAggregate(timeInZonesWBAL[idx], dr.specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
-
-                        int dt = timeZone - context->compareDateRanges[0].context->athlete->rideCache->getAggregate(timeInZonesWBAL[idx],
-                                                                        context->compareDateRanges[0].specification,
-                                                                        context->athlete->useMetricUnits, true).toDouble();
+                        int timeZone = aggregates[index].value(timeInZonesWBAL[idx]);
+                        int dt = timeZone - aggregates[0].value(timeInZonesWBAL[idx]);
 
                         idx++;
 
@@ -2420,9 +2438,11 @@ RideSummaryWindow::htmlCompareSummary() const
 
                 // now the summary
                 int counter = 0;
+                int index = -1;
                 foreach (CompareDateRange dr, context->compareDateRanges) {
 
                     // skip if not checked
+                    index++; // position in compareDateRanges
                     if (!dr.isChecked()) continue;
 
                     if (counter%2) summary += "<tr bgcolor='" + altColor.name() + "'>";
@@ -2434,12 +2454,8 @@ RideSummaryWindow::htmlCompareSummary() const
                     int idx=0;
                     foreach (HrZoneInfo zone, zones) {
 
-                        int timeZone = dr.context->athlete->rideCache->getAggregate(timeInZonesHR[idx], dr.specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
-
-                        int dt = timeZone - context->compareDateRanges[0].context->athlete->rideCache->getAggregate(timeInZonesHR[idx],
-                                                                        context->compareDateRanges[0].specification,
-                                                                        context->athlete->useMetricUnits, true).toDouble();
+                        int timeZone = aggregates[index].value(timeInZonesHR[idx]);
+                        int dt = timeZone - aggregates[0].value(timeInZonesHR[idx]);
                         idx++;
 
                         // time and then +time
@@ -2493,9 +2509,11 @@ RideSummaryWindow::htmlCompareSummary() const
 
                 // now the summary
                 int counter = 0;
+                int index = -1;
                 foreach (CompareDateRange dr, context->compareDateRanges) {
 
                     // skip if not checked
+                    index++; // position in compareDateRanges
                     if (!dr.isChecked()) continue;
 
                     if (counter%2) summary += "<tr bgcolor='" + altColor.name() + "'>";
@@ -2507,12 +2525,8 @@ RideSummaryWindow::htmlCompareSummary() const
                     int idx=0;
                     foreach (PaceZoneInfo zone, zones) {
 
-                        int timeZone = dr.context->athlete->rideCache->getAggregate(paceTimeInZones[idx], dr.specification,
-                                                                                 context->athlete->useMetricUnits, true).toDouble();
-
-                        int dt = timeZone - context->compareDateRanges[0].context->athlete->rideCache->getAggregate(paceTimeInZones[idx],
-                                                                        context->compareDateRanges[0].specification,
-                                                                        context->athlete->useMetricUnits, true).toDouble();
+                        int timeZone = aggregates[index].value(paceTimeInZones[idx]);
+                        int dt = timeZone - aggregates[0].value(paceTimeInZones[idx]);
 
                         idx++;
 
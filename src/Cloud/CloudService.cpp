@@ -32,6 +32,8 @@
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QDesktopWidget>
+#include <QTemporaryDir>
+#include <QtConcurrent>
 
 #include "../qzip/zipwriter.h"
 #include "../qzip/zipreader.h"
@@ -268,8 +270,10 @@ CloudService::uncompressRide(QByteArray *data, QString name, QStringList &errors
         jsonData = *data;
     }
 
-    // uncompress and write to tmp preserviing the file extension
-    QString tmp = context->athlete->home->temp().absolutePath() + "/" + QFileInfo(name).baseName() + "." + QFileInfo(name).suffix();
+    // uncompress and write to tmp preserviing the file extension, each in
+    // its own directory since downloads may be parsed concurrently
+    QTemporaryDir tmpdir(context->athlete->home->temp().absolutePath() + "/download-XXXXXX");
+    QString tmp = tmpdir.path() + "/" + QFileInfo(name).baseName() + "." + QFileInfo(name).suffix();
 
     // uncompress and write a file
     QFile file(tmp);
@@ -692,7 +696,8 @@ FolderNameDialog::FolderNameDialog(QWidget *parent) : QDialog(parent)
 }
 
 CloudServiceSyncDialog::CloudServiceSyncDialog(Context *context, CloudService *store)
-    : QDialog(context->mainWindow, Qt::Dialog), context(context), store(store), downloading(false), aborted(false)
+    : QDialog(context->mainWindow, Qt::Dialog), context(context), store(store), downloading(false), aborted(false),
+      downloader(NULL), uploadsDone(true)
 {
     setWindowTitle(tr("Synchronise ") + store->uiName());
     setMinimumSize(850 *dpiXFactor,450 *dpiYFactor);
@@ -731,8 +736,8 @@ CloudServiceSyncDialog::CloudServiceSyncDialog(Context *context, CloudService *s
     QVBoxLayout *syncLayout = new QVBoxLayout(sync);
 
     // notification when upload/download completes
+    // downloads are collected by the downloader, see newDownloader()
     connect (store, SIGNAL(writeComplete(QString,QString)), this, SLOT(completedWrite(QString,QString)));
-    connect (store, SIGNAL(readComplete(QByteArray*,QString,QString)), this, SLOT(completedRead(QByteArray*,QString,QString)));
 
     // combo box
     athleteCombo = new QComboBox(this);
@@ -1311,6 +1316,16 @@ CloudServiceSyncDialog::downloadClicked()
         downloading=false;
         aborted=true;
         cancelButton->show();
+
+        // drop anything still in the pipeline, it cleans up after itself
+        if (downloader) {
+            downloader->disconnect(this);
+            downloader->abort();
+            downloader = NULL;
+        }
+        foreach(QTreeWidgetItem *curr, downloadRows)
+            curr->setText(sync ? 7 : 5, tr("Aborted"));
+        downloadRows.clear();
         return;
     } else {
         rideListDown->setSortingEnabled(false);
@@ -1355,63 +1370,91 @@ CloudServiceSyncDialog::downloadClicked()
     switch(tabs->currentIndex()) {
         case 0 : downloadNext(); break;
         case 1 : uploadNext(); break;
-        case 2 : sync = true; syncNext(); break;
+        case 2 :
+        {
+            // downloads go through the pipeline whilst we upload
+            sync = true;
+            uploadsDone = false;
+            newDownloader();
+            for (int i=0; i<rideListSync->invisibleRootItem()->childCount(); i++) {
+                QTreeWidgetItem *curr = rideListSync->invisibleRootItem()->child(i);
+                QCheckBox *check = (QCheckBox*)rideListSync->itemWidget(curr, 0);
+
+                if (check->isChecked() && curr->text(6) == tr("Download")) {
+                    curr->setText(7, tr("Downloading"));
+                    downloadRows.insert(i, curr);
+                    downloader->add(curr->text(1), curr->text(8), i);
+                }
+            }
+            downloader->start();
+            syncNext();
+        }
+        break;
     }
 }
 
+void
+CloudServiceSyncDialog::newDownloader()
+{
+    downloadRows.clear();
+    downloader = new CloudServiceDownloader(store, 4, 16, this);
+    connect(downloader, SIGNAL(downloaded(int,RideFile*,QStringList)), this, SLOT(completedRead(int,RideFile*,QStringList)));
+    connect(downloader, SIGNAL(finished()), this, SLOT(downloadsFinished()));
+    connect(downloader, SIGNAL(finished()), downloader, SLOT(deleteLater()));
+}
+
 bool
 CloudServiceSyncDialog::syncNext()
 {
-    // the actual download/upload is kicked off using the uploader / downloader
-    // if in sync mode the completedRead / completedWrite functions
-    // just call completedSync to get the next Sync done
+    // the downloads were all queued when we started, so this just
+    // works through the uploads, completedWrite calls back here to
+    // get the next one done
     for (int i=listindex; i<rideListSync->invisibleRootItem()->childCount(); i++) {
         QTreeWidgetItem *curr = rideListSync->invisibleRootItem()->child(i);
         QCheckBox *check = (QCheckBox*)rideListSync->itemWidget(curr, 0);
 
-        if (check->isChecked()) {
+        if (check->isChecked() && curr->text(6) != tr("Download")) {
 
             listindex = i+1; // start from the next one
 
             progressLabel->setText(QString(tr("Processed %1 of %2")).arg(downloadcounter).arg(downloadtotal));
-            if (curr->text(6) == tr("Download")) {
-                curr->setText(7, tr("Downloading"));
-                rideListSync->setCurrentItem(curr);
-
-                QByteArray *data = new QByteArray;
-                store->readFile(data, curr->text(1), curr->text(8)); // filename
-                QApplication::processEvents();
-
-            } else {
-                curr->setText(7, tr("Uploading"));
-                rideListSync->setCurrentItem(curr);
-
-                // read in the file
-                QStringList errors;
-                QFile file(context->athlete->home->activities().canonicalPath() + "/" + curr->text(1));
-                RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+            curr->setText(7, tr("Uploading"));
+            rideListSync->setCurrentItem(curr);
 
-                if (ride) {
+            // read in the file
+            QStringList errors;
+            QFile file(context->athlete->home->activities().canonicalPath() + "/" + curr->text(1));
+            RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
 
-                    // get a compressed version
-                    QByteArray data;
-                    store->compressRide(ride, data, QFileInfo(curr->text(1)).baseName() + ".json");
+            if (ride) {
 
-                    store->writeFile(data, QFileInfo(curr->text(1)).baseName() + store->uploadExtension(), ride);
-                    QApplication::processEvents();
-                    delete ride; // clean up!
-                    return true;
+                // get a compressed version
+                QByteArray data;
+                store->compressRide(ride, data, QFileInfo(curr->text(1)).baseName() + ".json");
 
-                } else {
-                    curr->setText(7, tr("Parse failure"));
-                    QApplication::processEvents();
-                }
+                store->writeFile(data, QFileInfo(curr->text(1)).baseName() + store->uploadExtension(), ride);
+                QApplication::processEvents();
+                delete ride; // clean up!
+                return true;
 
+            } else {
+                // move on to the next one, nothing will call us back
+                curr->setText(7, tr("Parse failure"));
+                progressBar->setValue(++downloadcounter);
+                QApplication::processEvents();
             }
-            return true;
         }
     }
 
+    // uploads are done, but still waiting for downloads?
+    uploadsDone = true;
+    if (downloader == NULL) syncDone();
+    return false;
+}
+
+void
+CloudServiceSyncDialog::syncDone()
+{
     //
     // Our work is done!
     //
@@ -1434,14 +1477,15 @@ CloudServiceSyncDialog::syncNext()
 
     // save the ride cache, we don't want to lose that if we crash etc.
     context->athlete->rideCache->save();
-
-    return false;
 }
 
 bool
 CloudServiceSyncDialog::downloadNext()
 {
-    for (int i=listindex; i<rideListDown->invisibleRootItem()->childCount(); i++) {
+    // queue up everything selected, the downloader pipelines the transfers
+    // and parsing; results arrive in completedRead as each one finishes
+    newDownloader();
+    for (int i=0; i<rideListDown->invisibleRootItem()->childCount(); i++) {
         QTreeWidgetItem *curr = rideListDown->invisibleRootItem()->child(i);
         QCheckBox *check = (QCheckBox*)rideListDown->itemWidget(curr, 0);
         QCheckBox *exists = (QCheckBox*)rideListDown->itemWidget(curr, 4);
@@ -1454,19 +1498,29 @@ CloudServiceSyncDialog::downloadNext()
         }
 
         if (check->isChecked()) {
-
-            listindex = i+1; // start from the next one
             curr->setText(5, tr("Downloading"));
-            rideListDown->setCurrentItem(curr);
-            progressLabel->setText(QString(tr("Downloaded %1 of %2")).arg(downloadcounter).arg(downloadtotal));
-
-            QByteArray *data = new QByteArray; // gets deleted when read completes
-            store->readFile(data, curr->text(1), curr->text(6));
-            QApplication::processEvents();
-            //delete data;
-            return true;
+            downloadRows.insert(i, curr);
+            downloader->add(curr->text(1), curr->text(6), i);
         }
     }
+    progressLabel->setText(QString(tr("Downloaded %1 of %2")).arg(downloadcounter).arg(downloadtotal));
+
+    bool queued = !downloadRows.isEmpty();
+    downloader->start();
+    return queued;
+}
+
+void
+CloudServiceSyncDialog::downloadsFinished()
+{
+    // it deletes itself
+    downloader = NULL;
+
+    // sync is done when the uploads are too
+    if (sync) {
+        if (uploadsDone) syncDone();
+        return;
+    }
 
     //
     // Our work is done!
@@ -1488,35 +1542,23 @@ CloudServiceSyncDialog::downloadNext()
 
     // save the ride cache, we don't want to lose that if we crash etc.
     context->athlete->rideCache->save();
-
-    return false;
 }
 
 void
-CloudServiceSyncDialog::completedRead(QByteArray *data, QString name, QString /*message*/)
+CloudServiceSyncDialog::completedRead(int row, RideFile *ride, QStringList errors)
 {
-    QTreeWidget *which = sync ? rideListSync : rideListDown;
     int col = sync ? 7 : 5;
 
-    // was abort pressed?
-    if (aborted == true) {
-        QTreeWidgetItem *curr = which->invisibleRootItem()->child(listindex-1);
-        curr->setText(col, tr("Aborted"));
+    // downloaded and parsed by the downloader, we own the ride now
+    QTreeWidgetItem *curr = downloadRows.take(row);
+    if (curr == NULL) {
+        if (ride) delete ride;
         return;
     }
 
-    // uncompress and parse, note the filename is passed and may be
-    // different to what we asked for (sometimes the data is converted
-    // from one file format to another).
-    QStringList errors;
-    RideFile *ride = store->uncompressRide(data, name, errors);
-
-    // was allocated in before calling readfile
-    delete data;
-
     progressBar->setValue(++downloadcounter);
+    progressLabel->setText(QString(sync ? tr("Processed %1 of %2") : tr("Downloaded %1 of %2")).arg(downloadcounter).arg(downloadtotal));
 
-    QTreeWidgetItem *curr = which->invisibleRootItem()->child(listindex-1);
     if (ride) {
         if (saveRide(ride, errors) == true) {
             curr->setText(col, tr("Saved"));
@@ -1530,13 +1572,6 @@ CloudServiceSyncDialog::completedRead(QByteArray *data, QString name, QString /*
     } else {
         curr->setText(col, errors.join(" "));
     }
-
-    QApplication::processEvents();
-
-    if (sync)
-        syncNext();
-    else
-        downloadNext();
 }
 
 bool
@@ -1663,6 +1698,173 @@ CloudServiceSyncDialog::saveRide(RideFile *ride, QStringList &errors)
 }
 
 
+//
+// Pipelined downloader
+//
+CloudServiceDownloader::CloudServiceDownloader(CloudService *store, int maxTransfers, int maxPending, QObject *parent)
+    : QObject(parent), store(store), maxTransfers(qMax(1, maxTransfers)), maxPending(qMax(1, maxPending)),
+      parsing(0), done(0), total(0), running(false), aborted(false), pumping(false)
+{
+    // transfers are mostly waiting on the network, parsing is cpu bound
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    connect(store, SIGNAL(readComplete(QByteArray*,QString,QString)), this, SLOT(readComplete(QByteArray*,QString,QString)));
+}
+
+CloudServiceDownloader::~CloudServiceDownloader()
+{
+    // drain the parsers before we go
+    pool.waitForDone();
+
+    foreach(Job *job, queued) delete job;
+
+    // any transfers still outstanding belong to the service now, it
+    // may still write into the buffer so we can't free it
+    foreach(Job *job, transfers) delete job;
+}
+
+void
+CloudServiceDownloader::add(QString remotename, QString remoteid, int tag)
+{
+    Job *job = new Job;
+    job->tag = tag;
+    job->remotename = remotename;
+    job->remoteid = remoteid;
+    job->data = NULL;
+    job->store = store;
+    job->ride = NULL;
+    job->watcher = NULL;
+
+    queued << job;
+    total++;
+
+    if (running) pump();
+}
+
+void
+CloudServiceDownloader::start()
+{
+    running = true;
+    aborted = false;
+    pump();
+}
+
+void
+CloudServiceDownloader::abort()
+{
+    aborted = true;
+
+    // never started
+    foreach(Job *job, queued) delete job;
+    queued.clear();
+
+    // anything in flight is dropped when it arrives
+    pump();
+}
+
+void
+CloudServiceDownloader::pump()
+{
+    // services may complete a read synchronously, which re-enters here
+    // via complete(), so just let the outer call carry on looping
+    if (pumping) return;
+    pumping = true;
+
+    while (!aborted && queued.count() && transfers.count() < maxTransfers
+           && transfers.count() + parsing < maxPending) {
+
+        Job *job = queued.takeFirst();
+        job->data = new QByteArray;
+
+        // register before we ask, the reply may arrive before readFile returns
+        transfers.insert(job->data, job);
+        if (store->readFile(job->data, job->remotename, job->remoteid) == false) {
+
+            // it was never issued, so nobody else has the buffer
+            if (transfers.remove(job->data)) {
+                delete job->data;
+                job->data = NULL;
+                job->errors << tr("Unable to read %1").arg(job->remotename);
+                complete(job);
+            }
+        }
+    }
+    pumping = false;
+
+    // all done ?
+    if (running && queued.isEmpty() && transfers.isEmpty() && parsing == 0) {
+        running = false;
+        emit finished();
+    }
+}
+
+void
+CloudServiceDownloader::readComplete(QByteArray *data, QString name, QString)
+{
+    // not one of ours
+    Job *job = transfers.value(data, NULL);
+    if (job == NULL) return;
+    transfers.remove(data);
+
+    if (aborted) {
+        delete data;
+        delete job;
+        pump();
+        return;
+    }
+
+    // uncompress and parse on the worker pool
+    job->name = name;
+    job->watcher = new QFutureWatcher<Job*>(this);
+    connect(job->watcher, SIGNAL(finished()), this, SLOT(parsed()));
+    parsing++;
+    job->watcher->setFuture(QtConcurrent::run(&pool, parse, job));
+
+    // room for another transfer
+    pump();
+}
+
+CloudServiceDownloader::Job *
+CloudServiceDownloader::parse(Job *job)
+{
+    // note the filename is passed and may be different to what we asked
+    // for (sometimes the data is converted from one format to another)
+    job->ride = job->store->uncompressRide(job->data, job->name, job->errors);
+
+    delete job->data;
+    job->data = NULL;
+    return job;
+}
+
+void
+CloudServiceDownloader::parsed()
+{
+    QFutureWatcher<Job*> *watcher = static_cast<QFutureWatcher<Job*>*>(sender());
+    Job *job = watcher->result();
+    watcher->deleteLater();
+    job->watcher = NULL;
+    parsing--;
+
+    if (aborted) {
+        if (job->ride) delete job->ride;
+        delete job;
+        pump();
+        return;
+    }
+
+    complete(job);
+    pump();
+}
+
+void
+CloudServiceDownloader::complete(Job *job)
+{
+    done++;
+    emit downloaded(job->tag, job->ride, job->errors);
+    emit progress(done, total);
+    delete job;
+}
+
 //
 // Upgrade settings now we have migrated to a cloud service factory
 // and notion of setting up "accounts" etc
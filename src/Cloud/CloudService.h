@@ -36,6 +36,8 @@
 #include <QPushButton>
 #include <QProgressBar>
 #include <QPropertyAnimation>
+#include <QThreadPool>
+#include <QFutureWatcher>
 
 #include "Context.h"
 #include "Athlete.h"
@@ -50,6 +52,7 @@
 
 class RideItem;
 class CloudServiceEntry;
+class CloudServiceDownloader;
 
 // Representing an Athlete when the service allows for
 // a coach or manager relationship -- i.e. it lists athletes
@@ -336,8 +339,9 @@ class CloudServiceSyncDialog : public QDialog
         void selectAllUpChanged(int);
         void selectAllSyncChanged(int);
 
-        void completedRead(QByteArray *data, QString name, QString message);
+        void completedRead(int row, RideFile *ride, QStringList errors);
         void completedWrite(QString name,QString message);
+        void downloadsFinished();
     private:
         Context *context;
         CloudService *store;
@@ -347,6 +351,13 @@ class CloudServiceSyncDialog : public QDialog
         bool sync;
         bool aborted;
 
+        // downloads run through a pipeline, uploads one at a time
+        CloudServiceDownloader *downloader;
+        QHash<int, QTreeWidgetItem*> downloadRows;
+        bool uploadsDone;
+        void newDownloader();
+        void syncDone();            // sync finished, downloads and uploads
+
         // Quick lists for checking if file exists
         // locally (rideFiles) or remotely (uploadFiles)
         QStringList rideFiles;
@@ -359,10 +370,10 @@ class CloudServiceSyncDialog : public QDialog
             listindex;          // where in rideList we've got to
 
         bool saveRide(RideFile *, QStringList &);
-        bool syncNext();        // kick off another download/upload
-                                // returns false if none left
-        bool downloadNext();    // kick off another download
-                                // returns false if none left
+        bool syncNext();        // kick off another upload, downloads are
+                                // queued up front. returns false if none left
+        bool downloadNext();    // queue up all the downloads
+                                // returns false if none to do
         bool uploadNext();     // kick off another upload
                                 // returns false if none left
 
@@ -482,6 +493,70 @@ class CloudServiceAutoDownload : public QThread {
         QList<CloudService*> providers;
 };
 
+// Downloads a batch of activities from a service as a pipeline; up to
+// maxTransfers reads are in flight at once while completed transfers are
+// uncompressed and parsed via RideFileFactory on a separate worker pool.
+// No more than maxPending activities are held between the two stages, so a
+// fast store can't run ahead of a slow parser and fill up memory.
+//
+// Results are delivered on the gui thread in completion order, the tag
+// passed to add() identifies them and the receiver owns the RideFile.
+class CloudServiceDownloader : public QObject {
+
+    Q_OBJECT
+
+    public:
+
+        CloudServiceDownloader(CloudService *store, int maxTransfers=4, int maxPending=16, QObject *parent=NULL);
+        ~CloudServiceDownloader();
+
+        // queue up then start, more can be added whilst running
+        void add(QString remotename, QString remoteid, int tag);
+        void start();
+
+        // stop issuing requests, anything outstanding is dropped as it arrives
+        void abort();
+
+        bool isRunning() const { return running; }
+
+    signals:
+
+        void downloaded(int tag, RideFile *ride, QStringList errors);
+        void progress(int done, int total);
+        void finished();
+
+    private slots:
+
+        void readComplete(QByteArray *data, QString name, QString message);
+        void parsed();
+
+    private:
+
+        struct Job {
+            int tag;
+            QString remotename, remoteid;
+            QByteArray *data;
+            CloudService *store;
+            QString name;           // may differ from remotename
+            RideFile *ride;
+            QStringList errors;
+            QFutureWatcher<Job*> *watcher;
+        };
+        static Job *parse(Job *job);
+
+        void pump();                // start whatever we have room for
+        void complete(Job *job);    // deliver and clean up
+
+        CloudService *store;
+        int maxTransfers, maxPending;
+
+        QList<Job*> queued;
+        QHash<QByteArray*, Job*> transfers;
+        QThreadPool pool;
+        int parsing, done, total;
+        bool running, aborted, pumping;
+};
+
 // all cloud services register at startup and can be accessed by name
 // which is typically the website name e.g. "Todays Plan"
 class CloudServiceFactory {
@@ -20,7 +20,9 @@
 #include "Athlete.h"
 #include "Settings.h"
 
-LocalFileStore::LocalFileStore(Context *context) : CloudService(context), context(context) {
+#include <QTimer>
+
+LocalFileStore::LocalFileStore(Context *context) : CloudService(context), context(context), latency(0) {
 
     if (context) {
         // we have a root
@@ -147,11 +149,27 @@ LocalFileStore::readFile(QByteArray *data, QString remotename, QString)
         return false;
     };
 
+    if (latency > 0) {
+        // all delayed by the same amount, so they arrive in order
+        delayed.enqueue(QPair<QByteArray*, QString>(data, remotename));
+        QTimer::singleShot(latency, this, SLOT(deliverRead()));
+        return true;
+    }
+
     emit readComplete(data, remotename, tr("Completed."));
 
     return true;
 }
 
+void
+LocalFileStore::deliverRead()
+{
+    if (delayed.isEmpty()) return;
+
+    QPair<QByteArray*, QString> read = delayed.dequeue();
+    emit readComplete(read.first, read.second, tr("Completed."));
+}
+
 bool 
 LocalFileStore::writeFile(QByteArray &data, QString remotename, RideFile *ride)
 {
@@ -21,6 +21,7 @@
 
 #include "CloudService.h"
 #include <QImage>
+#include <QQueue>
 
 class LocalFileStore : public CloudService {
 
@@ -58,9 +59,20 @@ class LocalFileStore : public CloudService {
         CloudServiceEntry *root() { return root_; }
         QList<CloudServiceEntry*> readdir(QString path, QStringList &errors);
 
+        // pretend to be a remote service; reads complete asynchronously
+        // after ms milliseconds, so sync throughput can be measured
+        // without a network. 0 (the default) completes immediately
+        void setLatency(int ms) { latency = ms; }
+
+    private slots:
+        void deliverRead();
+
     private:
         Context *context;
         CloudServiceEntry *root_;
 
+        int latency;
+        QQueue<QPair<QByteArray*, QString> > delayed;
+
 };
 #endif
@@ -214,6 +214,9 @@ APIWebService::writeRideLine(RideItem &item, HttpRequest *request, HttpResponse
 
     if (settings->intervals == true) {
 
+        // we want all the metrics, compute any we haven't in one go
+        item.computeIntervalMetrics();
+
         // loop through all available intervals for this ride item
         foreach(IntervalItem *interval, item.intervals()){ 
 
@@ -234,14 +237,15 @@ APIWebService::writeRideLine(RideItem &item, HttpRequest *request, HttpResponse
             if (settings->wanted.count()) {
                 // specific metrics
                 foreach(int index, settings->wanted) {
-                    double value = interval->metrics()[index];
+                    double value = interval->getForMetric(index);
                     response->bwrite(",");
                     response->bwrite(QString("%1").arg(value, 'f').simplified().toLocal8Bit());
                 }
             } else {
     
                 // all metrics...
-                foreach(double value, interval->metrics()) {
+                for(int index=0; index<interval->metrics().count(); index++) {
+                    double value = interval->getForMetric(index);
                     response->bwrite(",");
                     response->bwrite(QString("%1").arg(value, 'f').simplified().toLocal8Bit());
                 }
@@ -64,6 +64,9 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     context->athlete = this;
     cyclist = this->home->root().dirName();
 
+    // hot path settings for this athlete
+    appsettings->refreshSnapshot(cyclist);
+
     // get id and set id all at one
     id = QUuid(appsettings->cvalue(cyclist, GC_ATHLETE_ID, QUuid::createUuid().toString()).toString());
     appsettings->setCValue(cyclist, GC_ATHLETE_ID, id.toString());
@@ -346,6 +349,9 @@ Athlete::translateDefaultCharts(QList<LTMSettings>&charts)
 void
 Athlete::configChanged(qint32 state)
 {
+    // pick up any settings that were written behind our back
+    appsettings->refreshSnapshot(cyclist);
+
     // change units
     if (state & CONFIG_UNITS) {
         QVariant unit = appsettings->value(NULL, GC_UNIT, GC_UNIT_METRIC);
@@ -0,0 +1,655 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Benchmark.h"
+
+#include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
+#include "RideFile.h"
+#include "RideMetadata.h"
+#include "DataProcessor.h"
+#include "Settings.h"
+#include "GcUpgrade.h"
+#include "LocalFileStore.h"
+#include "ErgFile.h"
+#include "Route.h"
+#include "IntervalItem.h"
+#include "AddIntervalDialog.h"
+#include "Specification.h"
+
+#ifdef GC_WANT_PYTHON
+#include "PythonEmbed.h"
+#include "FixPyRunner.h"
+#endif
+
+#include "../qzip/zipwriter.h"
+
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#ifdef Q_OS_LINUX
+#include <malloc.h>
+#include <sys/resource.h>
+#endif
+
+#include <stdio.h>
+
+bool Benchmark::enabled = false;
+QAtomicInteger<qint64> Benchmark::stages[Benchmark::RefreshStages];
+
+// heap in use, so we can see what each stage leaves allocated
+static qint64 heapInUse()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#if __GLIBC_PREREQ(2,33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+#else
+    return 0;
+#endif
+}
+
+static qint64 peakRSS()
+{
+#ifdef Q_OS_LINUX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return qint64(usage.ru_maxrss) * 1024;
+#endif
+    return 0;
+}
+
+void
+BenchmarkDownloads::downloaded(int, RideFile *ride, QStringList)
+{
+    if (ride) received++;
+    else failed++;
+    delete ride;
+}
+
+// download everything in the store, returns the number parsed
+static int download(Context *context, QString folder, QStringList names, int latency,
+                    int transfers, int pending, double &ms, qint64 &heap)
+{
+    LocalFileStore store(context);
+    store.setSetting(GC_NETWORKFILESTORE_FOLDER, folder);
+    store.setLatency(latency);
+
+    BenchmarkDownloads results;
+    CloudServiceDownloader downloader(&store, transfers, pending);
+    QObject::connect(&downloader, SIGNAL(downloaded(int,RideFile*,QStringList)), &results, SLOT(downloaded(int,RideFile*,QStringList)));
+
+    QEventLoop loop;
+    QObject::connect(&downloader, SIGNAL(finished()), &loop, SLOT(quit()));
+
+    qint64 before = heapInUse();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i=0; i<names.count(); i++) downloader.add(names[i], names[i], i);
+    downloader.start();
+    if (downloader.isRunning()) loop.exec();
+
+    ms = timer.nsecsElapsed() / 1000000.0;
+    heap = heapInUse() - before;
+    return results.received;
+}
+
+// play a workout as the train view would, 10 ticks a second and
+// a seek every so often, returns the number of lookups made
+static int play(ErgFile *workout, double &ms)
+{
+    bool slope = workout->format == CRS || workout->format == CRS_LOC;
+    long step = slope ? 1 : 100; // 10m/s or 100ms
+    int ticks = 0, lap = 0;
+    double sink = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (long x=0; x <= workout->Duration; x += step) {
+
+        // seek back or forward, as when restarting or skipping a lap
+        if (ticks && ticks % 1000 == 0) {
+            long to = (ticks * 7919L) % (workout->Duration + 1);
+            if (slope) sink += workout->gradientAt(to, lap);
+            else sink += workout->wattsAt(to, lap);
+        }
+
+        if (slope) sink += workout->gradientAt(x, lap);
+        else sink += workout->wattsAt(x, lap);
+        sink += workout->nextLap(x) + lap;
+        ticks++;
+    }
+    ms += timer.nsecsElapsed() / 1000000.0;
+
+    // don't let the lookups be optimised away
+    if (sink == 0.12345) fprintf(stderr, " ");
+    return ticks;
+}
+
+// the same window, exactly
+static bool samePeak(bool found, const AddIntervalDialog::AddedInterval &a,
+                     bool otherFound, const AddIntervalDialog::AddedInterval &b)
+{
+    if (found != otherFound) return false;
+    if (!found) return true;
+    return a.avg == b.avg && a.start == b.start && a.stop == b.stop;
+}
+
+static QJsonObject stage(double ms, int count, qint64 heap)
+{
+    QJsonObject json;
+    json.insert("ms", ms);
+    json.insert("count", count);
+    json.insert("per_second", ms > 0 ? count / (ms / 1000.0) : 0);
+    json.insert("heap_bytes", double(heap));
+    return json;
+}
+
+int
+Benchmark::run(QString corpus, int copies)
+{
+    // the synthetic athlete lives in a temporary root, so
+    // the user's own athletes and settings are left alone
+    QTemporaryDir root;
+    if (!root.isValid()) {
+        fprintf(stderr, "benchmark: cannot create temporary directory\n");
+        return 1;
+    }
+    QString name = "benchmark";
+    QDir home(root.path());
+    home.mkdir(name);
+    home.cd(name);
+    appsettings->initializeQSettingsAthlete(root.path(), name);
+    appsettings->setCValue(name, GC_VERSION_USED, VERSION_LATEST);
+    appsettings->setCValue(name, GC_SAFEEXIT, true);
+
+    // the corpus
+    QStringList sources;
+    foreach(QString folder, QStringList() << "rides" << "runs" << "swims") {
+        QDir dir(corpus + "/" + folder);
+        foreach(QString file, RideFileFactory::instance().listRideFiles(dir))
+            sources << dir.absoluteFilePath(file);
+    }
+    if (sources.isEmpty()) {
+        fprintf(stderr, "benchmark: no activities found in %s\n", corpus.toUtf8().constData());
+        return 1;
+    }
+
+    QJsonObject stages;
+    QElapsedTimer timer;
+    int activities = 0;
+
+    // simulated round trip for each cloud download
+    const int latency = 50;
+
+    // python results came back in ride order
+    QJsonValue pythonOrdered;
+
+    // peak windows that differ from the original scan
+    int peaksMismatched = 0;
+
+    //
+    // IMPORT - open, auto process and save as json, serially
+    //
+    {
+        Context *context = new Context(NULL);
+        Athlete *athlete = new Athlete(context, home);
+
+        double open=0, process=0, write=0;
+        qint64 openHeap=0, processHeap=0, writeHeap=0;
+        QDateTime when(QDate(2010,1,1), QTime(6,0,0));
+
+        for (int copy=0; copy<copies; copy++) {
+            foreach(QString source, sources) {
+
+                qint64 heap = heapInUse();
+                timer.start();
+                QFile file(source);
+                QStringList errors;
+                RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+                open += timer.nsecsElapsed() / 1000000.0;
+                openHeap += heapInUse() - heap;
+                if (!ride) continue;
+
+                // each copy is a separate activity, two a day
+                ride->setStartTime(when);
+                QString filename = when.toString("yyyy_MM_dd_hh_mm_ss") + ".json";
+                ride->setTag("Filename", filename);
+                when = when.addSecs(12 * 3600);
+
+                heap = heapInUse();
+                timer.start();
+                athlete->rideMetadata()->setLinkedDefaults(ride);
+                DataProcessorFactory::instance().autoProcess(ride, "Auto", "Import");
+                ride->recalculateDerivedSeries();
+                process += timer.nsecsElapsed() / 1000000.0;
+                processHeap += heapInUse() - heap;
+
+                heap = heapInUse();
+                timer.start();
+                QFile out(athlete->home->activities().absoluteFilePath(filename));
+                RideFileFactory::instance().writeRideFile(context, ride, out, "json");
+                write += timer.nsecsElapsed() / 1000000.0;
+                writeHeap += heapInUse() - heap;
+
+                delete ride;
+                activities++;
+            }
+        }
+        stages.insert("import_open", stage(open, activities, openHeap));
+        stages.insert("import_process", stage(process, activities, processHeap));
+        stages.insert("import_write", stage(write, activities, writeHeap));
+
+        athlete->close();
+        delete athlete;
+        delete context;
+    }
+
+    //
+    // FORMATS - write each activity and read it back, one format at a time,
+    // so each reader and writer is timed on its own whatever the corpus has
+    //
+    {
+        Context *context = new Context(NULL);
+        Athlete *athlete = new Athlete(context, home);
+
+        QDir folder(root.path());
+        folder.mkdir("formats");
+        folder.cd("formats");
+
+        // the corpus, read once
+        QList<RideFile*> rides;
+        foreach(QString source, sources) {
+            QFile file(source);
+            QStringList errors;
+            RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+            if (ride) rides << ride;
+        }
+
+        foreach(QString format, QStringList() << "json" << "fit" << "tcx" << "gpx" << "pwx") {
+
+            double write=0, read=0;
+            qint64 writeHeap=0, readHeap=0;
+            int written=0, reads=0;
+
+            for (int copy=0; copy<copies; copy++) {
+                for (int i=0; i<rides.count(); i++) {
+
+                    QString filename = folder.absoluteFilePath(QString("%1.%2").arg(i).arg(format));
+
+                    qint64 heap = heapInUse();
+                    timer.start();
+                    QFile out(filename);
+                    bool ok = RideFileFactory::instance().writeRideFile(context, rides[i], out, format);
+                    write += timer.nsecsElapsed() / 1000000.0;
+                    writeHeap += heapInUse() - heap;
+                    if (!ok) continue;
+                    written++;
+
+                    heap = heapInUse();
+                    timer.start();
+                    QFile in(filename);
+                    QStringList errors;
+                    RideFile *ride = RideFileFactory::instance().openRideFile(context, in, errors);
+                    read += timer.nsecsElapsed() / 1000000.0;
+                    readHeap += heapInUse() - heap;
+                    if (ride) reads++;
+
+                    delete ride;
+                    QFile::remove(filename);
+                }
+            }
+            stages.insert(format + "_write", stage(write, written, writeHeap));
+            stages.insert(format + "_read", stage(read, reads, readHeap));
+        }
+
+        foreach(RideFile *ride, rides) delete ride;
+
+        athlete->close();
+        delete athlete;
+        delete context;
+    }
+
+    //
+    // REFRESH - open the athlete and wait for the ride cache
+    //
+    {
+        for (int i=0; i<RefreshStages; i++) Benchmark::stages[i].store(0);
+        enabled = true;
+
+        qint64 heap = heapInUse();
+        timer.start();
+
+        Context *context = new Context(NULL);
+        QEventLoop loop;
+        QObject::connect(context, SIGNAL(refreshEnd()), &loop, SLOT(quit()));
+        Athlete *athlete = new Athlete(context, home);
+        if (athlete->rideCache->isRunning()) loop.exec();
+
+        double ms = timer.nsecsElapsed() / 1000000.0;
+        enabled = false;
+
+        int count = athlete->rideCache->rides().count();
+        stages.insert("refresh", stage(ms, count, heapInUse() - heap));
+
+        // time spent in each part of RideItem::refresh, summed across threads
+        const char *names[RefreshStages] = { "refresh_open", "refresh_metrics", "refresh_intervals", "refresh_cache" };
+        for (int i=0; i<RefreshStages; i++)
+            stages.insert(names[i], stage(Benchmark::stages[i].load() / 1000000.0, count, 0));
+
+        //
+        // CLOUD - download the activities back from a local file store
+        // that pretends to be remote, first one at a time then pipelined
+        //
+        QDir cloud(root.path());
+        cloud.mkdir("cloud");
+        cloud.cd("cloud");
+        QStringList remote;
+        foreach(QString file, athlete->home->activities().entryList(QStringList() << "*.json", QDir::Files)) {
+            QFile json(athlete->home->activities().absoluteFilePath(file));
+            if (!json.open(QFile::ReadOnly)) continue;
+
+            ZipWriter writer(cloud.absoluteFilePath(file + ".zip"));
+            writer.addFile(file, json.readAll());
+            writer.close();
+            remote << file + ".zip";
+        }
+
+        double serialMs=0, pipelinedMs=0;
+        qint64 serialHeap=0, pipelinedHeap=0;
+        int serial = download(context, cloud.absolutePath(), remote, latency, 1, 1, serialMs, serialHeap);
+        int pipelined = download(context, cloud.absolutePath(), remote, latency, 4, 16, pipelinedMs, pipelinedHeap);
+        stages.insert("cloud_serial", stage(serialMs, serial, serialHeap));
+        stages.insert("cloud_pipelined", stage(pipelinedMs, pipelined, pipelinedHeap));
+
+        //
+        // ROUTES - search every activity with GPS against many route
+        // segments; a few cut from the activities themselves so they
+        // match and lots of copies moved nearby so most are rejected
+        //
+        {
+            QList<RideFile*> rides;
+            foreach(QString file, athlete->home->activities().entryList(QStringList() << "*.json", QDir::Files)) {
+                QFile json(athlete->home->activities().absoluteFilePath(file));
+                QStringList errors;
+                RideFile *ride = RideFileFactory::instance().openRideFile(context, json, errors);
+                if (ride && ride->areDataPresent()->lat) rides << ride;
+                else delete ride;
+            }
+
+            Routes *routes = athlete->routes;
+            QList<RouteSegment> saved = routes->routes;
+            routes->routes.clear();
+
+            // a segment from a quarter to halfway through each distinct
+            // activity, every 10th sample, then shifted copies of it
+            QSet<QString> cut;
+            foreach(RideFile *ride, rides) {
+                int n = ride->dataPoints().count();
+                QString where = QString("%1,%2").arg(ride->dataPoints().first()->lat).arg(n);
+                if (cut.contains(where)) continue;
+                cut.insert(where);
+
+                for (int copy=0; copy<100; copy++) {
+                    double shift = copy * 0.01; // about 1km each
+                    RouteSegment segment;
+                    segment.setName(QString("route %1").arg(routes->routes.count()));
+                    for (int i=n/4; i<n/2; i+=10) {
+                        const RideFilePoint *p = ride->dataPoints().at(i);
+                        if (p->lat == 0 || p->lon == 0) continue;
+                        segment.addPoint(RoutePoint(p->lon + shift, p->lat + shift));
+                    }
+                    if (segment.getPoints().count() > 1) routes->routes << segment;
+                }
+            }
+
+            int found = 0;
+            qint64 heap = heapInUse();
+            timer.start();
+            foreach(RideFile *ride, rides) {
+                QList<IntervalItem*> here;
+                routes->search(NULL, ride, here);
+                found += here.count();
+                qDeleteAll(here);
+            }
+            QJsonObject matched = stage(timer.nsecsElapsed() / 1000000.0, rides.count(), heapInUse() - heap);
+            matched.insert("routes", routes->routes.count());
+            matched.insert("found", found);
+            stages.insert("route_search", matched);
+
+            routes->routes = saved;
+            qDeleteAll(rides);
+        }
+
+        //
+        // PEAKS - the best windows the peak metrics and intervals use,
+        // one size at a time and fused into one pass per series; both
+        // must match the original list based scan bit for bit
+        //
+        {
+            QList<RideFile*> rides;
+            foreach(QString file, athlete->home->activities().entryList(QStringList() << "*.json", QDir::Files)) {
+                QFile json(athlete->home->activities().absoluteFilePath(file));
+                QStringList errors;
+                RideFile *ride = RideFileFactory::instance().openRideFile(context, json, errors);
+                if (ride && !ride->dataPoints().isEmpty()) rides << ride;
+                else delete ride;
+            }
+
+            // what the peak metrics ask for
+            QVector<double> secs, meters;
+            secs << 1 << 5 << 10 << 15 << 20 << 30 << 60 << 120 << 180 << 300 << 360 << 480 << 600
+                 << 1200 << 1800 << 2700 << 3600;
+            meters << 100 << 200 << 400 << 800 << 1000 << 1500 << 2000 << 3000 << 4000 << 5000 << 10000
+                   << 15000 << 20000 << 21098 << 30000 << 40000 << 42195 << 50000 << 100000;
+
+            struct Scan { bool typeTime; RideFile::SeriesType series; const QVector<double> *sizes; };
+            Scan scans[] = { { true, RideFile::watts, &secs }, { true, RideFile::hr, &secs },
+                             { true, RideFile::kph, &secs }, { false, RideFile::kph, &meters } };
+            const int nscans = sizeof(scans) / sizeof(scans[0]);
+
+            // the original scan, which sorts every window so the first is best
+            QList<QVector<AddIntervalDialog::AddedInterval> > reference;
+            QList<QVector<bool> > referenceFound;
+            timer.start();
+            foreach(RideFile *ride, rides) {
+                for (int s=0; s<nscans; s++) {
+                    QVector<AddIntervalDialog::AddedInterval> peaks;
+                    QVector<bool> found;
+                    foreach(double size, *scans[s].sizes) {
+                        QList<AddIntervalDialog::AddedInterval> results;
+                        AddIntervalDialog::findPeaks(context, scans[s].typeTime, ride, Specification(), scans[s].series,
+                                                     RideFile::original, size, 2, results, "", "");
+                        peaks << (results.isEmpty() ? AddIntervalDialog::AddedInterval() : results.first());
+                        found << !results.isEmpty();
+                    }
+                    reference << peaks;
+                    referenceFound << found;
+                }
+            }
+            double referenceMs = timer.nsecsElapsed() / 1000000.0;
+
+            int windows=0, mismatched=0;
+            double singleMs=0, fusedMs=0;
+            for (int r=0; r<rides.count(); r++) {
+                for (int s=0; s<nscans; s++) {
+                    const QVector<AddIntervalDialog::AddedInterval> &expected = reference[r * nscans + s];
+                    const QVector<bool> &expectedFound = referenceFound[r * nscans + s];
+                    const QVector<double> &sizes = *scans[s].sizes;
+
+                    QVector<AddIntervalDialog::AddedInterval> single(sizes.count());
+                    QVector<bool> singleFound(sizes.count());
+                    timer.start();
+                    for (int i=0; i<sizes.count(); i++)
+                        singleFound[i] = AddIntervalDialog::findPeak(scans[s].typeTime, rides[r], Specification(),
+                                                                     scans[s].series, sizes[i], single[i]);
+                    singleMs += timer.nsecsElapsed() / 1000000.0;
+
+                    QVector<AddIntervalDialog::AddedInterval> fused;
+                    QVector<bool> fusedFound;
+                    timer.start();
+                    AddIntervalDialog::findPeakWindows(scans[s].typeTime, rides[r], Specification(), scans[s].series,
+                                                       sizes, fused, fusedFound);
+                    fusedMs += timer.nsecsElapsed() / 1000000.0;
+
+                    // and as the metrics see them, through the cache
+                    QVector<AddIntervalDialog::AddedInterval> cached(sizes.count());
+                    QVector<bool> cachedFound(sizes.count());
+                    {
+                        PeakCache cache((Specification()));
+                        for (int i=0; i<sizes.count(); i++)
+                            cachedFound[i] = PeakCache::peak(scans[s].typeTime, rides[r], Specification(),
+                                                             scans[s].series, sizes[i], cached[i]);
+                    }
+
+                    for (int i=0; i<sizes.count(); i++) {
+                        windows++;
+                        if (!samePeak(expectedFound[i], expected[i], singleFound[i], single[i]) ||
+                            !samePeak(expectedFound[i], expected[i], fusedFound[i], fused[i]) ||
+                            !samePeak(expectedFound[i], expected[i], cachedFound[i], cached[i]))
+                            mismatched++;
+                    }
+                }
+            }
+            stages.insert("peaks_reference", stage(referenceMs, rides.count(), 0));
+            stages.insert("peaks_single", stage(singleMs, rides.count(), 0));
+            QJsonObject fused = stage(fusedMs, rides.count(), 0);
+            fused.insert("windows", windows);
+            stages.insert("peaks_fused", fused);
+            peaksMismatched = mismatched;
+
+            qDeleteAll(rides);
+        }
+
+        //
+        // WORKOUTS - play back the test workouts, and a long synthetic
+        // slope course, the cost per tick shouldn't depend on length
+        //
+        QDir folder(corpus + "/workouts");
+        double workoutMs=0, longMs=0;
+        int ticks=0, points=0;
+        foreach(QString file, folder.entryList(QDir::Files)) {
+            if (!ErgFile::isWorkout(file)) continue;
+
+            ErgFile workout(folder.absoluteFilePath(file), 0, context);
+            if (!workout.isValid()) continue;
+            ticks += play(&workout, workoutMs);
+            points = qMax(points, workout.Points.count());
+        }
+        QJsonObject played = stage(workoutMs, ticks, 0);
+        played.insert("max_points", points);
+        stages.insert("workout_ticks", played);
+
+        ErgFile course(context);
+        course.format = CRS;
+        course.valid = true;
+        for (int i=0; i<50000; i++) {
+            double gradient = (i % 200) / 20.0 - 5;
+            course.Points << ErgFilePoint(i * 10, 0, gradient);
+            if (i && i % 5000 == 0) {
+                ErgFileLap lap;
+                lap.x = i * 10;
+                lap.LapNum = course.Laps.count() + 1;
+                lap.selected = false;
+                course.Laps << lap;
+            }
+        }
+        course.Duration = course.Points.last().x;
+        course.indexPoints();
+        int longTicks = play(&course, longMs);
+        stages.insert("workout_long_ticks", stage(longMs, longTicks, 0));
+
+#ifdef GC_WANT_PYTHON
+        //
+        // PYTHON - a fix script over every activity, one at a time then
+        // in worker processes; the output for each ride must match, be in
+        // order and every script must have run cleanly
+        //
+        if (python) {
+            QList<RideFile*> rides;
+            foreach(QString file, athlete->home->activities().entryList(QStringList() << "*.json", QDir::Files)) {
+                QFile json(athlete->home->activities().absoluteFilePath(file));
+                QStringList errors;
+                RideFile *ride = RideFileFactory::instance().openRideFile(context, json, errors);
+                if (ride) rides << ride;
+            }
+
+            QString script = "import math\n"
+                             "watts = GC.series(GC.SERIES_WATTS)\n"
+                             "total = 0.0\n"
+                             "for i in range(0, len(watts)):\n"
+                             "    total += watts[i] * watts[i]\n"
+                             "print(len(watts), round(math.sqrt(total / max(1, len(watts))), 3))\n";
+
+            FixPyRunner runner(context, NULL, true);
+            QStringList serial, concurrent;
+
+            qint64 heap = heapInUse();
+            timer.start();
+            foreach(RideFile *ride, rides) {
+                QString output;
+                FixPyRunner one(context, ride, false);
+                one.run(script, "benchmark", output);
+                serial << output;
+            }
+            stages.insert("python_serial", stage(timer.nsecsElapsed() / 1000000.0, rides.count(), heapInUse() - heap));
+
+            heap = heapInUse();
+            timer.start();
+            QList<int> results = runner.runAll(script, "benchmark", rides, concurrent);
+            stages.insert("python_concurrent", stage(timer.nsecsElapsed() / 1000000.0, rides.count(), heapInUse() - heap));
+            pythonOrdered = serial == concurrent && results.count(0) == rides.count();
+
+            qDeleteAll(rides);
+        }
+#endif
+
+        athlete->close();
+        delete athlete;
+        delete context;
+    }
+
+    QJsonObject report;
+    report.insert("version", VERSION_LATEST);
+    report.insert("corpus", QDir(corpus).absolutePath());
+    report.insert("sources", sources.count());
+    report.insert("copies", copies);
+    report.insert("activities", activities);
+    report.insert("threads", QThread::idealThreadCount());
+    report.insert("cloud_latency_ms", latency);
+    report.insert("python_ordered", pythonOrdered);
+    report.insert("peaks_mismatched", peaksMismatched);
+    report.insert("peak_rss_bytes", double(peakRSS()));
+    report.insert("stages", stages);
+
+    fprintf(stdout, "%s", QJsonDocument(report).toJson().constData());
+    fflush(stdout);
+
+    // the peak windows are a correctness check, not just a timing
+    if (peaksMismatched) {
+        fprintf(stderr, "benchmark: %d peak windows differ from the original scan\n", peaksMismatched);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_Benchmark_h
+#define _GC_Benchmark_h 1
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+
+class RideFile;
+
+// Headless benchmark of the import and refresh hot path, run with
+// GoldenCheetah --benchmark [corpus folder] [copies]
+//
+// The rides, runs and swims in the corpus (e.g. the test folder) are
+// imported copies times into a temporary athlete, and written and read
+// back as json, fit, tcx, gpx and pwx so each format is timed on its own.
+// The athlete is then opened so the ride cache refreshes everything.
+// They are then downloaded back from a local file store with simulated
+// network latency, one at a time and then pipelined, and searched against
+// thousands of route segments.
+// Their peak windows are found one size at a time and all at once, and
+// must match the original scan exactly or the benchmark exits with 1.
+// When Python is available a fix script is run over them serially and
+// concurrently. Finally the workouts in the corpus are played back at
+// training tick rates. Timings are written to stdout
+// as json so runs can be compared over time.
+class Benchmark
+{
+    public:
+
+        // stages of RideItem::refresh, timed when a benchmark is running
+        enum { Open=0, Metrics, Intervals, Cache, RefreshStages };
+
+        static int run(QString corpus, int copies);
+
+        // add time since the last lap to a refresh stage, refresh runs
+        // on several threads so these are totals across all of them
+        static bool enabled;
+        static void lap(int stage, QElapsedTimer &timer) {
+            stages[stage].fetchAndAddRelaxed(timer.nsecsElapsed());
+            timer.restart();
+        }
+
+    private:
+        static QAtomicInteger<qint64> stages[RefreshStages];
+};
+
+// collects the rides downloaded during the cloud stage
+class BenchmarkDownloads : public QObject
+{
+    Q_OBJECT
+
+    public:
+        BenchmarkDownloads() : received(0), failed(0) {}
+        int received, failed;
+
+    public slots:
+        void downloaded(int, RideFile *ride, QStringList);
+};
+
+#endif
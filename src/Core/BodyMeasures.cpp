@@ -174,6 +174,26 @@ BodyMeasures::setBodyMeasures(QList<BodyMeasure>&x)
 {
     bodyMeasures_ = x;
     qSort(bodyMeasures_); // date order
+
+    // a reading is in force until the next one, we only look
+    // for weight readings at present so skip any without
+    QVector<QDate> begins(bodyMeasures_.count()), ends(bodyMeasures_.count());
+    QDate next;
+    for (int i=bodyMeasures_.count()-1; i>=0; i--) {
+        QDate date = bodyMeasures_[i].when.date();
+        begins[i] = date;
+        if (bodyMeasures_[i].weightkg <= 0) {
+            ends[i] = date; // never
+        } else {
+            ends[i] = next;
+            next = date;
+        }
+    }
+
+    Indexed *update = new Indexed;
+    update->measures = bodyMeasures_;
+    update->index = DateIndex(begins, ends);
+    indexed.publish(update);
 }
 
 QStringList
@@ -213,25 +233,13 @@ BodyMeasures::getFieldUnits(int field, bool useMetricUnits) const {
 
 void
 BodyMeasures::getBodyMeasure(QDate date, BodyMeasure &here) const {
-    // the optimisation below is not thread safe and should be encapsulated
-    // by a mutex, but this kind of defeats to purpose of the optimisation!
-
-    //if (withings_.count() && withings_.last().when.date() <= date) here = withings_.last();
-    //if (!withings_.count() || withings_.first().when.date() > date) here = WithingsReading();
-
     // always set to not found before searching
     here = BodyMeasure();
 
-    // loop
-    foreach(BodyMeasure x, bodyMeasures_) {
-
-        // we only look for weight readings at present
-        // some readings may not include this so skip them
-        if (x.weightkg <= 0) continue;
-
-        if (x.when.date() <= date) here = x;
-        if (x.when.date() > date) break;
-    }
+    // latest weight reading on or before date
+    const Indexed *current = indexed.get();
+    int i = current ? current->index.find(date) : -1;
+    if (i >= 0) here = current->measures.at(i);
 
     // will be empty if none found
     return;
@@ -21,6 +21,7 @@
 
 #include "Context.h"
 #include "Measures.h"
+#include "DateIndex.h"
 
 #include <QString>
 #include <QStringList>
@@ -65,7 +66,7 @@ public:
     BodyMeasures(QDir dir=QDir(), bool withData=false);
     ~BodyMeasures() {}
     void write();
-    QList<BodyMeasure>& bodyMeasures() { return bodyMeasures_; }
+    const QList<BodyMeasure>& bodyMeasures() const { return bodyMeasures_; }
     void setBodyMeasures(QList<BodyMeasure>&x);
     void getBodyMeasure(QDate date, BodyMeasure&) const;
 
@@ -82,6 +83,10 @@ private:
     QDir dir;
     bool withData;
     QList<BodyMeasure> bodyMeasures_;
+
+    // measures and the reading in force by date, for lookups from any thread
+    struct Indexed { QList<BodyMeasure> measures; DateIndex index; };
+    Published<Indexed> indexed;
 };
 
 
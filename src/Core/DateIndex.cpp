@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DateIndex.h"
+
+#include <algorithm>
+
+// the day table is only kept for a plausible span, placeholder dates
+// like 1900-01-01 or 9999-12-31 are left to the binary search
+static const qint64 maxDenseDays = 60 * 366;
+
+DateIndex::DateIndex(const QVector<QDate> &begins, const QVector<QDate> &ends) : firstDay(0)
+{
+    // all the dates where the answer can change
+    for (int i=0; i<begins.count(); i++) {
+        if (!begins[i].isNull()) boundaries << begins[i].toJulianDay();
+        if (!ends[i].isNull()) boundaries << ends[i].toJulianDay();
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    // segment 0 is before the first boundary, segment j+1 is from
+    // boundary j up to the next one; first range to cover it wins
+    segments.fill(-1, boundaries.count() + 1);
+    for (int i=0; i<begins.count(); i++) {
+        int from = begins[i].isNull() ? 0 :
+                   std::lower_bound(boundaries.begin(), boundaries.end(), begins[i].toJulianDay()) - boundaries.begin() + 1;
+        int to = ends[i].isNull() ? segments.count() :
+                 std::lower_bound(boundaries.begin(), boundaries.end(), ends[i].toJulianDay()) - boundaries.begin() + 1;
+        for (int s=from; s<to; s++) if (segments[s] == -1) segments[s] = i;
+    }
+
+    // dense table, dropping outlying boundaries till the span is sensible
+    int lo = 0, hi = boundaries.count() - 1;
+    while (hi > lo && boundaries[hi] - boundaries[lo] > maxDenseDays) {
+        if (boundaries[lo+1] - boundaries[lo] > boundaries[hi] - boundaries[hi-1]) lo++;
+        else hi--;
+    }
+    if (hi > lo) {
+        firstDay = boundaries[lo];
+        days.resize(boundaries[hi] - firstDay);
+        for (int j=lo; j<hi; j++)
+            std::fill(days.begin() + (boundaries[j] - firstDay), days.begin() + (boundaries[j+1] - firstDay), segments[j+1]);
+    }
+}
+
+int
+DateIndex::find(const QDate &date) const
+{
+    if (segments.isEmpty()) return -1;
+
+    qint64 day = date.toJulianDay(); // null dates sort before everything
+    if (day >= firstDay && day - firstDay < days.count()) return days[day - firstDay];
+
+    return segments[std::upper_bound(boundaries.begin(), boundaries.end(), day) - boundaries.begin()];
+}
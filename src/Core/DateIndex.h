@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DateIndex_h
+#define _GC_DateIndex_h 1
+
+#include <QDate>
+#include <QVector>
+#include <QList>
+#include <QAtomicPointer>
+
+// Finds which of a list of date ranges is in force on a given date.
+//
+// Ranges are [begin, end) and a null begin or end is open ended, where
+// ranges overlap the first one in the list wins. The range boundaries are
+// kept as a sorted array for a binary search, with a table of one entry
+// per day for the span where the boundaries are (so a lookup for a date
+// during the athlete's history is just a subtraction).
+//
+// It is immutable once built, so can be read from any thread.
+class DateIndex
+{
+    public:
+        DateIndex() {}
+        DateIndex(const QVector<QDate> &begins, const QVector<QDate> &ends);
+
+        // index of the range in force on date, or -1 if there isn't one
+        int find(const QDate &date) const;
+
+    private:
+        QVector<qint64> boundaries; // julian days, sorted and unique
+        QVector<int> segments;      // range for before, between and after the boundaries
+
+        qint64 firstDay;            // dense table covers [firstDay, firstDay + days.count())
+        QVector<int> days;
+};
+
+// Publishes an immutable value (e.g. a DateIndex) so it can be read from
+// refresh threads without locking while the gui thread replaces it.
+//
+// A reader may still be looking at a value that has been replaced, so old
+// values are kept until the owner is destroyed; they are only replaced
+// when the user edits or downloads data so there are never many.
+template <class T>
+class Published
+{
+    public:
+        Published() : current(NULL) {}
+        ~Published() { qDeleteAll(retired); delete current.load(); }
+
+        const T *get() const { return current.loadAcquire(); }
+        void publish(T *value) {
+            T *was = current.fetchAndStoreOrdered(value);
+            if (was) retired << was;
+        }
+
+    private:
+        Q_DISABLE_COPY(Published)
+
+        QAtomicPointer<T> current;
+        QList<T*> retired;
+};
+
+#endif
@@ -180,6 +180,21 @@ HrvMeasures::setHrvMeasures(QList<HrvMeasure>&x)
 {
     hrvMeasures_ = x;
     qSort(hrvMeasures_); // date order
+
+    // a reading only applies on the day it was taken, when
+    // there are several on a day the last one is used
+    QVector<QDate> begins(hrvMeasures_.count()), ends(hrvMeasures_.count());
+    for (int i=0; i<hrvMeasures_.count(); i++) {
+        QDate date = hrvMeasures_[i].when.date();
+        begins[i] = date;
+        if (i+1 < hrvMeasures_.count() && hrvMeasures_[i+1].when.date() == date) ends[i] = date;
+        else ends[i] = date.addDays(1);
+    }
+
+    Indexed *update = new Indexed;
+    update->measures = hrvMeasures_;
+    update->index = DateIndex(begins, ends);
+    indexed.publish(update);
 }
 
 QStringList
@@ -222,12 +237,9 @@ HrvMeasures::getHrvMeasure(QDate date, HrvMeasure &here) const {
     // always set to not found before searching
     here = HrvMeasure();
 
-    // loop
-    foreach(HrvMeasure x, hrvMeasures_) {
-
-        if (x.when.date() == date) here = x;
-        if (x.when.date() > date) break;
-    }
+    const Indexed *current = indexed.get();
+    int i = current ? current->index.find(date) : -1;
+    if (i >= 0) here = current->measures.at(i);
 
     // will be empty if none found
     return;
@@ -22,6 +22,7 @@
 
 #include "Context.h"
 #include "Measures.h"
+#include "DateIndex.h"
 
 #include <QString>
 #include <QStringList>
@@ -67,7 +68,7 @@ public:
     HrvMeasures(QDir dir=QDir(), bool withData=false);
     ~HrvMeasures() {}
     void write();
-    QList<HrvMeasure>& hrvMeasures() { return hrvMeasures_; }
+    const QList<HrvMeasure>& hrvMeasures() const { return hrvMeasures_; }
     void setHrvMeasures(QList<HrvMeasure>&x);
     void getHrvMeasure(QDate date, HrvMeasure&) const;
 
@@ -84,6 +85,10 @@ private:
     QDir dir;
     bool withData;
     QList<HrvMeasure> hrvMeasures_;
+
+    // measures and the reading for each date, for lookups from any thread
+    struct Indexed { QList<HrvMeasure> measures; DateIndex index; };
+    Published<Indexed> indexed;
 };
 
 #endif
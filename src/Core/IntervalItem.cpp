@@ -24,6 +24,15 @@
 #include "Colors.h"
 #include "ColorButton.h"
 
+#include <QMutex>
+
+// the metrics that built in charts and views look up on every
+// interval, so we compute them whilst the ride is open anyway
+static const char *eagerMetrics[] = {
+    "workout_time", "time_recording", "average_power", "power_index",
+    "total_distance", "average_hr", "average_speed", NULL
+};
+
 IntervalItem::IntervalItem(const RideItem *ride, QString name, double start, double stop, 
                            double startKM, double stopKM, int displaySequence, QColor color, bool test,
                            RideFileInterval::IntervalType type)
@@ -40,12 +49,14 @@ IntervalItem::IntervalItem(const RideItem *ride, QString name, double start, dou
     this->test = test;
     this->rideInterval = NULL;
     this->rideItem_ = const_cast<RideItem*>(ride);
+    this->computing_ = false;
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
 }
 
 IntervalItem::IntervalItem() : rideItem_(NULL), selected(false), name(""), type(RideFileInterval::USER), start(0), stop(0),
-                               startKM(0), stopKM(0), displaySequence(0), color(Qt::black), test(false), rideInterval(NULL)
+                               startKM(0), stopKM(0), displaySequence(0), color(Qt::black), test(false),
+                               rideInterval(NULL), computing_(false)
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
@@ -54,6 +65,7 @@ IntervalItem::IntervalItem() : rideItem_(NULL), selected(false), name(""), type(
 void
 IntervalItem::setFrom(IntervalItem &other)
 {
+    QMutexLocker locker(other.lock());
     *this = other;
     rideItem_ = other.rideItem_;
     rideInterval = NULL;
@@ -93,63 +105,180 @@ IntervalItem::setValues(QString name, double duration1, double duration2,
 
 }
 
+QMutex *
+IntervalItem::lock() const
+{
+    // intervals share their ride's lock, it is held whilst the ride
+    // is opened, refreshed or closed so we can compute safely
+    return rideItem_ ? &rideItem_->rideLock : NULL;
+}
+
 void
-IntervalItem::refresh()
+IntervalItem::refresh(bool all)
 {
+    QMutexLocker locker(lock());
+
     // don't open on our account - we should be called with a ride available
-    RideFile *f = rideItem_->ride_;
-    if (!f) return;
+    if (!rideItem_ || !rideItem_->ride_) return;
 
     // metrics
     const RideMetricFactory &factory = RideMetricFactory::instance();
 
-    // resize and set to zero
+    // resize and set to zero, nothing is valid yet
     metrics_.fill(0, factory.metricCount());
     count_.fill(0, factory.metricCount());
+    stdmean_.clear();
+    stdvariance_.clear();
+    computed_.fill(false, factory.metricCount());
+
+    // just the ones everyone wants, the rest when asked for
+    if (all) {
+        compute(factory.allMetrics());
+    } else {
+        QStringList eager;
+        for (int i=0; eagerMetrics[i]; i++) eager << eagerMetrics[i];
+        compute(eager);
+    }
+}
+
+void
+IntervalItem::computeAll()
+{
+    QMutexLocker locker(lock());
+    compute(RideMetricFactory::instance().allMetrics());
+}
 
-    // ok, lets collect the metrics
-    QHash<QString,RideMetricPtr> computed=RideMetric::computeMetrics(rideItem_, Specification(this, f->recIntSecs()), factory.allMetrics());
-    // take a deep copy, quick before the thread exits.
-    //XXXcomputed.detach();
+bool
+IntervalItem::compute(const QStringList &symbols)
+{
+    // nothing to do, or asked for whilst computing (e.g. a user metric
+    // formula that looks at this interval) and we'll be done shortly
+    if (!rideItem_ || computed_.isEmpty() || computing_) return false;
+
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    // which of these are still to do?
+    QStringList todo;
+    foreach(QString symbol, symbols) {
+        const RideMetric *m = factory.rideMetric(symbol);
+        if (m && m->index() < computed_.size() && !computed_.testBit(m->index())) todo << symbol;
+    }
+    if (todo.isEmpty()) return true;
+
+    // open the ride if we need to, but not when it is stale, opening
+    // would refresh it and that replaces the intervals, including us.
+    // the ride cache refresh that is pending will compute them instead
+    bool doclose = false;
+    if (!rideItem_->isOpen()) {
+        if (rideItem_->isstale || rideItem_->path == "") return false;
+        doclose = true;
+    }
+    RideFile *f = rideItem_->ride();
+    if (!f) return false;
+
+    // ok, lets collect the metrics, computeMetrics adds any dependencies
+    computing_ = true;
+    QHash<QString,RideMetricPtr> computed=RideMetric::computeMetrics(rideItem_, Specification(this, f->recIntSecs()), todo);
+    computing_ = false;
 
     // snaffle away all the computed values into the array
     QHashIterator<QString, RideMetricPtr> i(computed);
     while (i.hasNext()) {
         i.next();
-        metrics_[i.value()->index()] = i.value()->value();
-        count_[i.value()->index()] = i.value()->count();
+        int index = i.value()->index();
+        if (computed_.testBit(index)) continue;
+
+        double value = i.value()->value();
+        double count = i.value()->count();
+
+        // clean any bad values
+        if (std::isinf(value) || std::isnan(value)) {
+            value = 0.00f;
+            count = 0.00f;
+        }
+        metrics_[index] = value;
+        count_[index] = count;
+
         double stdmean = i.value()->stdmean();
         double stdvariance = i.value()->stdvariance();
         if (stdmean || stdvariance) {
-            stdmean_.insert(i.value()->index(), stdmean);
-            stdvariance_.insert(i.value()->index(), stdvariance);
+            stdmean_.insert(index, stdmean);
+            stdvariance_.insert(index, stdvariance);
         }
+        computed_.setBit(index);
     }
 
-    // clean any bad values
-    for(int j=0; j<factory.metricCount(); j++)
-        if (std::isinf(metrics_[j]) || std::isnan(metrics_[j])) {
-            metrics_[j] = 0.00f;
-            count_[j] = 0.00f;
-        }
+    // anything we asked for but didn't get can't be computed, don't
+    // open the ride again each time it is asked for
+    foreach(QString symbol, todo) computed_.setBit(factory.rideMetric(symbol)->index());
+
+    // all of them, no need to track
+    if (computed_.count(false) == 0) computed_ = QBitArray();
+
+    // close if we opened it
+    if (doclose) rideItem_->close();
+    return true;
+}
+
+bool
+IntervalItem::isComputed(int index) const
+{
+    QMutexLocker locker(lock());
+    return computed_.isEmpty() || (index < computed_.size() && computed_.testBit(index));
+}
+
+bool
+IntervalItem::isPartial() const
+{
+    QMutexLocker locker(lock());
+    return !computed_.isEmpty() && computed_.count(false) > 0;
+}
+
+void
+IntervalItem::setPartial(bool partial)
+{
+    QMutexLocker locker(lock());
+    if (partial) computed_.fill(false, RideMetricFactory::instance().metricCount());
+    else computed_ = QBitArray();
 }
 
+void
+IntervalItem::setComputed(int index)
+{
+    QMutexLocker locker(lock());
+    if (index < computed_.size()) computed_.setBit(index);
+}
+
+void
+IntervalItem::want(int index)
+{
+    // compute it now if we haven't already, along with its dependencies
+    if (computed_.isEmpty() || index < 0 || index >= computed_.size() || computed_.testBit(index)) return;
+    compute(QStringList() << RideMetricFactory::instance().metricName(index));
+}
+
+double
+IntervalItem::getForMetric(int index)
+{
+    QMutexLocker locker(lock());
+    if (index < 0 || index >= metrics_.size()) return 0.0f;
+
+    want(index);
+    return metrics_[index];
+}
 
 double
 IntervalItem::getForSymbol(QString name, bool useMetricUnits)
 {
     const RideMetricFactory &factory = RideMetricFactory::instance();
+    QMutexLocker locker(lock());
     if (metrics_.size() && metrics_.size() == factory.metricCount()) {
 
         // return the precomputed metric value
         const RideMetric *m = factory.rideMetric(name);
         if (m) {
-            if (useMetricUnits) return metrics_[m->index()];
-            else {
-                // little hack to set/get for conversion
-                const_cast<RideMetric*>(m)->setValue(metrics_[m->index()]);
-                return m->value(useMetricUnits);
-            }
+            want(m->index());
+            return m->value(metrics_[m->index()], useMetricUnits);
         }
     }
     return 0.0f;
@@ -161,16 +290,17 @@ IntervalItem::getStringForSymbol(QString name, bool useMetricUnits)
     QString returning("-");
 
     const RideMetricFactory &factory = RideMetricFactory::instance();
+    QMutexLocker locker(lock());
     if (metrics_.size() && metrics_.size() == factory.metricCount()) {
 
         // return the precomputed metric value
         const RideMetric *m = factory.rideMetric(name);
         if (m) {
 
+            want(m->index());
             double value = metrics_[m->index()];
             if (std::isinf(value) || std::isnan(value)) value=0;
-            const_cast<RideMetric*>(m)->setValue(value);
-            returning = m->toString(useMetricUnits);
+            returning = m->toString(useMetricUnits, value);
         }
     }
     return returning;
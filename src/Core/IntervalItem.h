@@ -26,6 +26,8 @@
 #include <QDialog>
 #include <QLabel>
 #include <QLineEdit>
+#include <QBitArray>
+#include <QMutex>
 
 class IntervalItem
 {
@@ -73,18 +75,37 @@ class IntervalItem
         // order to show on plot
         void setDisplaySequence(int seq) { displaySequence = seq; }
 
-        // precomputed metrics
-        void refresh();
+        // precomputed metrics, refresh() only computes the few that are
+        // used everywhere unless asked for all of them, it won't open the
+        // ride so call it whilst it is open e.g. in RideItem::refresh. The
+        // rest are computed the first time they are asked for, along with
+        // their dependencies, opening the ride if needed
+        void refresh(bool all=false);
+        void computeAll();
         QVector<double> metrics_;
         QVector<double> count_;
         QMap <int, double>stdmean_;
         QMap <int, double>stdvariance_;
 
+        // which metrics_ are valid, the rest are zero until computed
+        bool isComputed(int index) const;
+        bool isPartial() const;
+        void setPartial(bool partial);        // e.g. when loading rideDB.json
+        void setComputed(int index);
+
+        // raw access, whatever has been computed so far, hold lock()
+        // if the ride might be refreshed whilst you look
         QVector<double> &metrics() { return metrics_; }
         QVector<double> &counts() { return count_; }
         QMap <int, double>&stdmeans() { return stdmean_; }
         QMap <int, double>&stdvariances() { return stdvariance_; }
 
+        // access the metric value by RideMetric::index()
+        double getForMetric(int index);
+
+        // the ride item's lock, NULL if we don't belong to one
+        QMutex *lock() const;
+
         // extracted sample data
         RideFileInterval *rideInterval;
 
@@ -92,6 +113,13 @@ class IntervalItem
         bool operator< (IntervalItem right) const {
             return (start < right.start);
         }
+
+    private:
+        bool compute(const QStringList &symbols); // with lock() held
+        void want(int index);
+
+        QBitArray computed_;                  // empty means all of them
+        bool computing_;
 };
 
 class RenameIntervalDialog : public QDialog
@@ -33,6 +33,8 @@
 #include "PaceZones.h"
 
 #include "JsonRideFile.h" // for DATETIME_FORMAT
+#include "NativeRideFile.h"
+#include "Settings.h" // for appsettings
 
 #ifdef SLOW_REFRESH
 #include "unistd.h"
@@ -56,6 +58,7 @@ RideCache::RideCache(Context *context) : context(context)
 
     progress_ = 100;
     exiting = false;
+    columnsVersion = -1;
     estimator = new Estimator(context);
 
     // initial load of user defined metrics - do once we have an initial context
@@ -146,6 +149,7 @@ RideCache::RideCache(Context *context) : context(context)
 
     // future watching
     connect(&watcher, SIGNAL(finished()), this, SLOT(garbageCollect()));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(refreshDone()));
     connect(&watcher, SIGNAL(finished()), this, SLOT(save()));
     connect(&watcher, SIGNAL(finished()), context, SLOT(notifyRefreshEnd()));
     connect(&watcher, SIGNAL(started()), context, SLOT(notifyRefreshStart()));
@@ -163,15 +167,38 @@ RideCache::~RideCache()
     save();
 }
 
+void
+RideCache::release()
+{
+    // last one out clears up anything removed whilst they were reading
+    if (!holds.deref()) garbageCollect();
+}
+
 void
 RideCache::garbageCollect()
 {
+    // still being read in the background, release() will do it
+    if (holds.load()) return;
+
     foreach(RideItem *item, delete_) {
         if (item) item->deleteLater();
     }
     delete_.clear();
 }
 
+void
+RideCache::refreshDone()
+{
+    // settings reads that still went to QSettings instead of the
+    // snapshot whilst refreshing, should be close to zero
+    int reads = appsettings->directReads(true);
+#ifdef GC_DEBUG
+    qDebug()<<"ridecache refresh: direct settings reads"<<reads;
+#else
+    Q_UNUSED(reads);
+#endif
+}
+
 void
 RideCache::initEstimates()
 {
@@ -271,6 +298,7 @@ RideCache::addRide(QString name, bool dosignal, bool select, bool useTempActivit
 
     // refresh metrics for *this ride only*
     last->refresh();
+    invalidateColumns();
 
     if (dosignal) context->notifyRideAdded(last); // here so emitted BEFORE rideSelected is emitted!
 
@@ -336,6 +364,7 @@ RideCache::removeCurrentRide()
     model_->startRemove(index);
     rides_.remove(index, 1);
     delete_<<todelete;
+    invalidateColumns();
     model_->endRemove(index);
 
     // delete the file by renaming it
@@ -349,6 +378,9 @@ RideCache::removeCurrentRide()
     // ignore errors since it probably isn't there.
     QFile::remove(context->athlete->home->fileBackup().canonicalPath() + "/" + strNewName);
 
+    // and its native copy
+    NativeFileReader::removeCache(context, file.fileName());
+
     if (!file.rename(context->athlete->home->fileBackup().canonicalPath() + "/" + strNewName)) {
         QMessageBox::critical(NULL, "Rename Error", tr("Can't rename %1 to %2 in %3")
             .arg(strOldFileName).arg(strNewName).arg(context->athlete->home->fileBackup().canonicalPath()));
@@ -502,6 +534,7 @@ RideCache::refresh()
     // start if there is work to do
     // and future watcher can notify of updates
     if (staleCount)  {
+        appsettings->directReads(true); // count them for this refresh
         reverse_ = rides_;
         qSort(reverse_.begin(), reverse_.end(), rideCacheGreaterThan);
         future = QtConcurrent::map(reverse_, itemRefresh);
@@ -517,6 +550,35 @@ RideCache::refresh()
     }
 }
 
+RideCacheColumn
+RideCache::getColumn(int index)
+{
+    QMutexLocker locker(&columnLock);
+
+    // rides or metrics changed since we last looked
+    int version = columnVersion.load();
+    if (version != columnsVersion) {
+        columns.clear();
+        columnsVersion = version;
+    }
+
+    QHash<int, RideCacheColumn>::const_iterator it = columns.constFind(index);
+    if (it != columns.constEnd() && it.value().values.count() == rides_.count()) return it.value();
+
+    RideCacheColumn column;
+    column.values.resize(rides_.count());
+    column.counts.resize(rides_.count());
+    for (int i=0; i<rides_.count(); i++) {
+        column.values[i] = rides_[i]->getForMetric(index);
+        column.counts[i] = rides_[i]->getCountForMetric(index);
+    }
+
+    // don't keep it if metrics were updated whilst we were building
+    if (columnVersion.load() == version) columns.insert(index, column);
+
+    return column;
+}
+
 QString
 RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, bool nofmt)
 {
@@ -527,82 +589,135 @@ RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, b
         return QString("%1 unknown").arg(name);
     }
 
+    return formatAggregate(name, getAggregates(QStringList() << name, spec).value(name, 0), useMetricUnits, nofmt);
+}
+
+QHash<QString, double>
+RideCache::getAggregates(QStringList names, Specification spec)
+{
+    RideMetricFactory &factory = RideMetricFactory::instance();
+    QHash<QString, double> returning;
+
+    // resolve the metrics once, not for every ride
+    QStringList symbols;
+    QVector<RideMetric::MetricType> types;
+    QVector<bool> aggZero, temp;
+    QVector<RideCacheColumn> values;
+    foreach(QString name, names) {
+
+        if (symbols.contains(name)) continue;
+
+        const RideMetric *metric = factory.rideMetric(name);
+        if (!metric) {
+            qDebug()<<"unknown metric:"<<name;
+            continue;
+        }
+
+        symbols << name;
+        types << metric->type();
+        aggZero << metric->aggregateZero();
+        temp << (name == "average_temp");
+        values << getColumn(metric->index());
+    }
+    RideCacheColumn durations = getColumn(factory.metricIndex("workout_time"));
+
     // what we will return
-    double rvalue = 0;
-    double rcount = 0; // using double to avoid rounding issues with int when dividing
+    int n = symbols.count();
+    QVector<double> rvalue(n, 0);
+    QVector<double> rcount(n, 0); // using double to avoid rounding issues with int when dividing
 
-    // loop through and aggregate
-    foreach (RideItem *item, rides()) {
+    int rides = qMin(rides_.count(), durations.values.count());
+    for (int j=0; j<n; j++) rides = qMin(rides, values[j].values.count());
+
+    // loop through and aggregate, filtering each ride just once
+    for (int i=0; i<rides; i++) {
 
         // skip filtered rides
-        if (!spec.pass(item)) continue;
+        if (!spec.pass(rides_[i])) continue;
 
-        // get this value
-        double value = item->getForSymbol(name);
-        double count = item->getForSymbol("workout_time"); // for averaging
+        double count = durations.values[i]; // for averaging
 
-        // check values are bounded, just in case
-        if (std::isnan(value) || std::isinf(value)) value = 0;
+        for (int j=0; j<n; j++) {
 
-        // do we aggregate zero values ?
-        bool aggZero = metric->aggregateZero();
+            // get this value
+            double value = values[j].values[i];
 
-        // set aggZero to false and value to zero if is temperature and -255
-        if (metric->symbol() == "average_temp" && value == RideFile::NA) {
-            value = 0;
-            aggZero = false;
-        }
+            // check values are bounded, just in case
+            if (std::isnan(value) || std::isinf(value)) value = 0;
 
-        switch (metric->type()) {
-        case RideMetric::RunningTotal:
-        case RideMetric::Total:
-            rvalue += value;
-            break;
-        default:
-        case RideMetric::Average:
-            {
-            // average should be calculated taking into account
-            // the duration of the ride, otherwise high value but
-            // short rides will skew the overall average
-            if (value || aggZero) {
-                rvalue += value*count;
-                rcount += count;
-            }
-            break;
-            }
-        case RideMetric::Low:
-            {
-            if (value < rvalue) rvalue = value;
-            break;
-            }
-        case RideMetric::Peak:
-            {
-            if (value > rvalue) rvalue = value;
-            break;
+            // do we aggregate zero values ?
+            bool aggzero = aggZero[j];
+
+            // set aggZero to false and value to zero if is temperature and -255
+            if (temp[j] && value == RideFile::NA) {
+                value = 0;
+                aggzero = false;
             }
-        case RideMetric::MeanSquareRoot:
-            {
-                rvalue = sqrt((pow(rvalue, 2)*rcount + pow(value,2)*count)/(rcount + count));
-                rcount += count;
+
+            switch (types[j]) {
+            case RideMetric::RunningTotal:
+            case RideMetric::Total:
+                rvalue[j] += value;
                 break;
+            default:
+            case RideMetric::Average:
+                {
+                // average should be calculated taking into account
+                // the duration of the ride, otherwise high value but
+                // short rides will skew the overall average
+                if (value || aggzero) {
+                    rvalue[j] += value*count;
+                    rcount[j] += count;
+                }
+                break;
+                }
+            case RideMetric::Low:
+                {
+                if (value < rvalue[j]) rvalue[j] = value;
+                break;
+                }
+            case RideMetric::Peak:
+                {
+                if (value > rvalue[j]) rvalue[j] = value;
+                break;
+                }
+            case RideMetric::MeanSquareRoot:
+                {
+                    rvalue[j] = sqrt((pow(rvalue[j], 2)*rcount[j] + pow(value,2)*count)/(rcount[j] + count));
+                    rcount[j] += count;
+                    break;
+                }
             }
         }
     }
 
-    // now compute the average
-    if (metric->type() == RideMetric::Average) {
-        if (rcount) rvalue = rvalue / rcount;
+    // now compute the averages
+    for (int j=0; j<n; j++) {
+        if (types[j] == RideMetric::Average && rcount[j]) rvalue[j] = rvalue[j] / rcount[j];
+        returning.insert(symbols[j], rvalue[j]);
     }
+    return returning;
+}
+
+QString
+RideCache::formatAggregate(QString name, double value, bool useMetricUnits, bool nofmt)
+{
+    const RideMetric *metric = RideMetricFactory::instance().rideMetric(name);
+    if (!metric) return QString("%1 unknown").arg(name);
 
-    const_cast<RideMetric*>(metric)->setValue(rvalue);
     // Format appropriately
     QString result;
-    if (metric->units(useMetricUnits) == "seconds" ||
-        metric->units(useMetricUnits) == tr("seconds")) {
-        if (nofmt) result = QString("%1").arg(rvalue);
-        else result = metric->toString(useMetricUnits);
+    if (nofmt && (metric->units(useMetricUnits) == "seconds" ||
+                  metric->units(useMetricUnits) == tr("seconds"))) {
+        result = QString("%1").arg(value);
 
-    } else result = metric->toString(useMetricUnits);
+    } else {
+        // the factory instance is shared, so format using our own copy
+        RideMetric *m = metric->clone();
+        m->setValue(value);
+        result = m->toString(useMetricUnits);
+        delete m;
+    }
 
     // 0 temp from aggregate means no values
     if ((metric->symbol() == "average_temp" || metric->symbol() == "max_temp") && result == "0.0") result = "-";
@@ -628,19 +743,21 @@ RideCache::getBests(QString symbol, int n, Specification specification, bool use
     const RideMetric *metric = RideMetricFactory::instance().rideMetric(symbol);
     if (!metric) return results;
 
+    RideCacheColumn values = getColumn(metric->index());
+
     // loop through and aggregate
-    foreach (RideItem *ride, rides_) {
+    for (int i=0; i<rides_.count() && i<values.values.count(); i++) {
 
         // skip filtered rides
+        RideItem *ride = rides_[i];
         if (!specification.pass(ride)) continue;
 
         // get this value
         AthleteBest add;
-        add.nvalue = ride->getForSymbol(symbol, true);
+        add.nvalue = values.values[i];
         add.date = ride->dateTime.date();
 
-        const_cast<RideMetric*>(metric)->setValue(add.nvalue);
-        add.value = metric->toString(useMetricUnits);
+        add.value = metric->toString(useMetricUnits, add.nvalue);
 
         // nil values are not needed
         if (add.nvalue < 0 || add.nvalue > 0) results << add;
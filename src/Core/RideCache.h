@@ -27,6 +27,8 @@
 
 #include <QVector>
 #include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
 
 #include <QFuture>
 #include <QFutureWatcher>
@@ -45,6 +47,13 @@ class RideCacheModel;
 class Estimator;
 class Banister;
 
+// a metric's values across all rides, in rides() order
+class RideCacheColumn
+{
+    public:
+        QVector<double> values, counts;
+};
+
 class RideCache : public QObject
 {
     Q_OBJECT
@@ -64,9 +73,24 @@ class RideCache : public QObject
 	    QList<QDateTime> getAllDates();
         QStringList getAllFilenames();
 
+        // columnar view of a metric across all rides, by RideMetric::index()
+        // so aggregating loops can scan an array instead of looking up by name
+        RideCacheColumn getColumn(int index);
+        void invalidateColumns() { columnVersion.ref(); }
+
+        // held whilst rides() is read on another thread, items removed
+        // meanwhile are not deleted until the last hold is released
+        void hold() { holds.ref(); }
+        void release();
+
         // get an aggregate applying the passed spec
         QString getAggregate(QString name, Specification spec, bool useMetricUnits, bool nofmt=false);
 
+        // aggregate many metrics in a single pass, the values are unformatted
+        // and in metric units, use formatAggregate() to display them
+        QHash<QString, double> getAggregates(QStringList names, Specification spec);
+        QString formatAggregate(QString name, double value, bool useMetricUnits, bool nofmt=false);
+
         // get top n bests
         QList<AthleteBest> getBests(QString symbol, int n, Specification specification, bool useMetricUnits=true);
 
@@ -121,6 +145,9 @@ class RideCache : public QObject
         // clear deleted objects
         void garbageCollect();
 
+        // background refresh completed
+        void refreshDone();
+
         // first run to initialise estimates
         void initEstimates();
 
@@ -152,6 +179,15 @@ class RideCache : public QObject
 
         Estimator *estimator;
         bool first; // updated when estimates are marked stale
+
+        // column cache, discarded when rides or their metrics change
+        QMutex columnLock;
+        QAtomicInt columnVersion;
+        int columnsVersion;
+        QHash<int, RideCacheColumn> columns;
+
+        // background readers, see hold()
+        QAtomicInt holds;
 };
 
 class AthleteBest
@@ -88,7 +88,7 @@ RideCacheModel::data(const QModelIndex &index, int role) const
 
                 // unpack metric value into ridemetric and use it to get a stringified
                 // version using the right metric/imperial conversion
-                RideMetric *m = const_cast<RideMetric*>(factory->rideMetric(factory->metricName(i)));
+                const RideMetric *m = factory->rideMetric(factory->metricName(i));
 
                 // bit of a kludge, but will return times as QTime,
                 // stuff with no decimal places as a number,
@@ -97,8 +97,8 @@ RideCacheModel::data(const QModelIndex &index, int role) const
                 if (m->isTime()) {
                     return QTime(0,0,0).addSecs(rideCache->rides().at(index.row())->metrics_[m->index()]);
                 } else if (m->units(true) != "km" && m->precision() > 0) {
-                    m->setValue(rideCache->rides().at(index.row())->metrics_[m->index()]);
-                    return m->toString(context->athlete->useMetricUnits); // string
+                    return m->toString(context->athlete->useMetricUnits,
+                                       rideCache->rides().at(index.row())->metrics_[m->index()]); // string
                 } else {
 
                     // make low precision numbers sort, including distance which we picked
@@ -123,6 +123,7 @@ ride: '{' rideelement_list '}'                                  {
                                                                     jc->interval.counts().fill(0.0f);
                                                                     jc->interval.stdmeans().clear();
                                                                     jc->interval.stdvariances().clear();
+                                                                    jc->interval.setPartial(false);
                                                                     jc->interval.route = QUuid();
                                                                     jc->item.clearIntervals();
                                                                     jc->item.overrides_.clear();
@@ -224,6 +225,7 @@ intervals_list: intervals_list ',' interval
 
 interval: '{' intervalelement_list '}'                          {
                                                                      jc->item.addInterval(jc->interval);
+                                                                    jc->interval.setPartial(false);
                                                                     jc->interval.metrics().fill(0.0f);
                                                                     jc->interval.counts().fill(0.0f);
                                                                     jc->interval.stdmeans().clear();
@@ -251,6 +253,7 @@ interval_tuple: string ':' string                               {
                                                                      else if ($1 == "seq") jc->interval.displaySequence = $3.toInt();
                                                                      else if ($1 == "route") jc->interval.route = QUuid($3);
                                                                      else if ($1 == "test") jc->interval.test = $3 == "true" ? true : false;
+                                                                     else if ($1 == "partial" && $3 == "true") jc->interval.setPartial(true);
                                                                 }
 
 interval_metrics: METRICS ':' '{' interval_metrics_list '}'                       ;
@@ -259,26 +262,29 @@ interval_metric: interval_metric_key ':' interval_metric_value
                                                                 { 
                                                                     const RideMetric *m = RideMetricFactory::instance().rideMetric($1);
                                                                     if (m) {
-                                                                        jc->interval.metrics()[m->index()] = $3.toDouble();
-                                                                        jc->interval.counts()[m->index()] = 0; /* we don't write zeroes */
+                                                                        jc->interval.metrics_[m->index()] = $3.toDouble();
+                                                                        jc->interval.count_[m->index()] = 0; /* we don't write zeroes */
+                                                                        jc->interval.setComputed(m->index());
                                                                     } else qDebug()<<"metric not found:"<<$1;
                                                                }
                | interval_metric_key ':' '[' interval_metric_value ',' interval_metric_count ']'
                                                                 {
                                                                     const RideMetric *m = RideMetricFactory::instance().rideMetric($1);
                                                                     if (m) {
-                                                                        jc->interval.metrics()[m->index()] = $4.toDouble();
-                                                                        jc->interval.counts()[m->index()] = $6.toDouble();
+                                                                        jc->interval.metrics_[m->index()] = $4.toDouble();
+                                                                        jc->interval.count_[m->index()] = $6.toDouble();
+                                                                        jc->interval.setComputed(m->index());
                                                                     } else qDebug()<<"metric not found:"<<$1;
                                                                }
                | interval_metric_key ':' '[' interval_metric_value ',' interval_metric_count ',' interval_metric_stdmean ',' interval_metric_stdvariance ']'
                                                                 {
                                                                     const RideMetric *m = RideMetricFactory::instance().rideMetric($1);
                                                                     if (m) {
-                                                                        jc->interval.metrics()[m->index()] = $4.toDouble();
-                                                                        jc->interval.counts()[m->index()] = $6.toDouble();
-                                                                        jc->interval.stdmeans().insert(m->index(), $8.toDouble());
-                                                                        jc->interval.stdvariances().insert(m->index(), $10.toDouble());
+                                                                        jc->interval.metrics_[m->index()] = $4.toDouble();
+                                                                        jc->interval.count_[m->index()] = $6.toDouble();
+                                                                        jc->interval.stdmean_.insert(m->index(), $8.toDouble());
+                                                                        jc->interval.stdvariance_.insert(m->index(), $10.toDouble());
+                                                                        jc->interval.setComputed(m->index());
                                                                     } else qDebug()<<"metric not found:"<<$1;
                                                                }
                ;
@@ -759,7 +765,9 @@ void RideCache::save(bool opendata, QString filename)
                 stream << "\n\t\t}";
             }
 
-            // intervals - but not for opendata
+            // intervals - but not for opendata, and not whilst they are
+            // being refreshed or are computing metrics on another thread
+            QMutexLocker intervalLocker(&item->rideLock);
             if (!opendata && item->intervals().count()) {
 
                 stream << ",\n\t\t\"INTERVALS\":[\n";
@@ -787,13 +795,18 @@ void RideCache::save(bool opendata, QString filename)
                         stream << "\t\t\t\"route\":\"" << interval->route.toString() <<"\",\n"; // last one no ',\n' see METRICS below..
                     }
 
+                    // only some of the metrics have been computed so far
+                    bool partial = interval->isPartial();
+                    if (partial) stream << "\t\t\t\"partial\":\"true\",\n";
+
                     stream << "\t\t\t\"seq\":\"" << interval->displaySequence <<"\""; // last one no ',\n' see METRICS below..
 
 
                     // check if we have any non-zero metrics
                     bool hasMetrics=false;
-                    foreach(double v, interval->metrics()) {
-                        if (v > 0.00f || v < 0.00f) {
+                    for(int i=0; i<interval->metrics_.count(); i++) {
+                        double v = interval->metrics_[i];
+                        if ((partial && interval->isComputed(i)) || v > 0.00f || v < 0.00f) {
                             hasMetrics=true;
                             break;
                         }
@@ -809,25 +822,27 @@ void RideCache::save(bool opendata, QString filename)
         
                             // don't output 0 values, they're set to 0 by default
                             // unless aggregateZero indicates the count is relevant
-                            if ((interval->metrics()[index] > 0.00f || interval->metrics()[index] < 0.00f) ||
-                                (item->metrics()[index] == 0.00f && item->counts()[i] > 1.0 && factory.rideMetric(name)->aggregateZero())) {
+                            // when partial every computed value is written, zero included
+                            if ((partial && interval->isComputed(index)) ||
+                                (!partial && (interval->metrics_[index] > 0.00f || interval->metrics_[index] < 0.00f)) ||
+                                (!partial && item->metrics()[index] == 0.00f && item->counts()[i] > 1.0 && factory.rideMetric(name)->aggregateZero())) {
                                 if (!firstMetric) stream << ",\n";
                                 firstMetric = false;
 
-                                if (interval->stdmeans().value(index, 0.0f) || interval->stdvariances().value(index, 0.0f)) {
+                                if (interval->stdmean_.value(index, 0.0f) || interval->stdvariance_.value(index, 0.0f)) {
 
-                                    stream << "\t\t\t\t\"" << name << "\": [ \"" << QString("%1").arg(interval->metrics()[index], 0, 'f', 5) <<"\",\""
-                                                                               << QString("%1").arg(interval->counts()[index], 0, 'f', 5) << "\",\""
-                                                                               << QString("%1").arg(interval->stdmeans().value(index, 0.0f), 0, 'f', 5) << "\",\""
-                                                                               << QString("%1").arg(interval->stdvariances().value(index, 0.0f), 0, 'f', 5) <<"\"]";
+                                    stream << "\t\t\t\t\"" << name << "\": [ \"" << QString("%1").arg(interval->metrics_[index], 0, 'f', 5) <<"\",\""
+                                                                               << QString("%1").arg(interval->count_[index], 0, 'f', 5) << "\",\""
+                                                                               << QString("%1").arg(interval->stdmean_.value(index, 0.0f), 0, 'f', 5) << "\",\""
+                                                                               << QString("%1").arg(interval->stdvariance_.value(index, 0.0f), 0, 'f', 5) <<"\"]";
 
                                 // if count is 0 don't write it
-                                } else if (interval->counts()[index] == 0) {
+                                } else if (interval->count_[index] == 0) {
                                     stream << ConstructNameNumberString(QString("\t\t\t\""), name,
-                                        QString("\":\""), interval->metrics()[index], QString("\""));
+                                        QString("\":\""), interval->metrics_[index], QString("\""));
                                 } else {
                                     stream << ConstructNameNumberNumberString(QString("\t\t\t\""), name,
-                                        QString("\":[\""), interval->metrics()[index], QString("\",\""), interval->counts()[index], QString("\"]"));
+                                        QString("\":[\""), interval->metrics_[index], QString("\",\""), interval->count_[index], QString("\"]"));
                                 }
                             }
                         }
@@ -24,6 +24,8 @@
 #include "IntervalItem.h"
 #include "Route.h"
 #include "Context.h"
+#include "Athlete.h"
+#include "RideCache.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include "PaceZones.h"
@@ -32,6 +34,7 @@
 #include "AddIntervalDialog.h" // till we fixup ridefilecache to have offsets
 #include "TimeUtils.h" // time_to_string()
 #include "WPrime.h" // for matches
+#include "Benchmark.h" // stage timings
 
 #include <cmath>
 #include <QtAlgorithms>
@@ -44,7 +47,7 @@
 // merge wizard and interval navigator
 RideItem::RideItem() 
     : 
-    ride_(NULL), fileCache_(NULL), context(NULL), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
+    ride_(NULL), fileCache_(NULL), rideLock(QMutex::Recursive), context(NULL), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
     color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
     count_.fill(0, RideMetricFactory::instance().metricCount());
@@ -52,7 +55,7 @@ RideItem::RideItem()
 
 RideItem::RideItem(RideFile *ride, Context *context) 
     : 
-    ride_(ride), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
+    ride_(ride), fileCache_(NULL), rideLock(QMutex::Recursive), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(""), fileName(""),
     color(QColor(1,1,1)), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
@@ -61,7 +64,7 @@ RideItem::RideItem(RideFile *ride, Context *context)
 
 RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context *context, bool planned)
     :
-    ride_(NULL), fileCache_(NULL), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(path), fileName(fileName),
+    ride_(NULL), fileCache_(NULL), rideLock(QMutex::Recursive), context(context), isdirty(false), isstale(true), isedit(false), skipsave(false), path(path), fileName(fileName),
     dateTime(dateTime), color(QColor(1,1,1)), planned(planned), isRun(false), isSwim(false), samples(false), zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0),
     metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0) 
 {
@@ -73,7 +76,7 @@ RideItem::RideItem(QString path, QString fileName, QDateTime &dateTime, Context
 // pre-computed metrics and storing ride metadata
 RideItem::RideItem(RideFile *ride, QDateTime &dateTime, Context *context)
     :
-    ride_(ride), fileCache_(NULL), context(context), isdirty(true), isstale(true), isedit(false), skipsave(false), dateTime(dateTime),
+    ride_(ride), fileCache_(NULL), rideLock(QMutex::Recursive), context(context), isdirty(true), isstale(true), isedit(false), skipsave(false), dateTime(dateTime),
     zoneRange(-1), hrZoneRange(-1), paceZoneRange(-1), fingerprint(0), metacrc(0), crc(0), timestamp(0), dbversion(0), udbversion(0), weight(0)
 {
     metrics_.fill(0, RideMetricFactory::instance().metricCount());
@@ -170,6 +173,10 @@ RideFile *RideItem::ride(bool open)
 {
     if (!open || ride_) return ride_;
 
+    // interval metrics may be opening us on another thread
+    QMutexLocker locker(&rideLock);
+    if (ride_) return ride_;
+
     // open the ride file
     QFile file(path + "/" + fileName);
     ride_ = RideFileFactory::instance().openRideFile(context, file, errors_);
@@ -257,8 +264,11 @@ RideItem::fileCache()
 void
 RideItem::setRide(RideFile *overwrite)
 {
+    // not whilst interval metrics are computing
+    rideLock.lock();
     RideFile *old = ride_;
     ride_ = overwrite; // overwrite
+    rideLock.unlock();
 
     // connect up to new one - if its not null
     if (ride_) {
@@ -309,6 +319,29 @@ RideItem::moveInterval(int from, int to)
     intervals_.move(from, to);
 }
 
+void
+RideItem::computeIntervalMetrics()
+{
+    QMutexLocker locker(&rideLock);
+
+    // anything left to do?
+    bool partial = false;
+    foreach(IntervalItem *interval, intervals_) if (interval->isPartial()) partial = true;
+    if (!partial) return;
+
+    // a stale ride will be refreshed, that replaces the intervals
+    bool doclose = false;
+    if (!isOpen()) {
+        if (isstale || path == "" || !ride()) return;
+        doclose = true;
+    }
+
+    foreach(IntervalItem *interval, intervals_) interval->computeAll();
+
+    // close if we opened it
+    if (doclose) close();
+}
+
 void
 RideItem::addInterval(IntervalItem item)
 {
@@ -432,6 +465,8 @@ RideItem::isOpen()
 void
 RideItem::close()
 {
+    QMutexLocker locker(&rideLock);
+
     // ride data
     if (ride_) {
         // break link to ride file
@@ -492,12 +527,12 @@ RideItem::checkStale()
 
             // get the new zone configuration fingerprint that applies for the ride date
             unsigned long rfingerprint = static_cast<unsigned long>(context->athlete->zones(isRun)->getFingerprint(dateTime.date()))
-                        + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(isRun)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
+                        + (appsettings->snapshot()->athlete(context->athlete->cyclist).useCPforFTP[isRun ? 1 : 0] ? 1 : 0)
                         + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
                         + static_cast<unsigned long>(context->athlete->hrZones(isRun)->getFingerprint(dateTime.date()))
                         + static_cast<unsigned long>(context->athlete->routes->getFingerprint())
                         + static_cast<unsigned long>(getHrvFingerprint())
-                        + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+                        + appsettings->snapshot()->athlete(context->athlete->cyclist).discovery; // 57 does not include search for PEAKS
 
             if (fingerprint != rfingerprint) {
 
@@ -542,6 +577,9 @@ RideItem::checkStale()
 void
 RideItem::refresh()
 {
+    // interval metrics may be computing on another thread
+    QMutexLocker locker(&rideLock);
+
     if (!isstale) return;
 
     // update current state coz we'll fix it below
@@ -551,12 +589,16 @@ RideItem::refresh()
     // already open since its a user entry point and will call
     // refresh when opened. We don't want a recursion here.
     // And if already open no need to close
+    QElapsedTimer timer;
+    if (Benchmark::enabled) timer.start();
+
     RideFile *f;
     bool doclose = false;
     if (!isOpen()) { 
         doclose = true;
         f = ride(); // will call us but isstale is false above
     } else f=ride_;
+    if (Benchmark::enabled) Benchmark::lap(Benchmark::Open, timer);
 
     if (f) {
 
@@ -633,17 +675,22 @@ RideItem::refresh()
                 count_[j] = 0.00f;
             }
 
+        // aggregated views of the metrics are now out of date
+        if (context->athlete && context->athlete->rideCache) context->athlete->rideCache->invalidateColumns();
+        if (Benchmark::enabled) Benchmark::lap(Benchmark::Metrics, timer);
+
         // Update auto intervals AFTER ridefilecache as used for bests
         updateIntervals();
+        if (Benchmark::enabled) Benchmark::lap(Benchmark::Intervals, timer);
 
         // update fingerprints etc, crc done above
         fingerprint = static_cast<unsigned long>(context->athlete->zones(isRun)->getFingerprint(dateTime.date()))
-                    + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(isRun)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
+                    + (appsettings->snapshot()->athlete(context->athlete->cyclist).useCPforFTP[isRun ? 1 : 0] ? 1 : 0)
                     + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
                     + static_cast<unsigned long>(context->athlete->hrZones(isRun)->getFingerprint(dateTime.date()))
                     + static_cast<unsigned long>(context->athlete->routes->getFingerprint()) +
                     + static_cast<unsigned long>(getHrvFingerprint())
-                    + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+                    + appsettings->snapshot()->athlete(context->athlete->cyclist).discovery; // 57 does not include search for PEAKS
 
         dbversion = DBSchemaVersion;
         udbversion = UserMetricSchemaVersion;
@@ -651,6 +698,7 @@ RideItem::refresh()
 
         // RideFile cache needs refreshing possibly
         RideFileCache updater(context, context->athlete->home->activities().canonicalPath() + "/" + fileName, getWeight(), ride_, true);
+        if (Benchmark::enabled) Benchmark::lap(Benchmark::Cache, timer);
 
         // we now match
         metacrc = metaCRC();
@@ -696,7 +744,7 @@ RideItem::getWeight(int type)
         if (weight <= 0.00) weight = metadata_.value("Weight", "0.0").toDouble();
 
         // global options and if not set default to 75 kg.
-        if (weight <= 0.00) weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble();
+        if (weight <= 0.00) weight = appsettings->snapshot()->athlete(context->athlete->cyclist).weight;
 
         // No weight default is weird, we'll set to 80kg
         if (weight <= 0.00) weight = 80.00;
@@ -734,35 +782,39 @@ RideItem::getHrvFingerprint()
 
 double
 RideItem::getForSymbol(QString name, bool useMetricUnits)
+{
+    return getForMetric(RideMetricFactory::instance().metricIndex(name), useMetricUnits);
+}
+
+double
+RideItem::getForMetric(int index, bool useMetricUnits)
 {
     const RideMetricFactory &factory = RideMetricFactory::instance();
-    if (metrics_.size() && metrics_.size() == factory.metricCount()) {
+    if (index >= 0 && metrics_.size() && metrics_.size() == factory.metricCount()) {
         // return the precomputed metric value
-        const RideMetric *m = factory.rideMetric(name);
-        if (m) {
-            if (useMetricUnits) return metrics_[m->index()];
-            else {
-                // little hack to set/get for conversion
-                const_cast<RideMetric*>(m)->setValue(metrics_[m->index()]);
-                return m->value(useMetricUnits);
-            }
-        }
+        if (useMetricUnits) return metrics_[index];
+
+        // convert without touching the shared metric
+        const RideMetric *m = factory.rideMetricAt(index);
+        if (m) return m->value(metrics_[index], useMetricUnits);
     }
     return 0.0f;
 }
 
 double
 RideItem::getCountForSymbol(QString name)
+{
+    return getCountForMetric(RideMetricFactory::instance().metricIndex(name));
+}
+
+double
+RideItem::getCountForMetric(int index)
 {
     const RideMetricFactory &factory = RideMetricFactory::instance();
-    if (metrics_.size() && metrics_.size() == factory.metricCount()) {
-        // return the precomputed metric value
-        const RideMetric *m = factory.rideMetric(name);
-        if (m)  {
-            // don't return zero (!)
-            double returning = count_[m->index()];
-            return returning ? returning : 1;
-        }
+    if (index >= 0 && metrics_.size() && metrics_.size() == factory.metricCount()) {
+        // don't return zero (!)
+        double returning = count_[index];
+        return returning ? returning : 1;
     }
     // don't return zero, thats impossible
     return 1.0f;
@@ -812,8 +864,7 @@ RideItem::getStringForSymbol(QString name, bool useMetricUnits)
 
             double value = metrics_[m->index()];
             if (std::isinf(value) || std::isnan(value)) value=0;
-            const_cast<RideMetric*>(m)->setValue(value);
-            returning = m->toString(useMetricUnits);
+            returning = m->toString(useMetricUnits, value);
         }
     }
     return returning;
@@ -834,7 +885,7 @@ void
 RideItem::updateIntervals()
 {
     // what do we need ?
-    int discovery = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+    int discovery = appsettings->snapshot()->athlete(context->athlete->cyclist).discovery; // 57 does not include search for PEAKS
 
     // DO NOT USE ride() since it will call a refresh !
     RideFile *f = ride_;
@@ -954,11 +1005,17 @@ RideItem::updateIntervals()
                                 tr("1 minute"), tr("5 minutes"), tr("10 minutes"), tr("20 minutes"), tr("30 minutes"), tr("45 minutes"),
                                 tr("1 hour") };
     
+        // go hunting for best peaks, all in one pass
+        QVector<double> sizes;
+        for(int i=0; durations[i] != 0; i++) sizes << durations[i];
+        QVector<AddIntervalDialog::AddedInterval> peaks;
+        QVector<bool> found;
+        AddIntervalDialog::findPeakWindows(true, f, Specification(), RideFile::watts, sizes, peaks, found);
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
             QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::watts, RideFile::original, durations[i], 1, results, "", "");
+            if (found[i]) results << peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -988,12 +1045,19 @@ RideItem::updateIntervals()
                                 tr("1 minute"), tr("5 minutes"), tr("10 minutes"), tr("20 minutes"), tr("30 minutes"), tr("45 minutes"),
                                 tr("1 hour") };
 
-        bool metric = appsettings->value(this, context->athlete->paceZones(f->isSwim())->paceSetting(), true).toBool();
+        bool metric = f->isSwim() ? appsettings->snapshot()->metricSwimPace : appsettings->snapshot()->metricRunPace;
+
+        // go hunting for best peaks, all in one pass
+        QVector<double> sizes;
+        for(int i=0; durations[i] != 0; i++) sizes << durations[i];
+        QVector<AddIntervalDialog::AddedInterval> peaks;
+        QVector<bool> found;
+        AddIntervalDialog::findPeakWindows(true, f, Specification(), RideFile::kph, sizes, peaks, found);
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
             QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::kph, RideFile::original, durations[i], 1, results, "", "");
+            if (found[i]) results << peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -28,6 +28,7 @@
 #include <QString>
 #include <QMap>
 #include <QVector>
+#include <QMutex>
 
 class RideFile;
 class RideFileCache;
@@ -77,6 +78,10 @@ class RideItem : public QObject
 
         // got any intervals
         QList<IntervalItem*> intervals_;
+
+        // held whilst the ride is opened, refreshed or closed and
+        // whilst interval metrics are computed, see IntervalItem::lock()
+        QMutex rideLock;
         QStringList errors_;
 
         // userdata cache
@@ -112,6 +117,10 @@ class RideItem : public QObject
         // set metric values e.g. when working with intervals
         void setFrom(QHash<QString, RideMetricPtr>);
 
+        // compute all the interval metrics refresh didn't, opening the
+        // ride once for all of them, e.g. before exporting every metric
+        void computeIntervalMetrics();
+
         // add interval e.g. during load of rideDB.json
         void addInterval(IntervalItem interval);
         void clearIntervals() { intervals_.clear(); } // does NOT delete them
@@ -123,6 +132,12 @@ class RideItem : public QObject
         double getForSymbol(QString name, bool useMetricUnits=true);
         double getCountForSymbol(QString name);
 
+        // access the metric value by RideMetric::index(), these avoid the
+        // name lookup and are safe to call from multiple threads
+        double getForMetric(int index, bool useMetricUnits=true);
+        double getCountForMetric(int index);
+        double getStdMeanForMetric(int index) { return stdmean_.value(index, 0.0f); }
+
         // access the stdmean and stdvariance value
         double getStdMeanForSymbol(QString name);
         double getStdVarianceForSymbol(QString name);
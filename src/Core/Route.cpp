@@ -102,7 +102,7 @@ RouteSegment::setMaxLon(double _maxLon) {
     maxLon = _maxLon;
 }
 
-QList<RoutePoint> RouteSegment::getPoints() {
+const QList<RoutePoint> &RouteSegment::getPoints() const {
     return points;
 }
 
@@ -142,8 +142,8 @@ RouteSegment::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
     int lastpoint = -1; // Last point to match
     double start = -1, stop = -1; // Start and stop secs
 
-    for (int n=0; n< this->getPoints().count();n++) {
-        RoutePoint routepoint = this->getPoints().at(n);
+    for (int n=0; n< points.count();n++) {
+        const RoutePoint &routepoint = points.at(n);
 
         bool present = false;
         RideFilePoint* point;
@@ -248,7 +248,7 @@ RouteSegment::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
         
         stop = point->secs;
         
-        if (n == this->getPoints().count()-1) {
+        if (n == points.count()-1) {
 
             // Add the interval and continue search
             //qDebug() << "    >>> Route identified in ride: " << name << " start: " << start << " stop: " << stop << " (distance " << precision << "km)\r\n";
@@ -277,6 +277,60 @@ RouteSegment::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
 }
 
 
+// search() can only succeed if the ride went within 100m of both the
+// first and the last point of the segment, check that on the grid
+bool
+RouteSegment::couldMatch(const RouteGrid &grid) const
+{
+    if (points.isEmpty()) return false;
+    return grid.near(points.first().lat, points.first().lon) &&
+           grid.near(points.last().lat, points.last().lon);
+}
+
+/*
+ * RouteGrid
+ *
+ */
+
+// cells are 0.002 degrees, about 220m, and we check the neighbouring
+// cells too, so anything within the 100m search precision is found
+static const double gridCell = 0.002;
+
+RouteGrid::RouteGrid(const RideFile *ride) : scale(1.0)
+{
+    // longitude degrees shrink towards the poles, size cells for the
+    // highest latitude so they are never narrower than gridCell of latitude
+    double maxabslat = 0;
+    foreach(const RideFilePoint *point, ride->dataPoints()) {
+        if (point->lat != 0 && point->lon != 0 &&
+            ceil(point->lat) != 180 && ceil(point->lon) != 180 &&
+            ceil(point->lat) != 540 && ceil(point->lon) != 540 &&
+            fabs(point->lat) > maxabslat)
+            maxabslat = fabs(point->lat);
+    }
+    scale = qMax(0.01, cos(maxabslat * pi / 180));
+
+    cells.reserve(ride->dataPoints().count() / 10);
+    foreach(const RideFilePoint *point, ride->dataPoints()) {
+        if (point->lat != 0 && point->lon != 0 &&
+            ceil(point->lat) != 180 && ceil(point->lon) != 180 &&
+            ceil(point->lat) != 540 && ceil(point->lon) != 540)
+            cells.insert(key(floor(point->lon * scale / gridCell), floor(point->lat / gridCell)));
+    }
+}
+
+bool
+RouteGrid::near(double lat, double lon) const
+{
+    qint32 x = floor(lon * scale / gridCell);
+    qint32 y = floor(lat / gridCell);
+
+    for (int dx=-1; dx<=1; dx++)
+        for (int dy=-1; dy<=1; dy++)
+            if (cells.contains(key(x+dx, y+dy))) return true;
+    return false;
+}
+
 //  This function converts decimal degrees to radians
 double deg2rad(double deg) {
   return (deg * pi / 180);
@@ -406,18 +460,30 @@ Routes::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
 {
     if (ride) {
 
+        double minLat = ride->getMinPoint(RideFile::lat).toDouble();
+        double maxLat = ride->getMaxPoint(RideFile::lat).toDouble();
+        double minLon = ride->getMinPoint(RideFile::lon).toDouble();
+        double maxLon = ride->getMaxPoint(RideFile::lon).toDouble();
+
+        // only built if a segment gets past the bounding box check
+        RouteGrid *grid = NULL;
+
         // search all segments
         for (int routecount=0;routecount<routes.count();routecount++) {
             RouteSegment *segment = &routes[routecount];
 
             // The third decimal place is worth up to 110 m
-            if (ride->getMinPoint(RideFile::lat).toDouble()<segment->getMinLat()+0.001 &&
-                ride->getMaxPoint(RideFile::lat).toDouble()>segment->getMaxLat()-0.001 &&
-                ride->getMinPoint(RideFile::lon).toDouble()<segment->getMinLon()+0.001 &&
-                ride->getMaxPoint(RideFile::lon).toDouble()>segment->getMaxLon()-0.001   )
-
-            segment->search(item, ride, here);
+            if (minLat<segment->getMinLat()+0.001 &&
+                maxLat>segment->getMaxLat()-0.001 &&
+                minLon<segment->getMinLon()+0.001 &&
+                maxLon>segment->getMaxLon()-0.001   ) {
+
+                // did the ride actually go near the start and end?
+                if (grid == NULL) grid = new RouteGrid(ride);
+                if (segment->couldMatch(*grid)) segment->search(item, ride, here);
+            }
         }
+        delete grid;
     }
 }
 
@@ -25,13 +25,32 @@
 #include <QString>
 #include <QDate>
 #include <QFile>
+#include <QSet>
 
 #include "Context.h"
 
 class  RideFile;
 class  Routes;
+class  Benchmark;
 struct RoutePoint;
 
+class RouteGrid // coarse grid of where a ride went, to reject segments cheaply
+{
+    public:
+
+        RouteGrid(const RideFile *ride);
+
+        // is there a ride point within a cell of this location?
+        bool near(double lat, double lon) const;
+
+    private:
+
+        static quint64 key(qint32 x, qint32 y) { return (quint64(quint32(x)) << 32) | quint32(y); }
+
+        QSet<quint64> cells;
+        double scale; // longitude cells are widened by latitude
+};
+
 class RouteSegment // represents a segment we match against
 {
     public:
@@ -43,7 +62,7 @@ class RouteSegment // represents a segment we match against
         QString getName();
         void setName(QString _name);
         QUuid id() const { return _id; }
-        QList<RoutePoint> getPoints();
+        const QList<RoutePoint> &getPoints() const;
         void setId(QUuid x) { _id = x; }
 
         double getMinLat();
@@ -61,6 +80,7 @@ class RouteSegment // represents a segment we match against
 
         // find segments in ridefiles
         void search(RideItem *, RideFile*, QList<IntervalItem*>&);
+        bool couldMatch(const RouteGrid &grid) const;
 
     private:
 
@@ -88,6 +108,7 @@ class Routes : public QObject { // top-level object with API and map of segments
     Q_OBJECT;
 
     friend class ::RideItem; // access the route/ride map
+    friend class ::Benchmark; // synthetic routes
 
     public:
 
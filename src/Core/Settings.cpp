@@ -100,24 +100,34 @@ static QString DetermineKey(QString & key, int& store, int& fileIndex) {
 
 // -----------------------------constructor and public instance methods ------------------------//
 
-GSettings::GSettings(QString org, QString app) : newFormat(true){
+GSettings::GSettings(QString org, QString app) : newFormat(true), current(new GSettingsSnapshot()) {
     oldsystemsettings = new QSettings(org,app);
     systemsettings = new QSettings(QSettings::IniFormat, QSettings::UserScope, org, app);
     global = new QVector<QSettings*>();
 }
 
-GSettings::GSettings(QString file, QSettings::Format format) : newFormat(false){
+GSettings::GSettings(QString file, QSettings::Format format) : newFormat(false), current(new GSettingsSnapshot()) {
     systemsettings = new QSettings(file,format);
+    refreshSnapshot();
 }
 
 GSettings::~GSettings() {
     syncQSettings();
+    delete current.load();
+    foreach(const GSettingsSnapshot *old, retired) delete old;
 }
 
 
 QVariant
 GSettings::value(const QObject * /*me*/, const QString key, const QVariant def) {
 
+    reads.fetchAndAddRelaxed(1);
+    return read(key, def);
+}
+
+QVariant
+GSettings::read(const QString key, const QVariant def) {
+
     QString keyVar = QString(key);
     if (newFormat) {
         int store;
@@ -167,12 +177,20 @@ GSettings::setValue(QString key, QVariant value)
         systemsettings->setValue(keyVar, value);
     }
 
+    if (isSnapshotKey(key)) refreshSnapshot();
 }
 
 // access to athlete specific config
 QVariant
 GSettings::cvalue(QString athleteName, QString key, QVariant def) {
 
+    reads.fetchAndAddRelaxed(1);
+    return cread(athleteName, key, def);
+}
+
+QVariant
+GSettings::cread(QString athleteName, const QString key, const QVariant def) {
+
     if (athleteName.isNull() || athleteName.isEmpty()) return def;
 
     QString keyVar = QString(key);
@@ -231,6 +249,60 @@ GSettings::setCValue(QString athleteName, QString key, QVariant value) {
         systemsettings->setValue(athleteName + "/" + keyVar,value);
 
     }
+
+    if (isSnapshotKey(key)) refreshSnapshot(athleteName);
+}
+
+// the settings captured in GSettingsSnapshot
+bool
+GSettings::isSnapshotKey(const QString &key) const {
+
+    return key == GC_PACE || key == GC_SWIMPACE || key == GC_WBALFORM || key == GC_ELEVATION_HYSTERESIS ||
+           key == GC_DISCOVERY || key == GC_WBALTAU || key == GC_SEX || key == GC_WEIGHT || key == GC_DOB ||
+           key == GC_USE_CP_FOR_FTP || key == GC_USE_CP_FOR_FTP_RUN;
+}
+
+void
+GSettings::refreshSnapshot(QString athleteName) {
+
+    QMutexLocker locker(&snapshotLock);
+
+    if (!athleteName.isEmpty() && !snapshotAthletes.contains(athleteName))
+        snapshotAthletes << athleteName;
+
+    const GSettingsSnapshot *old = current.loadAcquire();
+    GSettingsSnapshot *update = new GSettingsSnapshot();
+    update->version = old->version + 1;
+
+    // global settings are not available until the athlete dir is known
+    if (!newFormat || !global->isEmpty()) {
+        update->metricRunPace = read(GC_PACE, true).toBool();
+        update->metricSwimPace = read(GC_SWIMPACE, true).toBool();
+        update->wbalIntegral = (read(GC_WBALFORM, "int").toString() == "int");
+        update->elevationHysteresis = read(GC_ELEVATION_HYSTERESIS, 0).toDouble();
+    }
+
+    foreach(QString name, snapshotAthletes) {
+        GSettingsSnapshot::AthleteSettings a;
+        a.discovery = cread(name, GC_DISCOVERY, 57).toInt();
+        a.wbaltau = cread(name, GC_WBALTAU, 300).toInt();
+        a.sex = cread(name, GC_SEX, 0).toInt();
+        a.weight = cread(name, GC_WEIGHT, "75.0").toString().toDouble();
+        a.dob = cread(name, GC_DOB, 0).toDate();
+        a.useCPforFTP[0] = cread(name, GC_USE_CP_FOR_FTP, 0).toInt();
+        a.useCPforFTP[1] = cread(name, GC_USE_CP_FOR_FTP_RUN, 0).toInt();
+        update->athletes.insert(name, a);
+    }
+
+    // readers may still be looking at the old one
+    current.storeRelease(update);
+    retired << old;
+}
+
+int
+GSettings::directReads(bool reset) {
+
+    return reset ? reads.fetchAndStoreRelaxed(0) : reads.loadAcquire();
 }
 
 // other functions unsed from QSettings which GSettings needs to implement
@@ -349,6 +421,7 @@ GSettings::initializeQSettingsGlobal(QString athletesRootDir) {
         upgradeGlobal();
     }
     syncQSettingsGlobal();
+    refreshSnapshot();
 
 }
 
@@ -387,6 +460,7 @@ GSettings::initializeQSettingsAthlete(QString athletesRootDir, QString athleteNa
             }
         }
         syncQSettingsAllAthletes();
+        refreshSnapshot(athleteName);
     }
 }
 
@@ -450,6 +524,9 @@ GSettings::clearGlobalAndAthletes() {
     syncQSettings();
     global->clear();
     athlete.clear();
+
+    QMutexLocker locker(&snapshotLock);
+    snapshotAthletes.clear();
 }
 
 
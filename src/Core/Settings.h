@@ -276,6 +276,7 @@
 #define GC_AUTOBACKUP_FOLDER            "<athlete-preferences>autobackup/folder"
 #define GC_AUTOBACKUP_PERIOD            "<athlete-preferences>autobackup/period"                  // how often is the Athlete Folder backuped up / 0 == never
 #define GC_AUTOBACKUP_COUNTER           "<athlete-preferences>autobackup/counter"                 // counts to the next backup
+#define GC_AUTOBACKUP_INCREMENTAL       "<athlete-preferences>autobackup/incremental"             // auto backup to an incremental store, not a .zip
 
 #define GC_CLOUDDB_TC_ACCEPTANCE       "<athlete-preferences>clouddb/acceptance"                  // bool
 #define GC_CLOUDDB_TC_ACCEPTANCE_DATE  "<athlete-preferences>clouddb/acceptancedate"              // date/time string of acceptance
@@ -387,6 +388,10 @@
 // --------------------------------------------------------------------------------
 #include <QSettings>
 #include <QFileInfo>
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QDate>
 
 // Helper Class for the Athlete QSettings
 
@@ -405,6 +410,51 @@ class AthleteQSettings {
 };
 
 
+// Immutable copy of the settings that are read in the hot paths, e.g.
+// metric computation and RideItem::refresh() on the worker threads. The
+// values are parsed once on the GUI thread so readers never need to go
+// through DetermineKey() and QSettings, or take a lock. A new snapshot is
+// published whenever one of the settings below changes.
+
+class GSettingsSnapshot {
+    public:
+
+      class AthleteSettings {
+          public:
+            AthleteSettings() : discovery(57), wbaltau(300), sex(0), weight(75.0) {
+                useCPforFTP[0] = useCPforFTP[1] = 0;
+            }
+
+            int discovery;      // GC_DISCOVERY, 57 does not include search for PEAKS
+            int wbaltau;        // GC_WBALTAU
+            int sex;            // GC_SEX, 0=male 1=female
+            double weight;      // GC_WEIGHT
+            QDate dob;          // GC_DOB
+            int useCPforFTP[2]; // GC_USE_CP_FOR_FTP, GC_USE_CP_FOR_FTP_RUN (indexed by isRun)
+      };
+
+      GSettingsSnapshot() : version(0), metricRunPace(true), metricSwimPace(true),
+                            wbalIntegral(true), elevationHysteresis(0) {}
+
+      // settings for the athlete, defaults if we haven't seen them yet
+      const AthleteSettings &athlete(const QString &name) const {
+          QHash<QString, AthleteSettings>::const_iterator i = athletes.find(name);
+          return i == athletes.end() ? defaults : i.value();
+      }
+
+      int version;
+
+      // global
+      bool metricRunPace;         // GC_PACE
+      bool metricSwimPace;        // GC_SWIMPACE
+      bool wbalIntegral;          // GC_WBALFORM == "int"
+      double elevationHysteresis; // GC_ELEVATION_HYSTERESIS
+
+      // athlete specific
+      QHash<QString, AthleteSettings> athletes;
+      AthleteSettings defaults;
+};
+
 // wrap the standard QSettings so we can offer members
 // to get global or atheleteName specific settings
 // via value() and cvalue()
@@ -446,13 +496,35 @@ public:
     // Cleanup if AthleteDir is changed
     void clearGlobalAndAthletes();
 
+    // lock free access to the hot path settings, the pointer remains
+    // valid for the life of the application, so workers can hold it
+    const GSettingsSnapshot *snapshot() const { return current.loadAcquire(); }
+
+    // rebuild the snapshot after config changes, will also
+    // include the athlete from now on if one is passed
+    void refreshSnapshot(QString athleteName = QString());
+
+    // number of calls to value() and cvalue() since last reset
+    int directReads(bool reset = false);
+
 private:
+    // the non-counting readers behind value() and cvalue()
+    QVariant read(const QString key, const QVariant def);
+    QVariant cread(QString athleteName, const QString key, const QVariant def);
+    bool isSnapshotKey(const QString &key) const;
+
     bool newFormat;
     QSettings *systemsettings;
     QSettings *oldsystemsettings;
     QVector<QSettings*> *global;
     QHash<QString, AthleteQSettings*> athlete;
 
+    QMutex snapshotLock; // serialises writers only
+    QAtomicPointer<const GSettingsSnapshot> current;
+    QList<const GSettingsSnapshot*> retired; // readers may still hold them
+    QStringList snapshotAthletes;
+    QAtomicInt reads;
+
     // special methods for Migration/Upgrade
     void migrateValue(QString key);
     void migrateCValue(QString athleteName, QString key);
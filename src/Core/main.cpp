@@ -26,11 +26,13 @@
 #include "GcUpgrade.h"
 #include "IdleTimer.h"
 #include "PowerProfile.h"
+#include "Benchmark.h"
 
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QtGui>
 #include <QFile>
+#include <QProcess>
 #ifndef NOWEBKIT
 #include <QWebSettings>
 #endif
@@ -46,6 +48,7 @@
 #ifdef GC_WANT_PYTHON
 #include "PythonEmbed.h"
 #include "FixPySettings.h"
+#include "FixPyRunner.h"
 #endif
 #include <signal.h>
 
@@ -189,6 +192,7 @@ main(int argc, char *argv[])
     for (int i=0; i<argc; i++) sargs << argv[i];
 #ifdef GC_WANT_PYTHON
     bool noPy=false;
+    bool fixWorker=false;
 #endif
 #ifdef GC_WANT_R
     bool noR=false;
@@ -199,6 +203,7 @@ main(int argc, char *argv[])
     bool debug = false;
 #endif
     bool server = false;
+    bool benchmark = false;
     nogui = false;
     bool help = false;
 
@@ -228,6 +233,7 @@ main(int argc, char *argv[])
 #ifdef GC_WANT_R
             fprintf(stderr, "--no-r              to disable R startup\n");
 #endif
+            fprintf(stderr, "--benchmark         to time import, refresh, sync, python fixes and workout playback of [folder] [copies] of the test activities and exit\n");
             fprintf (stderr, "\nSpecify the folder and/or athlete to open on startup\n");
             fprintf(stderr, "If no parameters are passed it will reopen the last athlete.\n\n");
 
@@ -243,12 +249,24 @@ main(int argc, char *argv[])
         } else if (arg == "--no-python") {
 
             noPy = true;
+
+        } else if (arg == "--fix-worker") {
+
+            // not for users, started by FixPyRunner::runAll
+            nogui = fixWorker = true;
 #endif
 #ifdef GC_WANT_R
         } else if (arg == "--no-r") {
 
             noR = true;
 #endif
+        } else if (arg == "--benchmark") {
+
+            nogui = benchmark = true;
+#ifdef GC_WANT_R
+            noR = true;
+#endif
+
         } else if (arg == "--debug") {
 
 #ifdef GC_DEBUG
@@ -324,8 +342,28 @@ main(int argc, char *argv[])
     unsetenv("QT_SCALE_FACTOR");
 #endif
 
+    // no display needed when benchmarking
+    bool headless = benchmark;
+#ifdef GC_WANT_PYTHON
+    if (fixWorker) headless = true;
+#endif
+    if (headless && qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+
     // create the application -- only ever ONE regardless of restarts
     application = new QApplication(argc, argv);
+
+#ifdef GC_WANT_PYTHON
+    // run fix scripts on the rides we were given and exit
+    if (fixWorker) {
+        // check first, there is nobody to answer the not installed dialog
+        QString pybin, pypath;
+        QString home = appsettings->value(NULL, GC_PYTHON_HOME, "").toString();
+        if (home == "") home = QProcessEnvironment::systemEnvironment().value("PYTHONHOME", "");
+        if (PythonEmbed::pythonInstalled(pybin, pypath, home)) python = new PythonEmbed();
+        if (python == NULL || python->loaded == false) exit(1);
+        exit(FixPyRunner::worker(args.mid(1)));
+    }
+#endif
     //XXXIdleEventFilter idleFilter;
     //XXXapplication->installEventFilter(&idleFilter);
 
@@ -446,6 +484,9 @@ main(int argc, char *argv[])
 
 #ifdef GC_WANT_PYTHON
         bool embed = appsettings->value(NULL, GC_EMBED_PYTHON, true).toBool();
+        // nobody to answer the not installed dialog when benchmarking
+        QString pybin, pypath;
+        if (benchmark && !PythonEmbed::pythonInstalled(pybin, pypath)) embed = false;
         if (embed && noPy == false && python == NULL) {
             python = new PythonEmbed(); // initialise python in this thread ?
             if (python->loaded == false) python=NULL;
@@ -545,6 +586,12 @@ main(int argc, char *argv[])
         // initialise the trainDB
         trainDB = new TrainDB(home);
 
+        // headless benchmark, report and exit
+        if (benchmark) {
+            ret = Benchmark::run(args.count() > 1 ? args.at(1) : QString("test"), args.count() > 2 ? args.at(2).toInt() : 10);
+            exit(ret);
+        }
+
         // lets do what the command line says ...
         QVariant lastOpened;
         if(args.count() == 2) { // $ ./GoldenCheetah Mark -or- ./GoldenCheetah --server ~/athletedir
@@ -19,6 +19,11 @@
 #include <QProgressDialog>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QRegExp>
 #if QT_VERSION > 0x050400
 #include <QStorageInfo>
 #endif
@@ -31,6 +36,11 @@
 #include "../qzip/zipwriter.h"
 #include "../qzip/zipreader.h"
 
+// incremental store layout, chunks are split on a fixed size so an
+// appended or partly rewritten file only adds the chunks that changed
+static const qint64 backupChunkSize = 1024 * 1024;
+static const char *backupChunkFolder = "chunks";
+static const char *backupSnapshotFolder = "snapshots";
 
 
 AthleteBackup::AthleteBackup(QDir athleteHome)
@@ -70,7 +80,10 @@ AthleteBackup::backupOnClose()
         return;
     }
 
-    backup(tr("Abort Backup and Reset Counter"));
+    if (appsettings->cvalue(athlete, GC_AUTOBACKUP_INCREMENTAL, true).toBool())
+        backupIncremental(tr("Abort Backup and Reset Counter"));
+    else
+        backup(tr("Abort Backup and Reset Counter"));
 
     appsettings->setCValue(athlete, GC_AUTOBACKUP_COUNTER, 0);
 
@@ -215,4 +228,287 @@ AthleteBackup::backup(QString progressText)
 
 }
 
+bool
+AthleteBackup::backupIncremental(QString progressText)
+{
+    QDir checkDir(backupFolder);
+    if (!checkDir.exists()) {
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Directory %1 not available. No backup created for athlete %2.").arg(backupFolder).arg(athlete));
+        return false;
+    }
+
+    // one store per athlete
+    QDir store(backupFolder + "/GC_" + athlete + "_backup");
+    if (!store.exists() && !checkDir.mkpath(store.absolutePath())) {
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup store %1 cannot be created.").arg(store.absolutePath()));
+        return false;
+    }
+    store.mkpath(backupChunkFolder);
+    store.mkpath(backupSnapshotFolder);
+
+    // the latest snapshot tells us which files are unchanged, so we
+    // only need to read and hash files that are new or were modified
+    QHash<QString, BackupEntry> previous;
+    QStringList snapshots = QDir(store.absoluteFilePath(backupSnapshotFolder)).entryList(QStringList() << "*.json", QDir::Files, QDir::Name);
+    if (snapshots.count()) readSnapshot(store.absoluteFilePath(QString(backupSnapshotFolder) + "/" + snapshots.last()), previous);
+
+    QList<QFileInfo> files;
+    QStringList paths;
+    foreach (QDir folder, sourceFolderList) {
+        foreach (QFileInfo fileName, folder.entryInfoList(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            files << fileName;
+            paths << folder.dirName() + "/" + fileName.fileName();
+        }
+    }
+
+    if (files.count() == 0) {
+       QMessageBox::information(NULL, tr("Athlete Backup"), tr("No files found for athlete %1 - all athlete sub-directories are empty.").arg(athlete));
+       return false;
+    }
+
+    QProgressDialog progress(tr("Adding changes to backup for athlete %1 ...").arg(athlete), progressText, 0, files.count(), NULL);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(1000); // don't flash up when there is little to do
+
+    QJsonArray entries;
+    QStringList unreadable;
+    for (int i=0; i<files.count(); i++) {
+
+        if (progress.wasCanceled()) return false; // chunks written so far are reused next time
+        progress.setValue(i);
+
+        const QFileInfo &info = files[i];
+        BackupEntry entry;
+        entry.size = info.size();
+        entry.modified = info.lastModified().toMSecsSinceEpoch();
+
+        // unchanged since the last backup, and all of its chunks are
+        // still in the store (they may have been removed by hand)
+        bool unchanged = false;
+        QHash<QString, BackupEntry>::const_iterator was = previous.constFind(paths[i]);
+        if (was != previous.constEnd() && was->size == entry.size && was->modified == entry.modified) {
+            unchanged = true;
+            foreach (QString hash, was->chunks) {
+                if (!QFile::exists(chunkPath(store, hash))) {
+                    unchanged = false;
+                    break;
+                }
+            }
+        }
+
+        if (unchanged) {
+
+            entry.chunks = was->chunks;
+
+        } else {
+
+            // a snapshot without it would not be a backup of the athlete
+            QFile file(info.canonicalFilePath());
+            if (!file.open(QIODevice::ReadOnly)) {
+                unreadable << paths[i];
+                continue;
+            }
+
+            while (!file.atEnd()) {
+                QByteArray chunk = file.read(backupChunkSize);
+                QString hash = QCryptographicHash::hash(chunk, QCryptographicHash::Sha1).toHex();
+                entry.chunks << hash;
+
+                // already stored ?
+                QString path = chunkPath(store, hash);
+                if (QFile::exists(path)) continue;
+
+                store.mkpath(QFileInfo(path).absolutePath());
+                QFile out(path + ".tmp");
+                if (!out.open(QIODevice::WriteOnly) || out.write(qCompress(chunk)) < 0 || !out.flush()) {
+                    out.remove();
+                    QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup file %1 cannot be created.").arg(path));
+                    return false;
+                }
+                out.close();
+
+                // another backup may have stored the same chunk meanwhile
+                if (!out.rename(path)) {
+                    out.remove();
+                    if (!QFile::exists(path)) {
+                        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup file %1 cannot be created.").arg(path));
+                        return false;
+                    }
+                }
+            }
+            file.close();
+        }
+
+        QJsonObject json;
+        json.insert("path", paths[i]);
+        json.insert("size", double(entry.size));
+        json.insert("modified", double(entry.modified));
+        json.insert("chunks", QJsonArray::fromStringList(entry.chunks));
+        entries.append(json);
+    }
+
+    // files we couldn't read, rather than a snapshot that quietly misses them
+    if (unreadable.count()) {
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("These files cannot be read, no backup created for athlete %1:\n%2")
+                             .arg(athlete).arg(unreadable.join("\n")));
+        return false;
+    }
+
+    // the snapshot is written last, so an aborted run leaves no partial snapshot
+    QJsonObject snapshot;
+    snapshot.insert("athlete", athlete);
+    snapshot.insert("version", VERSION_LATEST);
+    snapshot.insert("created", QDateTime::currentDateTime().toString(Qt::ISODate));
+    snapshot.insert("files", entries);
+
+    // names sort by time, and must never replace an earlier snapshot
+    QString stamp = QString("%1/%2/%3").arg(store.absolutePath()).arg(backupSnapshotFolder)
+                                       .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz"));
+    QString name = stamp + ".json";
+    for (int n=1; QFile::exists(name) || QFile::exists(name + ".tmp"); n++) name = QString("%1_%2.json").arg(stamp).arg(n);
+
+    QFile out(name + ".tmp");
+    if (!out.open(QIODevice::WriteOnly) || out.write(QJsonDocument(snapshot).toJson(QJsonDocument::Compact)) < 0) {
+        out.remove();
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup file %1 cannot be created.").arg(name));
+        return false;
+    }
+    out.close();
+    if (!out.rename(name)) {
+        out.remove();
+        QMessageBox::warning(NULL, tr("Athlete Backup"), tr("Backup file %1 cannot be created.").arg(name));
+        return false;
+    }
+
+    progress.setValue(files.count());
+    return true;
+}
+
+bool
+AthleteBackup::readSnapshot(QString filename, QHash<QString, BackupEntry> &entries, QString *athlete)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
 
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    file.close();
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) return false;
+
+    QJsonObject snapshot = document.object();
+    if (athlete) *athlete = snapshot["athlete"].toString();
+
+    foreach (QJsonValue value, snapshot["files"].toArray()) {
+        QJsonObject json = value.toObject();
+        BackupEntry entry;
+        entry.size = qint64(json["size"].toDouble());
+        entry.modified = qint64(json["modified"].toDouble());
+        foreach (QJsonValue hash, json["chunks"].toArray()) entry.chunks << hash.toString();
+        entries.insert(json["path"].toString(), entry);
+    }
+    return true;
+}
+
+QString
+AthleteBackup::chunkPath(QDir store, QString hash)
+{
+    // fan out on the first two digits to keep directories small
+    return QString("%1/%2/%3/%4").arg(store.absolutePath()).arg(backupChunkFolder).arg(hash.left(2)).arg(hash);
+}
+
+bool
+AthleteBackup::restore(QString snapshot, QDir target, QStringList &errors)
+{
+    QHash<QString, BackupEntry> entries;
+    if (!readSnapshot(snapshot, entries)) {
+        errors << tr("Snapshot %1 cannot be read.").arg(snapshot);
+        return false;
+    }
+
+    // store is the parent of the snapshots folder
+    QDir store = QFileInfo(snapshot).absoluteDir();
+    store.cdUp();
+
+    QProgressDialog progress(tr("Restoring backup to %1 ...").arg(target.absolutePath()), tr("Abort Restore"), 0, entries.count(), NULL);
+    progress.setWindowModality(Qt::WindowModal);
+
+    QString root = QDir::cleanPath(target.absolutePath()) + "/";
+
+    int counter = 0;
+    QHash<QString, BackupEntry>::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it, ++counter) {
+
+        if (progress.wasCanceled()) {
+            errors << tr("Restore aborted.");
+            return false;
+        }
+        progress.setValue(counter);
+
+        // never write outside the athlete folder, whatever the snapshot says
+        QString path = QDir::cleanPath(target.absoluteFilePath(it.key()));
+        if (QDir::isAbsolutePath(it.key()) || it.key().split(QRegExp("[/\\\\]")).contains("..") || !path.startsWith(root)) {
+            errors << tr("File %1 is outside the athlete folder, not restored.").arg(it.key());
+            continue;
+        }
+        target.mkpath(QFileInfo(path).absolutePath());
+        QFile out(path);
+        if (!out.open(QIODevice::WriteOnly)) {
+            errors << tr("File %1 cannot be created.").arg(path);
+            continue;
+        }
+
+        foreach (QString hash, it->chunks) {
+            QFile in(chunkPath(store, hash));
+            QByteArray chunk;
+            if (in.open(QIODevice::ReadOnly)) chunk = qUncompress(in.readAll());
+            if (QString(QCryptographicHash::hash(chunk, QCryptographicHash::Sha1).toHex()) != hash) {
+                errors << tr("File %1 is damaged, chunk %2 is missing or corrupt.").arg(it.key()).arg(hash);
+                break;
+            }
+            out.write(chunk);
+        }
+        out.close();
+
+#if QT_VERSION >= 0x050A00
+        // keep the timestamp so the next incremental backup sees it as unchanged
+        if (out.open(QIODevice::ReadWrite)) {
+            out.setFileTime(QDateTime::fromMSecsSinceEpoch(it->modified), QFileDevice::FileModificationTime);
+            out.close();
+        }
+#endif
+    }
+    progress.setValue(entries.count());
+    return errors.isEmpty();
+}
+
+void
+AthleteBackup::restoreImmediate()
+{
+    QString snapshot = QFileDialog::getOpenFileName(NULL, tr("Select Backup Snapshot"), "", tr("Backup Snapshot (*.json)"));
+    if (snapshot == "") return;
+
+    QHash<QString, BackupEntry> entries;
+    QString name;
+    if (!readSnapshot(snapshot, entries, &name) || name == "") {
+        QMessageBox::warning(NULL, tr("Athlete Restore"), tr("%1 is not a backup snapshot.").arg(snapshot));
+        return;
+    }
+
+    QString dir = QFileDialog::getExistingDirectory(NULL, tr("Select Directory to Restore Athlete %1 into").arg(name),
+                            "", QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+    if (dir == "") return;
+
+    // never restore over the top of existing data
+    QDir target(dir + "/" + name);
+    if (target.exists() && target.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).count()) {
+        QMessageBox::warning(NULL, tr("Athlete Restore"), tr("Directory %1 already exists and is not empty - restore aborted.").arg(target.absolutePath()));
+        return;
+    }
+
+    QStringList errors;
+    if (restore(snapshot, target, errors)) {
+        QMessageBox::information(NULL, tr("Athlete Restore"), tr("Backup successfully restored to \n%1").arg(target.absolutePath()));
+    } else {
+        QMessageBox::warning(NULL, tr("Athlete Restore"), errors.join("\n"));
+    }
+}
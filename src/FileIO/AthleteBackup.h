@@ -20,6 +20,8 @@
 #define _GC_AthleteBackup_h 1
 
 #include <QString>
+#include <QHash>
+#include <QStringList>
 
 #include "Athlete.h"
 
@@ -34,6 +36,10 @@ class AthleteBackup : public QObject
         void backupOnClose();
         void backupImmediate();
 
+        // rebuild a snapshot from an incremental backup store
+        static void restoreImmediate();
+        static bool restore(QString snapshot, QDir target, QStringList &errors);
+
     private:
         AthleteDirectoryStructure *athleteDirs;
         QString athlete;
@@ -41,6 +47,18 @@ class AthleteBackup : public QObject
         QList<QDir> sourceFolderList;
         bool backup(QString progressText);
 
+        // incremental backup, the store lives in the backup folder and holds
+        // file content as compressed chunks named by their hash, each run
+        // writes any new chunks and a snapshot listing the chunks of every file
+        struct BackupEntry {
+            qint64 size;
+            qint64 modified;
+            QStringList chunks;
+        };
+        bool backupIncremental(QString progressText);
+        static bool readSnapshot(QString filename, QHash<QString, BackupEntry> &entries, QString *athlete=NULL);
+        static QString chunkPath(QDir store, QString hash);
+
 };
 
 
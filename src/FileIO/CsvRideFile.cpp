@@ -99,7 +99,7 @@ RideFile *CsvFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
     bool metric = true;
     enum temperature { degF, degC, degNone };
     typedef enum temperature Temperature;
-    static Temperature tempType = degNone;
+    Temperature tempType = degNone;
     QDateTime startTime;
 
     // Minutes,Torq (N-m),Km/h,Watts,Km,Cadence,Hrate,ID
@@ -1552,7 +1552,7 @@ CsvFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file, CsvTy
     }
     else if (format == wprime) {
         WPrime *wp = ((RideFile*)ride)->wprimeData();
-        bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+        bool integral = appsettings->snapshot()->wbalIntegral;
 
         // Infos
         out << "CP=" << wp->CP << ",WPRIME=" << wp->WPRIME << ",TAU=" << wp->TAU << ",model=" << (integral?"integral":"differential") <<"\n";
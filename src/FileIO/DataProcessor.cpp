@@ -109,6 +109,45 @@ DataProcessorFactory::autoProcess(RideFile *ride, QString mode, QString op)
     return changed;
 }
 
+bool
+DataProcessorFactory::autoProcess(QList<RideFile*> rides, QString mode, QString op, QStringList *errors)
+{
+    if (errors) {
+        errors->clear();
+        for (int n=0; n<rides.count(); n++) *errors << QString();
+    }
+    if (!autoprocess || rides.isEmpty()) return false;
+
+#ifdef GC_WANT_PYTHON
+    fixPySettings->initialize();
+#endif
+
+    bool changed = false;
+
+    // same order as a single ride, each processor is applied to
+    // all of the rides before moving on to the next one
+    QMapIterator<QString, DataProcessor*> i(processors);
+    i.toFront();
+    while (i.hasNext()) {
+        i.next();
+        QString configsetting = QString("dp/%1/apply").arg(i.key());
+
+        if (appsettings->value(NULL, GC_QSETTINGS_GLOBAL_GENERAL+configsetting, "Manual").toString() == mode) {
+            QStringList failed;
+            if (i.value()->postProcessAll(rides, failed, NULL, op)) changed = true;
+
+            // what went wrong for each ride, by processor
+            for (int n=0; errors && n<failed.count() && n<rides.count(); n++) {
+                if (failed[n].isEmpty()) continue;
+                if (!(*errors)[n].isEmpty()) (*errors)[n] += "\n";
+                (*errors)[n] += QString("%1: %2").arg(i.value()->name()).arg(failed[n]);
+            }
+        }
+    }
+
+    return changed;
+}
+
 ManualDataProcessorDialog::ManualDataProcessorDialog(Context *context, QString name, RideItem *ride) : context(context), ride(ride)
 {
     setAttribute(Qt::WA_DeleteOnClose);
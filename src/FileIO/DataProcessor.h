@@ -76,6 +76,19 @@ class DataProcessor
         DataProcessor() {}
         virtual ~DataProcessor() {}
         virtual bool postProcess(RideFile *, DataProcessorConfig*settings=0, QString op="") = 0;
+
+        // several rides, processors that can work on them concurrently
+        // override this; each ride must end up as if run one at a time
+        // and errors has what went wrong for each ride, empty if nothing
+        virtual bool postProcessAll(QList<RideFile*> rides, QStringList &errors, DataProcessorConfig*settings=0, QString op="") {
+            bool changed = false;
+            errors.clear();
+            foreach(RideFile *ride, rides) {
+                if (postProcess(ride, settings, op)) changed = true;
+                errors << QString();
+            }
+            return changed;
+        }
         virtual DataProcessorConfig *processorConfig(QWidget *parent) = 0;
         virtual QString name() = 0; // Localized Name for user interface
         virtual bool isCoreProcessor() { return true; }
@@ -100,6 +113,7 @@ class DataProcessorFactory {
         void unregisterProcessor(QString name);
         QMap<QString,DataProcessor*> getProcessors(bool coreProcessorsOnly = false) const;
         bool autoProcess(RideFile *, QString mode, QString op); // run auto processes (after open rideFile)
+        bool autoProcess(QList<RideFile*>, QString mode, QString op, QStringList *errors=NULL); // same for several rides at once
         void setAutoProcessRule(bool b) { autoprocess = b; } // allows to switch autoprocess off (e.g. for Upgrades)
 };
 
@@ -29,6 +29,7 @@
 #include <QDebug>
 #include <QTime>
 #include <cstdio>
+#include <cstring>
 #include <stdint.h>
 #include <time.h>
 #include <limits>
@@ -92,6 +93,9 @@ struct FitDefinition {
     int global_msg_num;
     bool is_big_endian;
     std::vector<FitField> fields;
+    int data_size; // bytes in each data message, sum of the field sizes
+
+    FitDefinition() : global_msg_num(0), is_big_endian(false), data_size(0) {}
 };
 
 enum fitValueType { SingleValue, ListValue, FloatValue, StringValue };
@@ -152,69 +156,78 @@ struct FitFileReaderState
         last_time(0), last_distance(0.00f), interval(0), calibration(0),
         devices(0), stopped(true), isLapSwim(false), pool_length(0.0),
         last_event_type(-1), last_event(-1), last_msg_type(-1), frac_time(0.0),
-        last_altitude(0.0)
+        last_altitude(0.0), cursor(NULL), end(NULL)
     {}
 
     struct TruncatedRead {};
 
+    // the whole file is read into memory up front and decoded from a
+    // cursor, a QFile::read() per field is far too slow on big files
+    QByteArray buffer;
+    const char *cursor;
+    const char *end;
+
+    void read_bytes(void *dest, int size, int *count) {
+        if (size < 0 || end - cursor < size)
+            throw TruncatedRead();
+        memcpy(dest, cursor, size);
+        cursor += size;
+        if (count)
+            (*count) += size;
+    }
+
+    // same test QFile::canReadLine() made, a newline in what is left
+    bool can_read_line() const {
+        return memchr(cursor, '\n', end - cursor) != NULL;
+    }
+
     void read_unknown( int size, int *count = NULL ) {
-        if (!file.seek(file.pos() + size))
+        if (size < 0 || end - cursor < size)
             throw TruncatedRead();
+        cursor += size;
         if (count)
             (*count) += size;
     }
 
     fit_string_value read_text(int len, int *count = NULL) {
-        char c;
+        if (len < 0 || end - cursor < len)
+            throw TruncatedRead();
         fit_string_value res = "";
         for (int i = 0; i < len; ++i) {
-            if (file.read(&c, 1) != 1)
-                throw TruncatedRead();
-            if (count)
-                *count += 1;
-
+            char c = cursor[i];
             if (c != 0)
                 res += c;
         }
+        cursor += len;
+        if (count)
+            *count += len;
         return res;
     }
 
     fit_value_t read_int8(int *count = NULL) {
         qint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
+        read_bytes(&i, 1, count);
 
         return i == 0x7f ? NA_VALUE : i;
     }
 
     fit_value_t read_uint8(int *count = NULL) {
         quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
+        read_bytes(&i, 1, count);
 
         return i == 0xff ? NA_VALUE : i;
     }
 
     fit_value_t read_uint8z(int *count = NULL) {
         quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
+        read_bytes(&i, 1, count);
 
         return i == 0x00 ? NA_VALUE : i;
     }
 
     fit_value_t read_int16(bool is_big_endian, int *count = NULL) {
         qint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
+        read_bytes(&i, 2, count);
 
         i = is_big_endian
             ? qFromBigEndian<qint16>( i )
@@ -225,10 +238,7 @@ struct FitFileReaderState
 
     fit_value_t read_uint16(bool is_big_endian, int *count = NULL) {
         quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
+        read_bytes(&i, 2, count);
 
         i = is_big_endian
             ? qFromBigEndian<quint16>( i )
@@ -239,10 +249,7 @@ struct FitFileReaderState
 
     fit_value_t read_uint16z(bool is_big_endian, int *count = NULL) {
         quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
+        read_bytes(&i, 2, count);
 
         i = is_big_endian
             ? qFromBigEndian<quint16>( i )
@@ -253,10 +260,7 @@ struct FitFileReaderState
 
     fit_value_t read_int32(bool is_big_endian, int *count = NULL) {
         qint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+        read_bytes(&i, 4, count);
 
         i = is_big_endian
             ? qFromBigEndian<qint32>( i )
@@ -267,10 +271,7 @@ struct FitFileReaderState
 
     fit_value_t read_uint32(bool is_big_endian, int *count = NULL) {
         quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+        read_bytes(&i, 4, count);
 
         i = is_big_endian
             ? qFromBigEndian<quint32>( i )
@@ -281,10 +282,7 @@ struct FitFileReaderState
 
     fit_value_t read_uint32z(bool is_big_endian, int *count = NULL) {
         quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+        read_bytes(&i, 4, count);
 
         i = is_big_endian
             ? qFromBigEndian<quint32>( i )
@@ -295,10 +293,7 @@ struct FitFileReaderState
 
     fit_float_value read_float32(int *count = NULL) {
         float f;
-        if (file.read(reinterpret_cast<char*>(&f), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
+        read_bytes(&f, 4, count);
 
         return f;
     }
@@ -2666,11 +2661,15 @@ struct FitFileReaderState
 
             data_size = read_uint32(false); // always littleEndian
             char fit_str[5];
-            if (file.read(fit_str, 4) != 4) {
+            if (end - cursor < 4) {
                 errors << "truncated header";
                 stop = true;
+                fit_str[0] = '\0';
+            } else {
+                memcpy(fit_str, cursor, 4);
+                cursor += 4;
+                fit_str[4] = '\0';
             }
-            fit_str[4] = '\0';
             if (strcmp(fit_str, ".FIT") != 0) {
                 errors << QString("bad header, expected \".FIT\" but got \"%1\"").arg(fit_str);
                 stop = true;
@@ -2718,6 +2717,7 @@ struct FitFileReaderState
                 int base_type = read_uint8(&count);
                 field.type = base_type & 0x1f;
                 field.deve_idx = -1;
+                def.data_size += field.size;
 
                 if (FIT_DEBUG && FIT_DEBUG_LEVEL>1) {
                     printf("  field %d: %d bytes, num %d, type %d, size %d\n",
@@ -2736,6 +2736,7 @@ struct FitFileReaderState
                     field.num = read_uint8(&count);
                     field.size = read_uint8(&count);
                     field.deve_idx = read_uint8(&count);
+                    def.data_size += field.size;
 
                     QString key = QString("%1.%2").arg(field.deve_idx).arg(field.num);
                     FitDeveField devField = local_deve_fields[key];
@@ -2776,7 +2777,12 @@ struct FitFileReaderState
                     def.global_msg_num, time_offset );
             }
 
+            // the whole message must be there, so check once up front
+            if (end - cursor < def.data_size)
+                throw TruncatedRead();
+
             std::vector<FitValue> values;
+            values.reserve(def.fields.size());
             foreach(const FitField &field, def.fields) {
                 FitValue value;
                 int size;
@@ -2788,6 +2794,7 @@ struct FitFileReaderState
                              } else { // Multi-values
                                 value.type = ListValue;
                                 value.list.clear();
+                                value.list.reserve(field.size/size);
                                 for (int i=0;i<field.size/size;i++) {
                                     value.list.append(read_uint8(&count));
                                 }
@@ -2801,6 +2808,7 @@ struct FitFileReaderState
                             } else { // Multi-values
                                 value.type = ListValue;
                                 value.list.clear();
+                                value.list.reserve(field.size/size);
                                 for (int i=0;i<field.size/size;i++) {
                                     value.list.append(read_uint8(&count));
                                 }
@@ -2814,6 +2822,7 @@ struct FitFileReaderState
                             } else { // Multi-values
                                 value.type = ListValue;
                                 value.list.clear();
+                                value.list.reserve(field.size/size);
                                 for (int i=0;i<field.size/size;i++) {
                                     value.list.append(read_uint16(def.is_big_endian, &count));
                                 }
@@ -2827,6 +2836,7 @@ struct FitFileReaderState
                             } else { // Multi-values
                                 value.type = ListValue;
                                 value.list.clear();
+                                value.list.reserve(field.size/size);
                                 for (int i=0;i<field.size/size;i++) {
                                     value.list.append(read_uint32(def.is_big_endian, &count));
                                 }
@@ -2849,6 +2859,7 @@ struct FitFileReaderState
                         } else { // Multi-values
                             value.type = ListValue;
                             value.list.clear();
+                            value.list.reserve(field.size/size);
                             for (int i=0;i<field.size/size;i++) {
                                 value.list.append(read_float32(&count));
                             }
@@ -2864,6 +2875,7 @@ struct FitFileReaderState
                              } else { // Multi-values
                                  value.type = ListValue;
                                  value.list.clear();
+                                 value.list.reserve(field.size/size);
                                  for (int i=0;i<field.size/size;i++) {
                                      value.list.append(read_uint8z(&count));
                                  }
@@ -2875,6 +2887,7 @@ struct FitFileReaderState
                     case 13: // BYTE
                              value.type = ListValue;
                              value.list.clear();
+                             value.list.reserve(field.size);
                              for (int i=0;i<field.size;i++) {
                                 value.list.append(read_uint8(&count));
                              }
@@ -3072,6 +3085,9 @@ struct FitFileReaderState
             delete rideFile;
             return NULL;
         }
+        buffer = file.readAll();
+        cursor = buffer.constData();
+        end = cursor + buffer.size();
 
         int data_size = 0;
         weatherXdata = new XDataSeries();
@@ -3157,7 +3173,7 @@ struct FitFileReaderState
 
                 // second file ?
                 try {
-                    while (file.canReadLine()) {
+                    while (can_read_line()) {
                         read_header(stop, errors, data_size);
                         if (!stop) {
 
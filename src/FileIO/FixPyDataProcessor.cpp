@@ -27,6 +27,29 @@ bool FixPyDataProcessor::postProcess(RideFile *rideFile, DataProcessorConfig *se
     return pyRunner.run(pyScript->source, pyScript->iniKey, errText) == 0;
 }
 
+bool FixPyDataProcessor::postProcessAll(QList<RideFile*> rides, QStringList &errors, DataProcessorConfig *settings, QString op)
+{
+    Q_UNUSED(settings);
+
+    // scripts for each ride run concurrently
+    QStringList errTexts;
+    bool useNewThread = op != "PYTHON";
+    FixPyRunner pyRunner(nullptr, nullptr, useNewThread);
+    QList<int> results = pyRunner.runAll(pyScript->source, pyScript->iniKey, rides, errTexts);
+
+    // only keep the output of those that failed
+    bool ok = true;
+    errors.clear();
+    for (int i=0; i<results.count(); i++) {
+        if (results[i] == 0) errors << QString();
+        else {
+            errors << (errTexts[i].trimmed().isEmpty() ? QObject::tr("failed") : errTexts[i].trimmed());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
 DataProcessorConfig *FixPyDataProcessor::processorConfig(QWidget *parent)
 {
     return new FixPyDataProcessorConfig(parent);
@@ -9,6 +9,7 @@ class FixPyDataProcessor : public DataProcessor
 public:
     FixPyDataProcessor(FixPyScript *pyScript);
     bool postProcess(RideFile *rideFile, DataProcessorConfig *settings, QString op);
+    bool postProcessAll(QList<RideFile*> rides, QStringList &errors, DataProcessorConfig *settings, QString op);
     DataProcessorConfig *processorConfig(QWidget *parent);
     QString name() { return pyScript->name; }
     bool isCoreProcessor() { return false; }
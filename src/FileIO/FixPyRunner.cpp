@@ -1,12 +1,18 @@
 #include <QApplication>
 #include <QtConcurrent>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #include "FixPyRunner.h"
 #include "PythonEmbed.h"
 #include "RideFileCommand.h"
+#include "JsonRideFile.h"
 
 FixPyRunner::FixPyRunner(Context *context, RideFile *rideFile, bool useNewThread)
-    : context(context), rideFile(rideFile), useNewThread(useNewThread)
+    : context(context), rideFile(rideFile), useNewThread(useNewThread), waiting(NULL), running(0)
 {
 }
 
@@ -24,6 +30,7 @@ int FixPyRunner::run(QString source, QString scriptKey, QString &errText)
 
     QString line = source;
     int result = 0;
+    FixPyRunParams params;
 
     try {
 
@@ -31,7 +38,6 @@ int FixPyRunner::run(QString source, QString scriptKey, QString &errText)
         line = line.replace("$$", scriptKey);
 
         // run it
-        FixPyRunParams params;
         params.context = context;
         params.rideFile = rideFile;
         params.script = QString(line);
@@ -50,31 +56,245 @@ int FixPyRunner::run(QString source, QString scriptKey, QString &errText)
         }
 
         // output on console
-        if (python->messages.count()) {
-            errText = python->messages.join("\n");
+        if (params.messages.count()) {
+            errText = params.messages.join("\n");
         }
 
     } catch(std::exception& ex) {
-        errText = QString("\n%1\n%2").arg(QString(ex.what())).arg(python->messages.join(""));
+        errText = QString("\n%1\n%2").arg(QString(ex.what())).arg(params.messages.join(""));
         result = 2;
     } catch(...) {
-        errText = QString("\nerror: general exception.\n%1").arg(python->messages.join(""));
+        errText = QString("\nerror: general exception.\n%1").arg(params.messages.join(""));
         result = 3;
     }
 
-    python->messages.clear();
-
     // reset cursor
     QApplication::restoreOverrideCursor();
 
     return result;
 }
 
+// copy what a worker changed back onto the ride we were given, the
+// samples and xdata as one undoable step like a script run here
+static void applyResult(RideFile *ride, RideFile *result)
+{
+    ride->command->startLUW("Python Fix");
+
+    if (ride->dataPoints().count()) ride->command->deletePoints(0, ride->dataPoints().count());
+    QVector<RideFilePoint> rows;
+    foreach(RideFilePoint *point, result->dataPoints()) rows << *point;
+    if (rows.count()) ride->command->appendPoints(rows);
+
+    for (int i=0; i<static_cast<int>(RideFile::none); i++) {
+        RideFile::SeriesType series = static_cast<RideFile::SeriesType>(i);
+        if (ride->isDataPresent(series) != result->isDataPresent(series))
+            ride->command->setDataPresent(series, result->isDataPresent(series));
+    }
+
+    foreach(QString name, ride->xdata().keys()) ride->command->removeXData(name);
+    foreach(XDataSeries *series, result->xdata()) ride->command->addXData(series);
+    result->xdata().clear(); // they belong to ride now
+
+    ride->command->endLUW();
+
+    // the rest isn't in the command history
+    foreach(QString name, ride->tags().keys())
+        if (!result->tags().contains(name)) ride->removeTag(name);
+    QMapIterator<QString,QString> tag(result->tags());
+    while (tag.hasNext()) {
+        tag.next();
+        ride->setTag(tag.key(), tag.value());
+    }
+    ride->metricOverrides = result->metricOverrides;
+
+    ride->clearIntervals();
+    foreach(RideFileInterval *interval, result->intervals())
+        ride->addInterval(interval->type, interval->start, interval->stop, interval->name, interval->color, interval->test);
+    ride->setRecIntSecs(result->recIntSecs());
+}
+
+QList<int> FixPyRunner::runAll(QString source, QString scriptKey, QList<RideFile*> rides, QStringList &errTexts)
+{
+    QList<int> results;
+    errTexts.clear();
+    if (rides.isEmpty()) return results;
+    if (source.isEmpty()) {
+        for (int i=0; i<rides.count(); i++) { results << 1; errTexts << ""; }
+        return results;
+    }
+
+    // hourglass .. for long running ones this helps user know its busy
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    python->cancelled = false;
+
+    // replace $$ with script identifier (to avoid shared data)
+    QString line = source;
+    line = line.replace("$$", scriptKey);
+
+    // until we hear otherwise
+    for (int i=0; i<rides.count(); i++) { results << 3; errTexts << ""; }
+
+    // a worker per core, but a single ride is quicker run here
+    // than it would be to start up another interpreter for it
+    int workers = qMin(QThread::idealThreadCount(), rides.count());
+    QTemporaryDir dir(QDir::tempPath() + "/fixpy-XXXXXX");
+    if (workers < 2 || !dir.isValid()) {
+        for (int i=0; i<rides.count(); i++) {
+            FixPyRunParams params;
+            params.context = context;
+            params.rideFile = rides[i];
+            params.script = line;
+            execScript(&params);
+            results[i] = params.result;
+            errTexts[i] = params.messages.join("\n");
+        }
+        QApplication::restoreOverrideCursor();
+        return results;
+    }
+
+    // each worker gets the script and its share of the rides as .json
+    JsonFileReader json;
+    QFile script(dir.filePath("script.py"));
+    if (script.open(QFile::WriteOnly)) {
+        script.write(line.toUtf8());
+        script.close();
+    }
+
+    QVector<QStringList> shares(workers);
+    for (int i=0; i<rides.count(); i++) {
+        QFile file(dir.filePath(QString("%1.json").arg(i)));
+        if (json.writeRideFile(context, rides[i], file)) shares[i % workers] << file.fileName();
+        else errTexts[i] = tr("Cannot write %1 for the fix script worker.").arg(file.fileName());
+    }
+
+    QEventLoop loop;
+    waiting = useNewThread ? &loop : NULL;
+    running = 0;
+
+    QVector<QProcess*> processes(workers, NULL);
+    for (int w=0; w<workers; w++) {
+        if (shares[w].isEmpty()) continue;
+
+        QProcess *process = new QProcess(this);
+        process->setProgram(QCoreApplication::applicationFilePath());
+        process->setArguments(QStringList() << "--fix-worker" << script.fileName() << shares[w]);
+        connect(process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(workerFinished()));
+        processes[w] = process;
+
+        running++;
+        process->start();
+        if (!process->waitForStarted()) running--;
+    }
+
+    // wait for them all -- keeping the ui alive if we can
+    if (running) {
+        if (waiting) loop.exec();
+        else foreach(QProcess *process, processes) if (process) process->waitForFinished(-1);
+    }
+    waiting = NULL;
+
+    // collect in ride order
+    for (int i=0; i<rides.count(); i++) {
+        QFile file(dir.filePath(QString("%1.json").arg(i)));
+        QFile report(file.fileName() + ".result");
+
+        // the worker never got to it
+        if (!report.open(QFile::ReadOnly)) {
+            QProcess *process = processes[i % workers];
+            if (errTexts[i].isEmpty() && process)
+                errTexts[i] = tr("The fix script worker failed, exit code %1: %2").arg(process->exitCode()).arg(process->errorString());
+            continue;
+        }
+        QJsonObject result = QJsonDocument::fromJson(report.readAll()).object();
+        report.close();
+
+        results[i] = result.value("status").toInt(3);
+        errTexts[i] = result.value("output").toString();
+
+        if (result.value("changed").toBool()) {
+            QStringList errors;
+            RideFile *fixed = json.openRideFile(file, errors);
+            if (fixed) {
+                applyResult(rides[i], fixed);
+                delete fixed;
+            } else {
+                results[i] = 3;
+                errTexts[i] += errors.join("\n");
+            }
+        }
+    }
+    foreach(QProcess *process, processes) delete process;
+
+    // reset cursor
+    QApplication::restoreOverrideCursor();
+
+    return results;
+}
+
+void FixPyRunner::workerFinished()
+{
+    if (--running == 0 && waiting) waiting->quit();
+}
+
+int FixPyRunner::worker(QStringList args)
+{
+    if (python == NULL || args.isEmpty()) return 1;
+
+    QFile script(args.takeFirst());
+    if (!script.open(QFile::ReadOnly)) return 1;
+    QString source = QString::fromUtf8(script.readAll());
+    script.close();
+
+    JsonFileReader json;
+    foreach(QString filename, args) {
+
+        QFile file(filename);
+        QStringList errors;
+        QJsonObject result;
+
+        RideFile *ride = json.openRideFile(file, errors);
+        if (ride == NULL) {
+            result.insert("status", 3);
+            result.insert("output", errors.join("\n"));
+        } else {
+
+            // only send back rides the script actually changed
+            QByteArray before = json.toByteArray(NULL, ride, true, true, true, true);
+
+            FixPyRunParams params;
+            params.context = NULL;
+            params.rideFile = ride;
+            params.script = source;
+            execScript(&params);
+
+            bool changed = json.toByteArray(NULL, ride, true, true, true, true) != before;
+            if (changed && !json.writeRideFile(NULL, ride, file)) {
+                params.result = 3;
+                params.messages << tr("Cannot write %1.").arg(filename);
+            }
+
+            result.insert("status", params.result);
+            result.insert("changed", changed);
+            result.insert("output", params.messages.join("\n"));
+            delete ride;
+        }
+
+        QFile report(filename + ".result");
+        if (report.open(QFile::WriteOnly)) {
+            report.write(QJsonDocument(result).toJson());
+            report.close();
+        }
+    }
+    return 0;
+}
+
 void FixPyRunner::execScript(FixPyRunParams *params)
 {
     QList<RideFile *> editedRideFiles;
-    python->runline(ScriptContext(params->context, params->rideFile, false,
-                                  false, &editedRideFiles), params->script);
+    bool ok = python->runscript(ScriptContext(params->context, params->rideFile, false,
+                                              false, &editedRideFiles), params->script, params->messages);
+    params->result = ok ? 0 : 2;
 
     // finish up commands on edited rides
     foreach (RideFile *f, editedRideFiles) {
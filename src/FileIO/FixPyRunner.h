@@ -3,6 +3,8 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <QEventLoop>
 
 #include "FixPyScript.h"
 #include "Context.h"
@@ -12,6 +14,8 @@ struct FixPyRunParams
     Context *context;
     RideFile *rideFile;
     QString script;
+    QStringList messages;   // output from the script
+    int result;             // 0 ran cleanly, 2 the script raised an error
 };
 
 class FixPyRunner : public QObject
@@ -22,12 +26,30 @@ public:
     FixPyRunner(Context *context = nullptr, RideFile *rideFile = nullptr, bool useNewThread = true);
 
     int run(QString source, QString scriptKey, QString &errText);
+
+    // run over several rides at once, each worker process has its own
+    // interpreter so the scripts really do run side by side. results
+    // and output are in the same order as rides; a result is 0 if the
+    // script ran cleanly, 1 if there is no script, 2 if it raised an
+    // error and 3 if the worker running it failed
+    QList<int> runAll(QString source, QString scriptKey, QList<RideFile*> rides, QStringList &errTexts);
+
     static void execScript(FixPyRunParams *params);
 
+    // the other end of runAll, run by GoldenCheetah --fix-worker
+    // with the script and the .json rides it should fix in place
+    static int worker(QStringList args);
+
+private slots:
+    void workerFinished();
+
 private:
     Context *context;
     RideFile *rideFile;
     bool useNewThread;
+
+    QEventLoop *waiting;
+    int running;
 };
 
 #endif // FIXPYRUNNER_H
@@ -22,7 +22,8 @@
 #include "GpxRideFile.h"
 #include "GpxParser.h"
 #include "GcUpgrade.h"
-#include <QDomDocument>
+#include <QBuffer>
+#include <QXmlStreamWriter>
 
 static int gpxFileReaderRegistered =
     RideFileFactory::instance().registerReader(
@@ -47,22 +48,34 @@ RideFile *GpxFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 }
 
 QByteArray
-GpxFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
+GpxFileReader::toByteArray(Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
+{
+    QByteArray xml;
+    QBuffer buffer(&xml);
+    buffer.open(QIODevice::WriteOnly);
+    toDevice(&buffer, context, ride, withAlt, withWatts, withHr, withCad);
+    buffer.close();
+    return xml;
+}
+
+void
+GpxFileReader::toDevice(QIODevice *device, Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
 {
     //
     // GPX Standard defined here:  http://www.topografix.com/GPX/1/1/
     //
-    QDomDocument doc;
-    QDomProcessingInstruction hdr = doc.createProcessingInstruction("xml","version=\"1.0\"");
-    doc.appendChild(hdr);
-
-    QDomElement gpx = doc.createElementNS("http://www.topografix.com/GPX/1/1", "gpx");
-
-    gpx.setAttribute("xmlns:xsi",    "http://www.w3.org/2001/XMLSchema-instance");
-    gpx.setAttribute("xmlns:gpxtpx", "http://www.garmin.com/xmlschemas/TrackPointExtension/v1");
-    gpx.setAttribute("xmlns:gpxpx",  "http://www.garmin.com/xmlschemas/PowerExtension/v1");
-
-    gpx.setAttribute("xsi:schemaLocation",
+    QXmlStreamWriter xml(device);
+    xml.setAutoFormatting(true);
+    xml.setAutoFormattingIndent(4);
+    xml.writeStartDocument();
+
+    xml.writeStartElement("gpx");
+    xml.writeDefaultNamespace("http://www.topografix.com/GPX/1/1");
+    xml.writeNamespace("http://www.w3.org/2001/XMLSchema-instance", "xsi");
+    xml.writeNamespace("http://www.garmin.com/xmlschemas/TrackPointExtension/v1", "gpxtpx");
+    xml.writeNamespace("http://www.garmin.com/xmlschemas/PowerExtension/v1", "gpxpx");
+
+    xml.writeAttribute("xsi:schemaLocation",
                      "http://www.topografix.com/GPX/1/1"                           " " 
                      "http://www.topografix.com/GPX/1/1/gpx.xsd"                   " " 
                      "http://www.garmin.com/xmlschemas/TrackPointExtension/v1"     " " 
@@ -70,118 +83,82 @@ GpxFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool w
                      "http://www.garmin.com/xmlschemas/PowerExtension/v1"          " " 
                      "http://www.garmin.com/xmlschemas/PowerExtensionv1.xsd"        );
 
-    gpx.setAttribute("version", "1.1");
-    gpx.setAttribute("creator", QString("GoldenCheetah (build %1)").arg(VERSION_LATEST));
-    doc.appendChild(gpx);
+    xml.writeAttribute("version", "1.1");
+    xml.writeAttribute("creator", QString("GoldenCheetah (build %1)").arg(VERSION_LATEST));
 
 
     // If we have data points, we'll have a <trk> and in that a <trkseg> and in that a bunch of <trkpt>
     if (!ride->dataPoints().empty()) {
-        QDomElement trk = doc.createElement("trk");
-        gpx.appendChild(trk);
-
-        QDomElement trkseg = doc.createElement("trkseg");
-        trk.appendChild(trkseg);        
+        xml.writeStartElement("trk");
+        xml.writeStartElement("trkseg");
 
         QLocale cLocale(QLocale::Language::C);
+        QDateTime start = ride->startTime().toUTC();
 
         foreach (const RideFilePoint *point, ride->dataPoints()) {
-            QDomElement trkpt = doc.createElement("trkpt");
-            trkseg.appendChild(trkpt);
+            xml.writeStartElement("trkpt");
 
-            QString strLat = cLocale.toString(point->lat, 'g', 12);
-            trkpt.setAttribute("lat", strLat);
-            QString strLon = cLocale.toString(point->lon, 'g', 12);
-            trkpt.setAttribute("lon", strLon);
+            xml.writeAttribute("lat", cLocale.toString(point->lat, 'g', 12));
+            xml.writeAttribute("lon", cLocale.toString(point->lon, 'g', 12));
 
             // GPX standard requires <ele>, if present, to be first
             if (withAlt && ride->areDataPresent()->alt) {
-                QDomElement ele = doc.createElement("ele");
-                //QDomText text = doc.createTextNode(QString("%1").arg(point->alt, 0, 'f', 1));
-                //ele.appendChild(text);
-                ele.appendChild(doc.createTextNode(QString("%1").arg(point->alt, 0, 'f', 1)));
-                trkpt.appendChild(ele);
+                xml.writeTextElement("ele", QString("%1").arg(point->alt, 0, 'f', 1));
             }
 
             // GPX standard requires <time>, if present, to come next
             if (ride->areDataPresent()->secs && point->secs >= 0)
             {
-                QDomElement tm = doc.createElement("time");
-                QDomText text = doc.createTextNode(ride->startTime().toUTC().addSecs(point->secs).toString(Qt::ISODate));
-                tm.appendChild(text);
-                trkpt.appendChild(tm);
+                xml.writeTextElement("time", start.addSecs(point->secs).toString(Qt::ISODate));
             }
 
             // Extra things, if any, need to go into an <extensions> tag
-            QDomElement gpxtpx_atemp;     // temperature
-            QDomElement gpxtpx_hr;        // HR
-            QDomElement gpxtpx_cad;       // cadance
-            QDomElement pwr_PowerInWatts; // power
-
-            if (ride->areDataPresent()->temp && point->temp > -200) {
-                gpxtpx_atemp = doc.createElement("gpxtpx:atemp");
-                gpxtpx_atemp.appendChild(doc.createTextNode(QString("%1").arg(point->temp, 0, 'f', 1)));
-            }
-
-            if (withHr && ride->areDataPresent()->hr) {
-                gpxtpx_hr = doc.createElement("gpxtpx:hr");
-                gpxtpx_hr.appendChild(doc.createTextNode(QString("%1").arg(point->hr, 0, 'f', 0)));
-            }
-
-            if (withCad && ride->areDataPresent()->cad && point->cad < 255) {
-                gpxtpx_cad = doc.createElement("gpxtpx:cad");
-                gpxtpx_cad.appendChild(doc.createTextNode(QString("%1").arg(point->cad, 0, 'f', 0)));
-            }
-
-            if (withWatts && ride->areDataPresent()->watts) {
-                pwr_PowerInWatts = doc.createElement("pwr:PowerInWatts");
-                pwr_PowerInWatts.setAttribute("xmlns:pwr", "http://www.garmin.com/xmlschemas/PowerExtension/v1");
-                pwr_PowerInWatts.appendChild(doc.createTextNode(QString("%1").arg(point->watts, 0, 'f', 0)));
-            }
-
-
-            // If we have at least one from among TEMP, CAD, and HR, we need a <gpxtpx:TrackPointExtension> tag
-            QDomElement gpxtpx_TrackPointExtension;
-            if (!gpxtpx_atemp.isNull() || !gpxtpx_cad.isNull() || !gpxtpx_hr.isNull()) {
-                gpxtpx_TrackPointExtension = doc.createElement("gpxtpx:TrackPointExtension");
-                
-                // These must go in this order, as per http://www8.garmin.com/xmlschemas/TrackPointExtensionv1.xsd
-                if (!gpxtpx_atemp.isNull())
-                    gpxtpx_TrackPointExtension.appendChild(gpxtpx_atemp);
-                if (!gpxtpx_hr.isNull())
-                    gpxtpx_TrackPointExtension.appendChild(gpxtpx_hr);
-                if (!gpxtpx_cad.isNull())
-                    gpxtpx_TrackPointExtension.appendChild(gpxtpx_cad);
-            }
+            bool atemp = ride->areDataPresent()->temp && point->temp > -200;     // temperature
+            bool hr = withHr && ride->areDataPresent()->hr;                      // HR
+            bool cad = withCad && ride->areDataPresent()->cad && point->cad < 255; // cadance
+            bool watts = withWatts && ride->areDataPresent()->watts;             // power
 
             // If we have gpxtpx_TrackPointExtension and/or pwr_PowerInWatts, we need an <extension> tag to hold them.
-            if (! gpxtpx_TrackPointExtension.isNull() || !pwr_PowerInWatts.isNull()) {
-                QDomElement extensions = doc.createElement("extensions");
-                trkpt.appendChild(extensions);
-
-                if (! gpxtpx_TrackPointExtension.isNull())
-                    extensions.appendChild(gpxtpx_TrackPointExtension);
-                if (!pwr_PowerInWatts.isNull())
-                    extensions.appendChild(pwr_PowerInWatts);
+            if (atemp || hr || cad || watts) {
+                xml.writeStartElement("extensions");
+
+                // If we have at least one from among TEMP, CAD, and HR, we need a <gpxtpx:TrackPointExtension> tag
+                if (atemp || hr || cad) {
+                    xml.writeStartElement("gpxtpx:TrackPointExtension");
+
+                    // These must go in this order, as per http://www8.garmin.com/xmlschemas/TrackPointExtensionv1.xsd
+                    if (atemp)
+                        xml.writeTextElement("gpxtpx:atemp", QString("%1").arg(point->temp, 0, 'f', 1));
+                    if (hr)
+                        xml.writeTextElement("gpxtpx:hr", QString("%1").arg(point->hr, 0, 'f', 0));
+                    if (cad)
+                        xml.writeTextElement("gpxtpx:cad", QString("%1").arg(point->cad, 0, 'f', 0));
+
+                    xml.writeEndElement(); // gpxtpx:TrackPointExtension
+                }
+
+                if (watts) {
+                    xml.writeStartElement("pwr:PowerInWatts");
+                    xml.writeAttribute("xmlns:pwr", "http://www.garmin.com/xmlschemas/PowerExtension/v1");
+                    xml.writeCharacters(QString("%1").arg(point->watts, 0, 'f', 0));
+                    xml.writeEndElement();
+                }
+                xml.writeEndElement(); // extensions
             }
+            xml.writeEndElement(); // trkpt
         }
     }
 
-    return doc.toByteArray(4);
+    // closes trkseg, trk, gpx and the document
+    xml.writeEndDocument();
 }
 
 bool
 GpxFileReader::writeRideFile(Context *context, const RideFile *ride, QFile &file) const
 {
-    QByteArray xml = toByteArray(context, ride, true, true, true, true);
-
     if (!file.open(QIODevice::WriteOnly)) return(false);
     file.resize(0);
-    QTextStream out(&file);
-    out.setCodec("UTF-8");
-    //out.setGenerateByteOrderMark(true);
-    out << xml;
-    out.flush();
+    toDevice(&file, context, ride, true, true, true, true);
     file.close();
     return(true);
 }
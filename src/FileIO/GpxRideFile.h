@@ -31,6 +31,7 @@ struct GpxFileReader : public RideFileReader {
 
     virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const; 
     QByteArray toByteArray(Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const;
+    void toDevice(QIODevice *device, Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const;
     bool writeRideFile(Context *context, const RideFile *ride, QFile &file) const;
     bool hasWrite() const { return true; }
 };
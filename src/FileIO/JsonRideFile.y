@@ -35,6 +35,7 @@
 // in writeRideFile below, this is NOT a generic json parser.
 
 #include "JsonRideFile.h"
+#include <QBuffer>
 
 // now we have a reentrant parser we save context data
 // in a structure rather than in global variables -- so
@@ -71,7 +72,7 @@ struct JsonContext {
 // Lex scanner
 extern int JsonRideFilelex(YYSTYPE*,void*); // the lexer aka yylex()
 extern int JsonRideFilelex_init(void**);
-extern void JsonRideFile_setString(QString, void *);
+extern void JsonRideFile_setBuffer(QByteArray &, int, void *);
 extern int JsonRideFilelex_destroy(void*); // the cleaner for lexer
 
 // yacc parser
@@ -395,32 +396,44 @@ static int jsonFileReaderRegistered =
     RideFileFactory::instance().registerReader(
         "json", "GoldenCheetah Json", new JsonFileReader());
 
+// true if the bytes are well formed UTF-8, older files may be Latin-1
+static bool isUtf8(const QByteArray &bytes)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(bytes.constData());
+    const unsigned char *end = p + bytes.size();
+
+    while (p < end) {
+
+        // plain ascii, which is almost everything
+        if (*p < 0x80) { p++; continue; }
+
+        // multi-byte sequence, lead byte says how many follow
+        int follow = (*p & 0xE0) == 0xC0 ? 1 : (*p & 0xF0) == 0xE0 ? 2 : (*p & 0xF8) == 0xF0 ? 3 : -1;
+        if (follow < 0 || end - p <= follow) return false;
+        for (int i=1; i<=follow; i++) if ((p[i] & 0xC0) != 0x80) return false;
+        p += follow + 1;
+    }
+    return true;
+}
+
 RideFile *
 JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    // Read the entire file into a QString -- we avoid using fopen since it
-    // doesn't handle foreign characters well. Instead we use QFile and parse
-    // from a QString
-    QString contents;
+    // Read the raw bytes and let the lexer scan them in place, there is
+    // no need to decode into a QString and then encode back to UTF-8
+    QByteArray contents;
     if (file.exists() && file.open(QFile::ReadOnly | QFile::Text)) {
 
         // read in the whole thing
-        QTextStream in(&file);
-        // GC .JSON is stored in UTF-8 with BOM(Byte order mark) for identification
-        in.setCodec ("UTF-8");
-        contents = in.readAll();
+        contents = file.readAll();
         file.close();
 
-        // check if the text string contains the replacement character for UTF-8 encoding
-        // if yes, try to read with Latin1/ISO 8859-1 (assuming this is an "old" non-UTF-8 Json file)
-        if (contents.contains(QChar::ReplacementCharacter)) {
-           if (file.exists() && file.open(QFile::ReadOnly | QFile::Text)) {
-             QTextStream in(&file);
-             in.setCodec ("ISO 8859-1");
-             contents = in.readAll();
-             file.close();
-           }
-         }
+        // GC .JSON is stored in UTF-8 with BOM(Byte order mark) for identification
+        if (contents.startsWith("\xEF\xBB\xBF")) contents.remove(0, 3);
+
+        // if its not valid UTF-8 assume this is an "old" non-UTF-8 Json
+        // file and convert from Latin1/ISO 8859-1
+        if (!isUtf8(contents)) contents = QString::fromLatin1(contents).toUtf8();
 
     } else {
 
@@ -428,12 +441,17 @@ JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*
         return NULL; 
     }
 
+    // the lexer needs two null bytes at the end of the buffer
+    int size = contents.size();
+    contents.append('\0');
+    contents.append('\0');
+
     // create scanner context for reentrant parsing
     JsonContext *jc = new JsonContext;
     JsonRideFilelex_init(&scanner);
 
     // inform the parser/lexer we have a new file
-    JsonRideFile_setString(contents, scanner);
+    JsonRideFile_setBuffer(contents, size, scanner);
 
     // setup
     jc->JsonRide = new RideFile;
@@ -464,19 +482,76 @@ JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*
     }
 }
 
+// Buffered output straight to the device, so saving a long ride doesn't
+// build the whole document in memory, and numbers are formatted without
+// going through QString::arg() for every field of every sample
+class JsonWriter
+{
+    public:
+        JsonWriter(QIODevice *device) : device(device) { buffer.reserve(BUFFERSIZE + 1024); }
+        ~JsonWriter() { flush(); }
+
+        JsonWriter &operator<<(const char *s) { buffer.append(s); check(); return *this; }
+        JsonWriter &operator<<(const QString &s) { buffer.append(s.toUtf8()); check(); return *this; }
+        JsonWriter &operator<<(double v) { number(v, 6); return *this; }
+
+        // same text as QString("%1").arg(v, 0, 'g', precision) but whole
+        // numbers, which most samples are, are written in full and quickly
+        void number(double v, int precision) {
+            if (v > -1e15 && v < 1e15 && v == double(qint64(v))) {
+                char digits[20];
+                int n = 0;
+                qint64 i = qint64(v);
+                if (i < 0) {
+                    buffer.append('-');
+                    i = -i;
+                }
+                do { digits[n++] = '0' + (i % 10); i /= 10; } while (i);
+                while (n) buffer.append(digits[--n]);
+            } else {
+                buffer.append(QByteArray::number(v, 'g', precision));
+            }
+            check();
+        }
+
+        void flush() {
+            if (buffer.size()) device->write(buffer);
+            buffer.resize(0); // keeps the reserved capacity
+        }
+
+    private:
+        static const int BUFFERSIZE = 64 * 1024;
+        void check() { if (buffer.size() >= BUFFERSIZE) flush(); }
+
+        QIODevice *device;
+        QByteArray buffer;
+};
+
 QByteArray
-JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
+JsonFileReader::toByteArray(Context *context, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
+{
+    QByteArray returning;
+    QBuffer buffer(&returning);
+    buffer.open(QIODevice::WriteOnly);
+    toDevice(&buffer, context, ride, withAlt, withWatts, withHr, withCad);
+    buffer.close();
+
+    return returning;
+}
+
+void
+JsonFileReader::toDevice(QIODevice *device, Context *, const RideFile *ride, bool withAlt, bool withWatts, bool withHr, bool withCad) const
 {
-    QByteArray out;
+    JsonWriter out(device);
 
     // start of document and ride
-    out += "{\n\t\"RIDE\":{\n";
+    out << "{\n\t\"RIDE\":{\n";
 
     // first class variables
-    out += "\t\t\"STARTTIME\":\"" + protect(ride->startTime().toUTC().toString(DATETIME_FORMAT)) + "\",\n";
-    out += "\t\t\"RECINTSECS\":" + QString("%1").arg(ride->recIntSecs()) + ",\n";
-    out += "\t\t\"DEVICETYPE\":\"" + protect(ride->deviceType()) + "\",\n";
-    out += "\t\t\"IDENTIFIER\":\"" + protect(ride->id()) + "\"";
+    out << "\t\t\"STARTTIME\":\"" << protect(ride->startTime().toUTC().toString(DATETIME_FORMAT)) << "\",\n";
+    out << "\t\t\"RECINTSECS\":" << ride->recIntSecs() << ",\n";
+    out << "\t\t\"DEVICETYPE\":\"" << protect(ride->deviceType()) << "\",\n";
+    out << "\t\t\"IDENTIFIER\":\"" << protect(ride->id()) << "\"";
 
     //
     // OVERRIDES
@@ -492,28 +567,28 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
         for (k=ride->metricOverrides.constBegin(); k != ride->metricOverrides.constEnd(); k++) {
 
             if (nonblanks == false) {
-                out += ",\n\t\t\"OVERRIDES\":[\n";
+                out << ",\n\t\t\"OVERRIDES\":[\n";
                 nonblanks = true;
 
             }
             // begin of overrides
-            out += "\t\t\t{ \"" + k.key() + "\":{ ";
+            out << "\t\t\t{ \"" << k.key() << "\":{ ";
 
             // key/value pairs
             QMap<QString, QString>::const_iterator j;
             for (j=k.value().constBegin(); j != k.value().constEnd(); j++) {
 
                 // comma separated
-                out += "\"" + j.key() + "\":\"" + j.value() + "\"";
-                if (j+1 != k.value().constEnd()) out += ", ";
+                out << "\"" << j.key() << "\":\"" << j.value() << "\"";
+                if (j+1 != k.value().constEnd()) out << ", ";
             }
-            if (k+1 != ride->metricOverrides.constEnd()) out += " }},\n";
-            else out += " }}\n";
+            if (k+1 != ride->metricOverrides.constEnd()) out << " }},\n";
+            else out << " }}\n";
         }
 
         if (nonblanks == true) {
             // end of the overrides
-            out += "\t\t]";
+            out << "\t\t]";
         }
     }
 
@@ -522,18 +597,18 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (ride->tags().count()) {
 
-        out += ",\n\t\t\"TAGS\":{\n";
+        out << ",\n\t\t\"TAGS\":{\n";
 
         QMap<QString,QString>::const_iterator i;
         for (i=ride->tags().constBegin(); i != ride->tags().constEnd(); i++) {
 
-                out += "\t\t\t\"" + i.key() + "\":\"" + protect(i.value()) + "\"";
-                if (i+1 != ride->tags().constEnd()) out += ",\n";
-                else out += "\n";
+                out << "\t\t\t\"" << i.key() << "\":\"" << protect(i.value()) << "\"";
+                if (i+1 != ride->tags().constEnd()) out << ",\n";
+                else out << "\n";
         }
 
         // end of the tags
-        out += "\t\t}";
+        out << "\t\t}";
     }
 
     //
@@ -541,21 +616,21 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (!ride->intervals().empty()) {
 
-        out += ",\n\t\t\"INTERVALS\":[\n";
+        out << ",\n\t\t\"INTERVALS\":[\n";
         bool first = true;
 
         foreach (RideFileInterval *i, ride->intervals()) {
             if (first) first=false;
-            else out += ",\n";
-
-            out += "\t\t\t{ ";
-            out += "\"NAME\":\"" + protect(i->name) + "\"";
-            out += ", \"START\": " + QString("%1").arg(i->start);
-            out += ", \"STOP\": " + QString("%1").arg(i->stop);
-            out += ", \"COLOR\":" + QString("\"%1\"").arg(i->color.name());
-            out += ", \"PTEST\":\"" + QString("%1").arg(i->test ? "true" : "false") + "\" }";
+            else out << ",\n";
+
+            out << "\t\t\t{ ";
+            out << "\"NAME\":\"" << protect(i->name) << "\"";
+            out << ", \"START\": " << i->start;
+            out << ", \"STOP\": " << i->stop;
+            out << ", \"COLOR\":\"" << i->color.name() << "\"";
+            out << ", \"PTEST\":\"" << (i->test ? "true" : "false") << "\" }";
         }
-        out += "\n\t\t]";
+        out << "\n\t\t]";
     }
 
     //
@@ -563,19 +638,19 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (!ride->calibrations().empty()) {
 
-        out += ",\n\t\t\"CALIBRATIONS\":[\n";
+        out << ",\n\t\t\"CALIBRATIONS\":[\n";
         bool first = true;
 
         foreach (RideFileCalibration *i, ride->calibrations()) {
             if (first) first=false;
-            else out += ",\n";
+            else out << ",\n";
 
-            out += "\t\t\t{ ";
-            out += "\"NAME\":\"" + protect(i->name) + "\"";
-            out += ", \"START\": " + QString("%1").arg(i->start);
-            out += ", \"VALUE\": " + QString("%1").arg(i->value) + " }";
+            out << "\t\t\t{ ";
+            out << "\"NAME\":\"" << protect(i->name) << "\"";
+            out << ", \"START\": " << i->start;
+            out << ", \"VALUE\": " << i->value << " }";
         }
-        out += "\n\t\t]";
+        out << "\n\t\t]";
     }
 
     //
@@ -583,24 +658,24 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (!ride->referencePoints().empty()) {
 
-        out += ",\n\t\t\"REFERENCES\":[\n";
+        out << ",\n\t\t\"REFERENCES\":[\n";
         bool first = true;
 
         foreach (RideFilePoint *p, ride->referencePoints()) {
             if (first) first=false;
-            else out += ",\n";
+            else out << ",\n";
 
-            out += "\t\t\t{ ";
+            out << "\t\t\t{ ";
 
-            if (p->watts > 0) out += " \"WATTS\":" + QString("%1").arg(p->watts);
-            if (p->cad > 0) out += " \"CAD\":" + QString("%1").arg(p->cad);
-            if (p->hr > 0) out += " \"HR\":"  + QString("%1").arg(p->hr);
-            if (p->secs > 0) out += " \"SECS\":" + QString("%1").arg(p->secs);
+            if (p->watts > 0) out << " \"WATTS\":" << p->watts;
+            if (p->cad > 0) out << " \"CAD\":" << p->cad;
+            if (p->hr > 0) out << " \"HR\":" << p->hr;
+            if (p->secs > 0) out << " \"SECS\":" << p->secs;
 
             // sample points in here!
-            out += " }";
+            out << " }";
         }
-        out +="\n\t\t]";
+        out << "\n\t\t]";
     }
 
     //
@@ -608,58 +683,65 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (ride->dataPoints().count()) {
 
-        out += ",\n\t\t\"SAMPLES\":[\n";
+        out << ",\n\t\t\"SAMPLES\":[\n";
         bool first = true;
 
+        // what is present doesn't change from sample to sample
+        const RideFileDataPresent *present = ride->areDataPresent();
+
         foreach (RideFilePoint *p, ride->dataPoints()) {
 
             if (first) first=false;
-            else out += ",\n";
+            else out << ",\n";
 
-            out += "\t\t\t{ ";
+            out << "\t\t\t{ ";
 
             // always store time
-            out += "\"SECS\":" + QString("%1").arg(p->secs);
-
-            if (ride->areDataPresent()->km) out += ", \"KM\":" + QString("%1").arg(p->km);
-            if (ride->areDataPresent()->watts && withWatts) out += ", \"WATTS\":" + QString("%1").arg(p->watts);
-            if (ride->areDataPresent()->nm) out += ", \"NM\":" + QString("%1").arg(p->nm);
-            if (ride->areDataPresent()->cad && withCad) out += ", \"CAD\":" + QString("%1").arg(p->cad);
-            if (ride->areDataPresent()->kph) out += ", \"KPH\":" + QString("%1").arg(p->kph);
-            if (ride->areDataPresent()->hr && withHr) out += ", \"HR\":"  + QString("%1").arg(p->hr);
-            if (ride->areDataPresent()->alt && withAlt) out += ", \"ALT\":" + QString("%1").arg(p->alt);
-            if (ride->areDataPresent()->lat)
-                out += ", \"LAT\":" + QString("%1").arg(p->lat, 0, 'g', 11);
-            if (ride->areDataPresent()->lon)
-                out += ", \"LON\":" + QString("%1").arg(p->lon, 0, 'g', 11);
-            if (ride->areDataPresent()->headwind) out += ", \"HEADWIND\":" + QString("%1").arg(p->headwind);
-            if (ride->areDataPresent()->slope) out += ", \"SLOPE\":" + QString("%1").arg(p->slope);
-            if (ride->areDataPresent()->temp && p->temp != RideFile::NA) out += ", \"TEMP\":" + QString("%1").arg(p->temp);
-            if (ride->areDataPresent()->lrbalance && p->lrbalance != RideFile::NA) out += ", \"LRBALANCE\":" + QString("%1").arg(p->lrbalance);
-            if (ride->areDataPresent()->lte) out += ", \"LTE\":" + QString("%1").arg(p->lte);
-            if (ride->areDataPresent()->rte) out += ", \"RTE\":" + QString("%1").arg(p->rte);
-            if (ride->areDataPresent()->lps) out += ", \"LPS\":" + QString("%1").arg(p->lps);
-            if (ride->areDataPresent()->rps) out += ", \"RPS\":" + QString("%1").arg(p->rps);
-            if (ride->areDataPresent()->lpco) out += ", \"LPCO\":" + QString("%1").arg(p->lpco);
-            if (ride->areDataPresent()->rpco) out += ", \"RPCO\":" + QString("%1").arg(p->rpco);
-            if (ride->areDataPresent()->lppb) out += ", \"LPPB\":" + QString("%1").arg(p->lppb);
-            if (ride->areDataPresent()->rppb) out += ", \"RPPB\":" + QString("%1").arg(p->rppb);
-            if (ride->areDataPresent()->lppe) out += ", \"LPPE\":" + QString("%1").arg(p->lppe);
-            if (ride->areDataPresent()->rppe) out += ", \"RPPE\":" + QString("%1").arg(p->rppe);
-            if (ride->areDataPresent()->lpppb) out += ", \"LPPPB\":" + QString("%1").arg(p->lpppb);
-            if (ride->areDataPresent()->rpppb) out += ", \"RPPPB\":" + QString("%1").arg(p->rpppb);
-            if (ride->areDataPresent()->lpppe) out += ", \"LPPPE\":" + QString("%1").arg(p->lpppe);
-            if (ride->areDataPresent()->rpppe) out += ", \"RPPPE\":" + QString("%1").arg(p->rpppe);
-            if (ride->areDataPresent()->smo2) out += ", \"SMO2\":" + QString("%1").arg(p->smo2);
-            if (ride->areDataPresent()->thb) out += ", \"THB\":" + QString("%1").arg(p->thb);
-            if (ride->areDataPresent()->rcad) out += ", \"RCAD\":" + QString("%1").arg(p->rcad);
-            if (ride->areDataPresent()->rvert) out += ", \"RVERT\":" + QString("%1").arg(p->rvert);
-            if (ride->areDataPresent()->rcontact) out += ", \"RCON\":" + QString("%1").arg(p->rcontact);
+            out << "\"SECS\":" << p->secs;
+
+            if (present->km) out << ", \"KM\":" << p->km;
+            if (present->watts && withWatts) out << ", \"WATTS\":" << p->watts;
+            if (present->nm) out << ", \"NM\":" << p->nm;
+            if (present->cad && withCad) out << ", \"CAD\":" << p->cad;
+            if (present->kph) out << ", \"KPH\":" << p->kph;
+            if (present->hr && withHr) out << ", \"HR\":" << p->hr;
+            if (present->alt && withAlt) out << ", \"ALT\":" << p->alt;
+            if (present->lat) {
+                out << ", \"LAT\":";
+                out.number(p->lat, 11);
+            }
+            if (present->lon) {
+                out << ", \"LON\":";
+                out.number(p->lon, 11);
+            }
+            if (present->headwind) out << ", \"HEADWIND\":" << p->headwind;
+            if (present->slope) out << ", \"SLOPE\":" << p->slope;
+            if (present->temp && p->temp != RideFile::NA) out << ", \"TEMP\":" << p->temp;
+            if (present->lrbalance && p->lrbalance != RideFile::NA) out << ", \"LRBALANCE\":" << p->lrbalance;
+            if (present->lte) out << ", \"LTE\":" << p->lte;
+            if (present->rte) out << ", \"RTE\":" << p->rte;
+            if (present->lps) out << ", \"LPS\":" << p->lps;
+            if (present->rps) out << ", \"RPS\":" << p->rps;
+            if (present->lpco) out << ", \"LPCO\":" << p->lpco;
+            if (present->rpco) out << ", \"RPCO\":" << p->rpco;
+            if (present->lppb) out << ", \"LPPB\":" << p->lppb;
+            if (present->rppb) out << ", \"RPPB\":" << p->rppb;
+            if (present->lppe) out << ", \"LPPE\":" << p->lppe;
+            if (present->rppe) out << ", \"RPPE\":" << p->rppe;
+            if (present->lpppb) out << ", \"LPPPB\":" << p->lpppb;
+            if (present->rpppb) out << ", \"RPPPB\":" << p->rpppb;
+            if (present->lpppe) out << ", \"LPPPE\":" << p->lpppe;
+            if (present->rpppe) out << ", \"RPPPE\":" << p->rpppe;
+            if (present->smo2) out << ", \"SMO2\":" << p->smo2;
+            if (present->thb) out << ", \"THB\":" << p->thb;
+            if (present->rcad) out << ", \"RCAD\":" << p->rcad;
+            if (present->rvert) out << ", \"RVERT\":" << p->rvert;
+            if (present->rcontact) out << ", \"RCON\":" << p->rcontact;
 
             // sample points in here!
-            out += " }";
+            out << " }";
         }
-        out +="\n\t\t]";
+        out << "\n\t\t]";
     }
 
     //
@@ -667,7 +749,7 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
     //
     if (const_cast<RideFile*>(ride)->xdata().count()) {
         // output the xdata series
-        out += ",\n\t\t\"XDATA\":[\n";
+        out << ",\n\t\t\"XDATA\":[\n";
 
         bool first = true;
         QMapIterator<QString,XDataSeries*> xdata(const_cast<RideFile*>(ride)->xdata());
@@ -682,90 +764,88 @@ JsonFileReader::toByteArray(Context *, const RideFile *ride, bool withAlt, bool
             // does it have values names?
             if (series->valuename.isEmpty()) continue;
 
-            if (!first) out += ",\n";
-            out += "\t\t{\n";
+            if (!first) out << ",\n";
+            out << "\t\t{\n";
 
             // series name
-            out += "\t\t\t\"NAME\" : \"" + xdata.key() + "\",\n";
+            out << "\t\t\t\"NAME\" : \"" << xdata.key() << "\",\n";
 
             // value names
             if (series->valuename.count() > 1) {
-                out += "\t\t\t\"VALUES\" : [ ";
+                out << "\t\t\t\"VALUES\" : [ ";
                 bool firstv=true;
                 foreach(QString x, series->valuename) {
-                    if (!firstv) out += ", ";
-                    out += "\"" + x + "\"";
+                    if (!firstv) out << ", ";
+                    out << "\"" << x << "\"";
                     firstv=false;
                 }
-                out += " ]";
+                out << " ]";
             } else {
-                out += "\t\t\t\"VALUE\" : \"" + series->valuename[0] + "\"";
+                out << "\t\t\t\"VALUE\" : \"" << series->valuename[0] << "\"";
             }
 
             // unit names
             if (series->unitname.count() > 1) {
-                out += ",\n\t\t\t\"UNITS\" : [ ";
+                out << ",\n\t\t\t\"UNITS\" : [ ";
                 bool firstv=true;
                 foreach(QString x, series->unitname) {
-                    if (!firstv) out += ", ";
-                    out += "\"" + x + "\"";
+                    if (!firstv) out << ", ";
+                    out << "\"" << x << "\"";
                     firstv=false;
                 }
-                out += " ]";
+                out << " ]";
             } else {
-                if (series->unitname.count() > 0) out += ",\n\t\t\t\"UNIT\" : \"" + series->unitname[0] + "\"";
+                if (series->unitname.count() > 0) out << ",\n\t\t\t\"UNIT\" : \"" << series->unitname[0] << "\"";
             }
 
             // samples
             if (series->datapoints.count()) {
-                out += ",\n\t\t\t\"SAMPLES\" : [\n";
+                out << ",\n\t\t\t\"SAMPLES\" : [\n";
 
                 bool firsts=true;
                 foreach(XDataPoint *p, series->datapoints) {
-                    if (!firsts) out += ",\n";
+                    if (!firsts) out << ",\n";
 
                     // multi value sample
                     if (series->valuename.count()>1) {
 
-                        out += "\t\t\t\t{ \"SECS\":"+QString("%1").arg(p->secs) +", "
-                            + "\"KM\":"+QString("%1").arg(p->km) + ", "
-                            + "\"VALUES\":[ ";
+                        out << "\t\t\t\t{ \"SECS\":" << p->secs << ", "
+                            << "\"KM\":" << p->km << ", "
+                            << "\"VALUES\":[ ";
 
                         bool firstvv=true;
                         for(int i=0; i<series->valuename.count(); i++) {
-                            if (!firstvv) out += ", ";
-                            out += QString("%1").arg(p->number[i]);
+                            if (!firstvv) out << ", ";
+                            out << p->number[i];
                             firstvv=false;
                          }
-                         out += " ] }";
+                         out << " ] }";
 
                     } else {
 
-                        out += "\t\t\t\t{ \"SECS\":"+QString("%1").arg(p->secs) + ", "
-                            + "\"KM\":"+QString("%1").arg(p->km) + ", "
-                            + "\"VALUE\":" + QString("%1").arg(p->number[0]) + " }";
+                        out << "\t\t\t\t{ \"SECS\":" << p->secs << ", "
+                            << "\"KM\":" << p->km << ", "
+                            << "\"VALUE\":" << p->number[0] << " }";
                     }
                     firsts = false;
                 }
 
-                out += "\n\t\t\t]\n";
+                out << "\n\t\t\t]\n";
             } else {
-                out += "\n";
+                out << "\n";
             }
 
-            out += "\t\t}";
+            out << "\t\t}";
 
             // now do next
             first = false;
         }
 
-        out += "\n\t\t]";
+        out << "\n\t\t]";
     }
 
     // end of ride and document
-    out += "\n\t}\n}\n";
-
-    return out;
+    out << "\n\t}\n}\n";
 }
 
 // Writes valid .json (validated at www.jsonlint.com)
@@ -778,16 +858,11 @@ JsonFileReader::writeRideFile(Context *context, const RideFile *ride, QFile &fil
     // truncate existing
     file.resize(0);
 
-    QByteArray xml = toByteArray(context, ride, true, true, true, true);
-
-    // setup streamer
-    QTextStream out(&file);
     // unified codepage and BOM for identification on all platforms
-    out.setCodec("UTF-8");
-    out.setGenerateByteOrderMark(true);
+    file.write("\xEF\xBB\xBF");
 
-    out << xml;
-    out.flush();
+    // stream it out
+    toDevice(&file, context, ride, true, true, true, true);
 
     // close
     file.close();
@@ -0,0 +1,493 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "NativeRideFile.h"
+#include "Athlete.h"
+#include "Context.h"
+#include <QDataStream>
+#include <QThread>
+#include <QtEndian>
+#include <QDebug>
+
+// file layout
+//
+//   quint32 magic, quint32 version, qint64 source size, qint64 source modified,
+//   quint32 samples, quint32 blocks
+//   blocks x { qint32 id, quint32 offset, quint32 length }
+//   block data, each one qCompress'ed
+//
+// block id -1 is the metadata, the rest are RideFile::SeriesType values with
+// the series stored as little endian doubles, one for every sample. The source
+// is the .json a cached copy was read from, its size and modification time in
+// msecs since the epoch, both are zero for files that are not a cached copy
+static const quint32 NATIVE_MAGIC = 0x47434e46; // "GCNF"
+static const quint32 NATIVE_VERSION = 2;
+static const qint32 NATIVE_METADATA = -1;
+static const quint32 NATIVE_MAXBLOCKS = 256; // anything more is corrupt
+
+// the series that are stored, same as .json
+static const RideFile::SeriesType nativeSeries[] = {
+    RideFile::secs, RideFile::cad, RideFile::hr, RideFile::km, RideFile::kph, RideFile::nm,
+    RideFile::watts, RideFile::alt, RideFile::lon, RideFile::lat, RideFile::headwind,
+    RideFile::slope, RideFile::temp, RideFile::lrbalance, RideFile::lte, RideFile::rte,
+    RideFile::lps, RideFile::rps, RideFile::lpco, RideFile::rpco, RideFile::lppb, RideFile::rppb,
+    RideFile::lppe, RideFile::rppe, RideFile::lpppb, RideFile::rpppb, RideFile::lpppe, RideFile::rpppe,
+    RideFile::smo2, RideFile::thb, RideFile::rvert, RideFile::rcad, RideFile::rcontact, RideFile::tcore,
+    RideFile::none
+};
+
+struct NativeBlock {
+    qint32 id;
+    quint32 offset, length;
+};
+
+static int nativeFileReaderRegistered =
+    RideFileFactory::instance().registerReader(
+        "gcn", "GoldenCheetah Native", new NativeFileReader());
+
+// read the block index, file must be open
+static bool
+readIndex(QFile &file, QStringList &errors, qint64 &size, qint64 &modified, quint32 &samples, QList<NativeBlock> &index)
+{
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version, blocks;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != NATIVE_MAGIC) {
+        errors << QObject::tr("Not a GoldenCheetah native file.");
+        return false;
+    }
+    if (version != NATIVE_VERSION) {
+        errors << QObject::tr("GoldenCheetah native file is from a different version.");
+        return false;
+    }
+
+    in >> size >> modified >> samples >> blocks;
+    if (in.status() != QDataStream::Ok) {
+        errors << QObject::tr("Truncated GoldenCheetah native file.");
+        return false;
+    }
+
+    if (blocks > NATIVE_MAXBLOCKS) {
+        errors << QObject::tr("Corrupt GoldenCheetah native file.");
+        return false;
+    }
+
+    for (quint32 i=0; i<blocks; i++) {
+        NativeBlock block;
+        in >> block.id >> block.offset >> block.length;
+        if (in.status() != QDataStream::Ok || quint64(block.offset) + block.length > quint64(file.size())) {
+            errors << QObject::tr("Truncated GoldenCheetah native file.");
+            return false;
+        }
+        if (block.id < NATIVE_METADATA || block.id >= qint32(RideFile::none)) {
+            errors << QObject::tr("Corrupt GoldenCheetah native file.");
+            return false;
+        }
+        index << block;
+    }
+    return true;
+}
+
+// get a block and uncompress it
+static QByteArray
+readBlock(QFile &file, const QList<NativeBlock> &index, qint32 id)
+{
+    foreach(NativeBlock block, index) {
+        if (block.id == id && file.seek(block.offset))
+            return qUncompress(file.read(block.length));
+    }
+    return QByteArray();
+}
+
+// everything but the samples, false if the block is truncated or corrupt
+static bool
+readMetadata(const QByteArray &block, RideFile *ride)
+{
+    QDataStream in(block);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    QDateTime startTime;
+    double recIntSecs;
+    QString deviceType, fileFormat, id;
+    in >> startTime >> recIntSecs >> deviceType >> fileFormat >> id;
+    if (in.status() != QDataStream::Ok) return false;
+    ride->setStartTime(startTime.toLocalTime());
+    ride->setRecIntSecs(recIntSecs);
+    ride->setDeviceType(deviceType);
+    ride->setFileFormat(fileFormat);
+    ride->setId(id);
+
+    QMap<QString,QString> tags;
+    in >> tags >> ride->metricOverrides;
+    if (in.status() != QDataStream::Ok) return false;
+    QMapIterator<QString,QString> t(tags);
+    while (t.hasNext()) {
+        t.next();
+        ride->setTag(t.key(), t.value());
+    }
+
+    qint32 count;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0) return false;
+    for (int i=0; i<count; i++) {
+        QString name;
+        double start, stop;
+        QColor color;
+        bool test;
+        in >> name >> start >> stop >> color >> test;
+        if (in.status() != QDataStream::Ok) return false;
+        ride->addInterval(RideFileInterval::USER, start, stop, name, color, test);
+    }
+
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0) return false;
+    for (int i=0; i<count; i++) {
+        QString name;
+        double start;
+        qint32 value;
+        in >> name >> start >> value;
+        if (in.status() != QDataStream::Ok) return false;
+        ride->addCalibration(start, value, name);
+    }
+
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0) return false;
+    for (int i=0; i<count; i++) {
+        RideFilePoint p;
+        in >> p.secs >> p.watts >> p.cad >> p.hr;
+        if (in.status() != QDataStream::Ok) return false;
+        ride->appendReference(p);
+    }
+
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0) return false;
+    for (int i=0; i<count; i++) {
+        XDataSeries *series = new XDataSeries();
+        qint32 points;
+        in >> series->name >> series->valuename >> series->unitname >> points;
+        if (in.status() != QDataStream::Ok || points < 0) {
+            delete series;
+            return false;
+        }
+
+        int values = qMin(series->valuename.count(), XDATA_MAXVALUES);
+        for (int j=0; j<points; j++) {
+            XDataPoint *p = new XDataPoint();
+            in >> p->secs >> p->km;
+            for (int k=0; k<values; k++) in >> p->number[k];
+            series->datapoints << p;
+            if (in.status() != QDataStream::Ok) {
+                delete series;
+                return false;
+            }
+        }
+        ride->addXData(series->name, series);
+    }
+    return true;
+}
+
+static QVector<double>
+seriesFromBlock(const QByteArray &block, quint32 samples)
+{
+    QVector<double> returning;
+    if (quint32(block.size()) < samples * sizeof(double)) return returning;
+
+    returning.resize(samples);
+    const uchar *from = reinterpret_cast<const uchar*>(block.constData());
+    for (quint32 i=0; i<samples; i++) {
+        quint64 bits = qFromLittleEndian<quint64>(from + (i * sizeof(double)));
+        memcpy(&returning[i], &bits, sizeof(double));
+    }
+    return returning;
+}
+
+static void
+setValue(RideFilePoint &p, RideFile::SeriesType series, double value)
+{
+    switch (series) {
+    case RideFile::secs : p.secs = value; break;
+    case RideFile::cad : p.cad = value; break;
+    case RideFile::hr : p.hr = value; break;
+    case RideFile::km : p.km = value; break;
+    case RideFile::kph : p.kph = value; break;
+    case RideFile::nm : p.nm = value; break;
+    case RideFile::watts : p.watts = value; break;
+    case RideFile::alt : p.alt = value; break;
+    case RideFile::lon : p.lon = value; break;
+    case RideFile::lat : p.lat = value; break;
+    case RideFile::headwind : p.headwind = value; break;
+    case RideFile::slope : p.slope = value; break;
+    case RideFile::temp : p.temp = value; break;
+    case RideFile::lrbalance : p.lrbalance = value; break;
+    case RideFile::lte : p.lte = value; break;
+    case RideFile::rte : p.rte = value; break;
+    case RideFile::lps : p.lps = value; break;
+    case RideFile::rps : p.rps = value; break;
+    case RideFile::lpco : p.lpco = value; break;
+    case RideFile::rpco : p.rpco = value; break;
+    case RideFile::lppb : p.lppb = value; break;
+    case RideFile::rppb : p.rppb = value; break;
+    case RideFile::lppe : p.lppe = value; break;
+    case RideFile::rppe : p.rppe = value; break;
+    case RideFile::lpppb : p.lpppb = value; break;
+    case RideFile::rpppb : p.rpppb = value; break;
+    case RideFile::lpppe : p.lpppe = value; break;
+    case RideFile::rpppe : p.rpppe = value; break;
+    case RideFile::smo2 : p.smo2 = value; break;
+    case RideFile::thb : p.thb = value; break;
+    case RideFile::rvert : p.rvert = value; break;
+    case RideFile::rcad : p.rcad = value; break;
+    case RideFile::rcontact : p.rcontact = value; break;
+    case RideFile::tcore : p.tcore = value; break;
+    default: break;
+    }
+}
+
+RideFile *
+NativeFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        errors << "Could not open file.";
+        return NULL;
+    }
+
+    qint64 size, modified;
+    quint32 samples;
+    QList<NativeBlock> index;
+    if (!readIndex(file, errors, size, modified, samples, index)) {
+        file.close();
+        return NULL;
+    }
+
+    RideFile *ride = new RideFile();
+    if (!readMetadata(readBlock(file, index, NATIVE_METADATA), ride)) {
+        errors << QObject::tr("Corrupt metadata in GoldenCheetah native file.");
+        file.close();
+        delete ride;
+        return NULL;
+    }
+
+    // all the series that are present
+    QList<RideFile::SeriesType> series;
+    QList<QVector<double> > values;
+    foreach(NativeBlock block, index) {
+        if (block.id == NATIVE_METADATA) continue;
+
+        QVector<double> column = seriesFromBlock(readBlock(file, index, block.id), samples);
+        if (quint32(column.count()) != samples) {
+            errors << QObject::tr("Corrupt series in GoldenCheetah native file.");
+            file.close();
+            delete ride;
+            return NULL;
+        }
+        series << static_cast<RideFile::SeriesType>(block.id);
+        values << column;
+    }
+    file.close();
+
+    // secs are always stored
+    if (samples && series.isEmpty()) {
+        errors << QObject::tr("Corrupt series in GoldenCheetah native file.");
+        delete ride;
+        return NULL;
+    }
+
+    // and rebuild the samples, which also sets what data is present
+    for (quint32 i=0; i<samples; i++) {
+        RideFilePoint p;
+        for (int j=0; j<series.count(); j++) setValue(p, series[j], values[j][i]);
+        ride->appendPoint(p);
+    }
+
+    return ride;
+}
+
+// the source size and time are recorded in the header
+static bool
+writeNative(const RideFile *ride, QFile &file, qint64 size, qint64 modified)
+{
+    // metadata block
+    QByteArray metadata;
+    QDataStream out(&metadata, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    out << ride->startTime().toUTC() << ride->recIntSecs() << ride->deviceType() << ride->fileFormat() << ride->id();
+    out << ride->tags() << ride->metricOverrides;
+
+    out << qint32(ride->intervals().count());
+    foreach(RideFileInterval *i, ride->intervals())
+        out << i->name << i->start << i->stop << i->color << i->test;
+
+    out << qint32(ride->calibrations().count());
+    foreach(RideFileCalibration *i, ride->calibrations())
+        out << i->name << i->start << qint32(i->value);
+
+    out << qint32(ride->referencePoints().count());
+    foreach(RideFilePoint *p, ride->referencePoints())
+        out << p->secs << p->watts << p->cad << p->hr;
+
+    // only xdata with value names, same as .json
+    QList<XDataSeries*> xdata;
+    foreach(XDataSeries *series, const_cast<RideFile*>(ride)->xdata())
+        if (!series->valuename.isEmpty()) xdata << series;
+
+    out << qint32(xdata.count());
+    foreach(XDataSeries *series, xdata) {
+        out << series->name << series->valuename << series->unitname << qint32(series->datapoints.count());
+        int values = qMin(series->valuename.count(), XDATA_MAXVALUES);
+        foreach(XDataPoint *p, series->datapoints) {
+            out << p->secs << p->km;
+            for (int k=0; k<values; k++) out << p->number[k];
+        }
+    }
+
+    // the blocks
+    QList<qint32> ids;
+    QList<QByteArray> blocks;
+    ids << NATIVE_METADATA;
+    blocks << qCompress(metadata);
+
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+    for (int s=0; nativeSeries[s] != RideFile::none; s++) {
+
+        RideFile::SeriesType series = nativeSeries[s];
+        if (series != RideFile::secs && !const_cast<RideFile*>(ride)->isDataPresent(series)) continue;
+
+        QByteArray column(points.count() * sizeof(double), 0);
+        uchar *to = reinterpret_cast<uchar*>(column.data());
+        for (int i=0; i<points.count(); i++) {
+            double value = points[i]->value(series);
+            quint64 bits;
+            memcpy(&bits, &value, sizeof(double));
+            qToLittleEndian<quint64>(bits, to + (i * sizeof(double)));
+        }
+
+        ids << qint32(series);
+        blocks << qCompress(column);
+    }
+
+    // write the index and then the blocks
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.resize(0);
+
+    QDataStream header(&file);
+    header.setVersion(QDataStream::Qt_4_6);
+    header << NATIVE_MAGIC << NATIVE_VERSION << size << modified << quint32(points.count()) << quint32(blocks.count());
+
+    quint32 offset = 4 * sizeof(quint32) + 2 * sizeof(qint64) + blocks.count() * 3 * sizeof(quint32);
+    for (int i=0; i<blocks.count(); i++) {
+        header << ids[i] << offset << quint32(blocks[i].size());
+        offset += blocks[i].size();
+    }
+    foreach(QByteArray block, blocks) file.write(block);
+
+    bool ok = (header.status() == QDataStream::Ok && file.error() == QFile::NoError);
+    file.close();
+
+    return ok;
+}
+
+bool
+NativeFileReader::writeRideFile(Context *, const RideFile *ride, QFile &file) const
+{
+    return writeNative(ride, file, 0, 0);
+}
+
+QString
+NativeFileReader::cacheFile(Context *context, QString filename)
+{
+    if (context == NULL || context->athlete == NULL) return QString();
+
+    // only the athlete's own activities
+    QFileInfo info(filename);
+    if (info.suffix().toLower() != "json") return QString();
+    if (info.absoluteDir().canonicalPath() != context->athlete->home->activities().canonicalPath()) return QString();
+
+    return QString("%1/activities/%2.gcn").arg(context->athlete->home->cache().absolutePath()).arg(info.completeBaseName());
+}
+
+RideFile *
+NativeFileReader::openCache(Context *context, QFile &file)
+{
+    QString name = cacheFile(context, file.fileName());
+    if (name.isEmpty()) return NULL;
+
+    QFile in(name);
+    if (!in.exists()) return NULL;
+
+    // must have been read from the .json as it is now
+    QStringList errors;
+    qint64 size, modified;
+    quint32 samples;
+    QList<NativeBlock> index;
+    bool stale = true;
+    if (in.open(QIODevice::ReadOnly)) {
+        if (readIndex(in, errors, size, modified, samples, index)) {
+            QFileInfo source(file.fileName());
+            stale = (size != source.size() || modified != source.lastModified().toMSecsSinceEpoch());
+        }
+        in.close();
+    }
+    if (stale) {
+        // out of date or unreadable, it gets written again
+        QFile::remove(name);
+        return NULL;
+    }
+
+    RideFile *ride = NativeFileReader().openRideFile(in, errors);
+    if (ride == NULL || errors.count()) {
+
+        // corrupt, fall back to the .json and write it again
+        delete ride;
+        QFile::remove(name);
+        return NULL;
+    }
+    return ride;
+}
+
+bool
+NativeFileReader::updateCache(Context *context, const RideFile *ride, QString filename, qint64 size, QDateTime modified)
+{
+    QString name = cacheFile(context, filename);
+    if (name.isEmpty()) return false;
+
+    QDir().mkpath(QFileInfo(name).absolutePath());
+
+    // write alongside and swap in, it may be read or written by
+    // another thread at the same time
+    QFile out(QString("%1.%2.tmp").arg(name).arg(quintptr(QThread::currentThreadId())));
+    if (!writeNative(ride, out, size, modified.toMSecsSinceEpoch())) {
+        out.remove();
+        return false;
+    }
+    QFile::remove(name);
+    if (!out.rename(name)) {
+        out.remove();
+        return false;
+    }
+    return true;
+}
+
+void
+NativeFileReader::removeCache(Context *context, QString filename)
+{
+    QString name = cacheFile(context, filename);
+    if (!name.isEmpty()) QFile::remove(name);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2019 GoldenCheetah contributors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _NativeRideFile_h
+#define _NativeRideFile_h
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+
+// Native binary activity container
+//
+// An index of blocks, then a compressed block with everything but the samples
+// (metadata, intervals, calibrations, references and xdata) followed by one
+// compressed block per data series, so each block can be read on its own.
+//
+// .json remains the format for interchange and the activities folder, each
+// activity is also kept as .gcn in the athlete cache folder. RideFileFactory
+// reads that instead of parsing the .json whenever it is up to date; the
+// header records the size and modification time of the .json it came from.
+
+struct NativeFileReader : public RideFileReader {
+    virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+    bool writeRideFile(Context *, const RideFile *ride, QFile &file) const;
+    bool hasWrite() const { return true; }
+
+    // the cached copy of an activity .json, name is empty if there isn't one
+    // updateCache is passed the .json size and time from before it was read
+    static QString cacheFile(Context *context, QString filename);
+    static RideFile *openCache(Context *context, QFile &file); // NULL if missing or stale
+    static bool updateCache(Context *context, const RideFile *ride, QString filename, qint64 size, QDateTime modified);
+    static void removeCache(Context *context, QString filename);
+};
+
+#endif // _NativeRideFile_h
@@ -28,8 +28,10 @@
 #include "Settings.h"
 #include "Colors.h"
 #include "Units.h"
+#include "NativeRideFile.h"
 
 #include <QtXml/QtXml>
+#include <QTemporaryDir>
 #include <algorithm> // for std::lower_bound
 #include <assert.h>
 #ifdef Q_CC_MSVC
@@ -827,8 +829,10 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
     // if we uncompressed a ride, we need to save to a temporary ride for import
     if (uncompressed) {
 
-        // create a temporary ride
-        QString tmp = context->athlete->home->temp().absolutePath() + "/" + QFileInfo(file.fileName()).baseName() + "." + suffix;
+        // create a temporary ride, in a directory of its own since
+        // files with the same name may be decoded at the same time
+        QTemporaryDir tmpdir(context->athlete->home->temp().absolutePath() + "/import-XXXXXX");
+        QString tmp = tmpdir.path() + "/" + QFileInfo(file.fileName()).baseName() + "." + suffix;
 
         QFile ufile(tmp); // look at uncompressed version mot the source
         ufile.open(QFile::ReadWrite);
@@ -843,8 +847,18 @@ RideFile *RideFileFactory::openRideFile(Context *context, QFile &file,
 
     } else {
 
-        // open and read the file
-        result = reader->openRideFile(file, errors, rideList);
+        // activities are read from their native copy if it is up to date,
+        // otherwise parse and keep a native copy for next time, it records
+        // the .json as it was before we read it in case it changes meanwhile
+        result = NativeFileReader::openCache(context, file);
+        if (result == NULL) {
+            QFileInfo source(file.fileName());
+            qint64 size = source.size();
+            QDateTime modified = source.lastModified();
+
+            result = reader->openRideFile(file, errors, rideList);
+            if (result) NativeFileReader::updateCache(context, result, file.fileName(), size, modified);
+        }
     }
 
     // if it was successful, lets post process the file
@@ -1697,6 +1697,31 @@ static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVec
         }
 }
 
+// heat is how many rides are within 10% of the best at each duration, since the
+// best only ever goes up we only need to remember the values that might still
+// qualify, so we can count them in the same pass as the bests are aggregated
+// NOTE: best must already include this ride i.e. call after meanMaxAggregate
+static void heatAggregate(QVector<QVector<double> > &candidates, QVector<double> &other, QVector<double> &best)
+{
+    if (candidates.size() < other.size()) candidates.resize(other.size());
+
+    for (int i=0; i<other.size() && i<best.size(); i++) {
+
+        double threshold = 0.9f * best[i];
+        if (other[i] < threshold) continue;
+
+        // we set a new best so drop any that no longer qualify
+        QVector<double> &here = candidates[i];
+        if (other[i] == best[i]) {
+            int keep=0;
+            for (int j=0; j<here.size(); j++)
+                if (here[j] >= threshold) here[keep++] = here[j];
+            here.resize(keep);
+        }
+        here << other[i];
+    }
+}
+
 // resize into and then sum the arrays
 static void distAggregate(QVector<double> &into, QVector<double> &other)
 {
@@ -1709,11 +1734,6 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
                : start(start), end(end), incomplete(false), context(context), rideFileName(""), ride(0)
 {
 
-    // remember parameters for getting heat
-    this->filter = filter;
-    this->files = files;
-    this->onhome = onhome;
-
     // Oh lets get from the cache if we can -- but not if filtered
     if (!filter && !context->isfiltered && !rideItem) {
 
@@ -1769,6 +1789,9 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     paceCPTimeInZone.resize(4);
     wbalTimeInZone.resize(4);
 
+    // values that might count toward the heat at each duration
+    QVector<QVector<double> > heatCandidates;
+
     // set cursor busy whilst we aggregate -- bit of feedback
     // and less intrusive than a popup box
     context->mainWindow->setCursor(Qt::WaitCursor);
@@ -1798,6 +1821,7 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
 
                 // lets aggregate
                 meanMaxAggregate(wattsMeanMaxDouble, rideCache.wattsMeanMaxDouble, wattsMeanMaxDate, rideDate);
+                heatAggregate(heatCandidates, rideCache.wattsMeanMaxDouble, wattsMeanMaxDouble);
                 meanMaxAggregate(hrMeanMaxDouble, rideCache.hrMeanMaxDouble, hrMeanMaxDate, rideDate);
                 meanMaxAggregate(cadMeanMaxDouble, rideCache.cadMeanMaxDouble, cadMeanMaxDate, rideDate);
                 meanMaxAggregate(nmMeanMaxDouble, rideCache.nmMeanMaxDouble, nmMeanMaxDate, rideDate);
@@ -1846,6 +1870,14 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
     // set the cursor back to normal
     context->mainWindow->setCursor(Qt::ArrowCursor);
 
+    // count the heat against the final bests
+    heatMeanMax.resize(wattsMeanMaxDouble.size());
+    for (int i=0; i<heatCandidates.size() && i<wattsMeanMaxDouble.size(); i++) {
+        double threshold = 0.9f * wattsMeanMaxDouble[i];
+        foreach(double value, heatCandidates[i])
+            if (value >= threshold) heatMeanMax[i] = heatMeanMax[i] + 1;
+    }
+
     // lets add to the cache for others to re-use -- but not if filtered or incomplete
     if (incomplete == false && !context->isfiltered && (!context->ishomefiltered || !onhome) && !filter) {
 
@@ -1858,41 +1890,11 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
 }
 
 //
-// Get heat mean max -- if an aggregated curve
+// Get heat mean max -- if an aggregated curve it was
+// computed alongside the bests when we aggregated
 //
 QVector<float> &RideFileCache::heatMeanMaxArray()
 {
-    // not aggregated or already done it return the result
-    if (ride || heatMeanMax.count()) return heatMeanMax;
-
-    // make it big enough
-    heatMeanMax.resize(wattsMeanMaxDouble.size());
-
-    // ok, we need to iterate again and compute heat based upon
-    // how close to the absolute best we've got
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
-
-        QDate rideDate = item->dateTime.date();
-
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
-
-            // skip globally filtered values
-            if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
-            if (onhome && context->ishomefiltered && !context->homeFilters.contains(item->fileName)) continue;
-
-            // get its cached values (will refresh if needed...)
-            RideFileCache rideCache(context, context->athlete->home->activities().canonicalPath() + "/" + item->fileName, item->getWeight());
-
-            for(int i=0; i<rideCache.wattsMeanMaxDouble.count() && i<wattsMeanMaxDouble.count(); i++) {
-
-                // is it within 10% of the best we have ?
-                if (rideCache.wattsMeanMaxDouble[i] >= (0.9f * wattsMeanMaxDouble[i]))
-                    heatMeanMax[i] = heatMeanMax[i] + 1;
-            }
-        }
-    }
-
     return heatMeanMax;
 }
 
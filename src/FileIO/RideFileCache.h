@@ -215,7 +215,7 @@ class RideFileCache
         QVector<float> &paceCPZoneArray() { return paceCPTimeInZone; } // Polarized Zones
         QVector<float> &wbalZoneArray() { return wbalTimeInZone; } // Polarized Zones
 
-        QVector<float> &heatMeanMaxArray();  // will compute if neccessary
+        QVector<float> &heatMeanMaxArray();  // computed when aggregating
 
         // explain the array binning / sampling
         double &distBinSize(RideFile::SeriesType); // return distribution bin size
@@ -279,8 +279,6 @@ class RideFileCache
 
         QVector<float> heatMeanMax; // The heat of training for aggregated power data
 
-        bool filter, onhome; // saving parameters re-used when aggregating heat
-        QStringList files;
 
 
         QVector<double> wattsMeanMaxDouble; // RideFile::watts
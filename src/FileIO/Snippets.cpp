@@ -198,8 +198,8 @@ Snippets::postProcess(RideFile *ride, DataProcessorConfig *config=0, QString op=
                 // create an interval item for each interval
                 IntervalItem interval(&rideItem, ri->name, ri->start, ri->stop, 0, 0, 1,
                                              QColor(Qt::black), ri->test, RideFileInterval::USER);
-                // refresh metrics
-                interval.refresh();
+                // refresh metrics, all of them whilst we have the ride
+                interval.refresh(true);
 
                 // lists of intervals
                 if (first) out << "\n";
@@ -28,6 +28,8 @@
 #include "WPrime.h"
 #include "HelpWhatsThis.h"
 #include <QMap>
+#include <QMutex>
+#include <QThreadStorage>
 #include <cmath>
 
 // helper function
@@ -843,128 +845,222 @@ AddIntervalDialog::findPeakPowerStandard(Context *context, const RideFile *ride,
     findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 3600, 1, results, prefix, "");
 }
 
+// the best window only, this is what the peak metrics and the
+// standard intervals want so avoid collecting and sorting them all.
+// same arithmetic as findPeaks so the averages are identical
+bool
+AddIntervalDialog::findPeak(bool typeTime, const RideFile *ride, Specification spec,
+                            RideFile::SeriesType series, double windowSize, AddedInterval &peak)
+{
+    QVector<AddedInterval> peaks;
+    QVector<bool> found;
+    findPeakWindows(typeTime, ride, spec, series, QVector<double>() << windowSize, peaks, found);
+
+    if (found[0]) peak = peaks[0];
+    return found[0];
+}
+
+void
+AddIntervalDialog::findPeakWindows(bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                                   const QVector<double> &windowSizes, QVector<AddedInterval> &peaks, QVector<bool> &found)
+{
+    int n = windowSizes.count();
+    peaks.fill(AddedInterval(), n);
+    found.fill(false, n);
+
+    if (ride->dataPoints().isEmpty()) return;
+
+    // the window is always a run of consecutive samples, so we just
+    // keep track of where each one starts in the ride
+    RideFileIterator it(const_cast<RideFile*>(ride), spec);
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+    if (it.firstIndex() < 0) return;
+
+    double secsDelta = ride->recIntSecs();
+    QVector<int> firsts(n, it.firstIndex());
+    QVector<double> totals(n, 0.0);
+
+    // ride is shorter than the window size!
+    QVector<bool> fits(n);
+    for (int k=0; k<n; k++)
+        fits[k] = !(typeTime && windowSizes[k] > points.last()->secs + secsDelta) &&
+                  !(!typeTime && windowSizes[k] > points.last()->km*1000);
+
+    for (int last = it.firstIndex(); last <= it.lastIndex(); last++) {
+        const RideFilePoint *point = points[last];
+        double value = point->value(series);
+
+        // each window on its own, so the sums are added and taken
+        // away in exactly the order a scan for just that size would
+        for (int k=0; k<n; k++) {
+            if (!fits[k]) continue;
+
+            double windowSize = windowSizes[k];
+            int &first = firsts[k];
+            double &total = totals[k];
+
+            // Discard points until interval duration is < windowSizeSecs + secsDelta.
+            while ((typeTime && first < last && intervalDuration(points[first], point, ride) >= windowSize + secsDelta) ||
+                   (!typeTime && last-first > 1 && intervalDistance(points[first+1], point, ride) >= windowSize)) {
+                total -= points[first]->value(series);
+                first++;
+            }
+            // Add points until interval duration or distance is >= windowSize.
+            total += value;
+            double duration = intervalDuration(points[first], point, ride);
+            double distance = intervalDistance(points[first], point, ride);
+
+            if ((typeTime && duration >= windowSize) ||
+                (!typeTime && distance >= windowSize)) {
+                double avg = total * secsDelta / duration;
+
+                // ties go to the earliest, as CompareBests does
+                if (!found[k] || avg > peaks[k].avg) {
+                    peaks[k] = AddedInterval(points[first]->secs, point->secs, avg);
+                    found[k] = true;
+                }
+            }
+        }
+    }
+}
+
 void
 AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec,
                              RideFile::SeriesType series, RideFile::Conversion conversion, double windowSize,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName)
 {
-    QList<AddedInterval> bests;
     QList<AddedInterval> _results;
+    QList<AddedInterval> candidates;
 
-    double secsDelta = ride->recIntSecs();
-    double total = 0.0;
-    QList<const RideFilePoint*> window;
+    if (maxIntervals == 1) {
 
-    // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
+        // single pass, nothing to sort
+        AddedInterval peak;
+        if (!PeakCache::peak(typeTime, ride, spec, series, windowSize, peak)) return;
+        candidates << peak;
 
-    // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
-    RideFileIterator it(const_cast<RideFile*>(ride), spec);
-    while (it.hasNext()) {
-        struct RideFilePoint *point = it.next();
-
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
-               (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
-            total -= window.first()->value(series);
-            window.takeFirst();
-        }
-        // Add points until interval duration or distance is >= windowSize.
-        total += point->value(series);
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
+    } else {
 
-        if ((typeTime && duration >= windowSize) ||
-            (!typeTime && distance >= windowSize)) {
-            double start = window.first()->secs;
-            double stop = window.last()->secs; //start + duration;
-            double avg = total * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
+        QList<AddedInterval> bests;
+
+        double secsDelta = ride->recIntSecs();
+        double total = 0.0;
+        QList<const RideFilePoint*> window;
+
+        // ride is shorter than the window size!
+        if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
+        if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
+
+        // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
+        RideFileIterator it(const_cast<RideFile*>(ride), spec);
+        while (it.hasNext()) {
+            struct RideFilePoint *point = it.next();
+
+            // Discard points until interval duration is < windowSizeSecs + secsDelta.
+            while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
+                   (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
+                total -= window.first()->value(series);
+                window.takeFirst();
+            }
+            // Add points until interval duration or distance is >= windowSize.
+            total += point->value(series);
+            window.append(point);
+            double duration = intervalDuration(window.first(), window.last(), ride);
+            double distance = intervalDistance(window.first(), window.last(), ride);
+
+            if ((typeTime && duration >= windowSize) ||
+                (!typeTime && distance >= windowSize)) {
+                double start = window.first()->secs;
+                double stop = window.last()->secs; //start + duration;
+                double avg = total * secsDelta / duration;
+                bests.append(AddedInterval(start, stop, avg));
+            }
         }
-    }
 
-    std::sort(bests.begin(), bests.end(), CompareBests());
+        std::sort(bests.begin(), bests.end(), CompareBests());
 
-    while (!bests.empty() && (_results.size() < maxIntervals)) {
-        AddedInterval candidate = bests.takeFirst();
-        bool overlaps = false;
-        foreach (const AddedInterval &existing, _results) {
-            if (intervalsOverlap(candidate, existing)) {
-                overlaps = true;
-                break;
+        while (!bests.empty() && (candidates.size() < maxIntervals)) {
+            AddedInterval candidate = bests.takeFirst();
+            bool overlaps = false;
+            foreach (const AddedInterval &existing, candidates) {
+                if (intervalsOverlap(candidate, existing)) {
+                    overlaps = true;
+                    break;
+                }
             }
+            if (!overlaps) candidates.append(candidate);
         }
-        if (!overlaps) {
-            QString name = overideName;
-            if (overideName == "") {
-                name = tr("%1 %3%4 %2");
-
-                if (prefixe == "")
-                    name = name.arg(tr("Peak"));
-                else
-                    name = name.arg(prefixe);
-
-                if (maxIntervals>1)
-                    name = name.arg(QString("#%1").arg(_results.count()+1));
-                else
-                    name = name.arg("");
+    }
 
-                if (typeTime)  {
-                    // best n mins
-                    if (windowSize < 60) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("sec");
-                    } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
-                        // whole minutes
-                        name = name.arg(windowSize/60);
-                        name = name.arg("min");
-                    } else {
-                        double secs = windowSize;
-                        double mins = ((int) secs) / 60;
-                        secs = secs - mins * 60.0;
-                        double hrs = ((int) mins) / 60;
-                        mins = mins - hrs * 60.0;
-                        QString tm = "%1:%2:%3";
-                        tm = tm.arg(hrs, 0, 'f', 0);
-                        tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
-                        tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
-
-                        // mins and secs
-                        name = name.arg(tm);
-                        name = name.arg("");
-                    }
+    // name them
+    foreach (AddedInterval candidate, candidates) {
+        QString name = overideName;
+        if (overideName == "") {
+            name = tr("%1 %3%4 %2");
+
+            if (prefixe == "")
+                name = name.arg(tr("Peak"));
+            else
+                name = name.arg(prefixe);
+
+            if (maxIntervals>1)
+                name = name.arg(QString("#%1").arg(_results.count()+1));
+            else
+                name = name.arg("");
+
+            if (typeTime)  {
+                // best n mins
+                if (windowSize < 60) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("sec");
+                } else if (windowSize >= 60 && !(((int)windowSize)%60)) {
+                    // whole minutes
+                    name = name.arg(windowSize/60);
+                    name = name.arg("min");
+                } else {
+                    double secs = windowSize;
+                    double mins = ((int) secs) / 60;
+                    secs = secs - mins * 60.0;
+                    double hrs = ((int) mins) / 60;
+                    mins = mins - hrs * 60.0;
+                    QString tm = "%1:%2:%3";
+                    tm = tm.arg(hrs, 0, 'f', 0);
+                    tm = tm.arg(mins, 2, 'f', 0, QLatin1Char('0'));
+                    tm = tm.arg(secs, 2, 'f', 0, QLatin1Char('0'));
+
+                    // mins and secs
+                    name = name.arg(tm);
+                    name = name.arg("");
+                }
+            } else {
+                // best n mins
+                if (windowSize < 1000) {
+                    // whole seconds
+                    name = name.arg(windowSize);
+                    name = name.arg("m");
                 } else {
-                    // best n mins
-                    if (windowSize < 1000) {
-                        // whole seconds
-                        name = name.arg(windowSize);
-                        name = name.arg("m");
-                    } else {
-                        double dist = windowSize;
-                        double kms = ((int) dist) / 1000;
-                        dist = dist - kms * 1000.0;
-                        double ms = dist;
-
-                        QString tm = "%1,%2";
-                        tm = tm.arg(kms);
-                        tm = tm.arg(ms);
-
-                        // km and m
-                        name = name.arg(tm);
-                        name = name.arg("km");
-                    }
+                    double dist = windowSize;
+                    double kms = ((int) dist) / 1000;
+                    dist = dist - kms * 1000.0;
+                    double ms = dist;
+
+                    QString tm = "%1,%2";
+                    tm = tm.arg(kms);
+                    tm = tm.arg(ms);
+
+                    // km and m
+                    name = name.arg(tm);
+                    name = name.arg("km");
                 }
             }
-            name += " (%4)";
-            name = name.arg(ride->formatValueWithUnit(candidate.avg, series, conversion, context, ride->isSwim()));
-
-            candidate.name = name;
-            name = "";
-            _results.append(candidate);
         }
+        name += " (%4)";
+        name = name.arg(ride->formatValueWithUnit(candidate.avg, series, conversion, context, ride->isSwim()));
+
+        candidate.name = name;
+        name = "";
+        _results.append(candidate);
     }
     results.append(_results);
 }
@@ -1006,3 +1102,89 @@ AddIntervalDialog::addClicked()
 
     done(0);
 }
+
+//
+// PeakCache
+//
+
+// the cache in scope on each thread, computeMetrics may run on several
+static QThreadStorage<PeakCache*> currentPeakCache;
+
+// the windows each series is asked for, declared as metrics are created.
+// that happens during static initialisation, so these are created on
+// first use rather than relying on the order files are linked in
+struct PeakDeclarations {
+    QMutex mutex;
+    QMap<int, QVector<double> > windows;
+};
+
+static PeakDeclarations &declarations()
+{
+    static PeakDeclarations declared;
+    return declared;
+}
+
+static int
+peakKey(bool typeTime, RideFile::SeriesType series)
+{
+    return int(series) * 2 + (typeTime ? 1 : 0);
+}
+
+PeakCache::PeakCache(Specification spec) : start(spec.secsStart()), stop(spec.secsEnd())
+{
+    previous = currentPeakCache.localData();
+    currentPeakCache.setLocalData(this);
+}
+
+PeakCache::~PeakCache()
+{
+    currentPeakCache.setLocalData(previous);
+}
+
+void
+PeakCache::declare(bool typeTime, RideFile::SeriesType series, double windowSize)
+{
+    PeakDeclarations &declared = declarations();
+    QMutexLocker locker(&declared.mutex);
+    QVector<double> &sizes = declared.windows[peakKey(typeTime, series)];
+    if (!sizes.contains(windowSize)) sizes << windowSize;
+}
+
+bool
+PeakCache::peak(bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                double windowSize, AddIntervalDialog::AddedInterval &peak)
+{
+    // nothing in scope, or asked about a different part of the ride
+    PeakCache *cache = currentPeakCache.localData();
+    if (!cache || cache->start != spec.secsStart() || cache->stop != spec.secsEnd())
+        return AddIntervalDialog::findPeak(typeTime, ride, spec, series, windowSize, peak);
+
+    int key = peakKey(typeTime, series);
+    QHash<int, Windows> &cached = cache->rides[ride];
+
+    // first time this series is asked for, find them all
+    if (!cached.contains(key)) {
+        Windows &windows = cached[key];
+        PeakDeclarations &declared = declarations();
+        declared.mutex.lock();
+        windows.sizes = declared.windows.value(key);
+        declared.mutex.unlock();
+        if (!windows.sizes.contains(windowSize)) windows.sizes << windowSize;
+        AddIntervalDialog::findPeakWindows(typeTime, ride, spec, series, windows.sizes, windows.peaks, windows.found);
+    }
+
+    // one nobody declared gets its own pass
+    Windows &windows = cached[key];
+    int index = windows.sizes.indexOf(windowSize);
+    if (index < 0) {
+        AddIntervalDialog::AddedInterval found;
+        bool ok = AddIntervalDialog::findPeak(typeTime, ride, spec, series, windowSize, found);
+        windows.sizes << windowSize;
+        windows.peaks << found;
+        windows.found << ok;
+        index = windows.sizes.count() - 1;
+    }
+
+    if (windows.found[index]) peak = windows.peaks[index];
+    return windows.found[index];
+}
@@ -29,6 +29,8 @@
 #include <QMessageBox>
 #include <QCheckBox>
 #include <QButtonGroup>
+#include <QHash>
+#include <QVector>
 
 class Context;
 
@@ -55,6 +57,12 @@ class AddIntervalDialog : public QDialog
         static void findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
                               RideFile::Conversion conversion, double windowSizeSecs,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName);
+        static bool findPeak(bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                             double windowSize, AddedInterval &peak);
+
+        // the best window for each size in one pass over the samples
+        static void findPeakWindows(bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                                    const QVector<double> &windowSizes, QVector<AddedInterval> &peaks, QVector<bool> &found);
 
         static void findFirsts(bool typeTime, const RideFile *ride, double windowSizeSecs,
                                int maxIntervals, QList<AddedInterval> &results);
@@ -93,5 +101,35 @@ class AddIntervalDialog : public QDialog
         QTableWidget *resultsTable;
 };
 
+// The peak metrics each ask for the best window of a series at one
+// duration, so computing them all walks the same samples dozens of times.
+// RideMetric::computeMetrics puts one of these on the stack, the first
+// request for a series then finds every duration declared for it in a
+// single pass and the rest are answered from here.
+class PeakCache
+{
+    public:
+        PeakCache(Specification spec);
+        ~PeakCache();
+
+        // metrics declare the windows they will ask for when constructed
+        static void declare(bool typeTime, RideFile::SeriesType series, double windowSize);
+
+        // best window, from the cache in scope on this thread if any
+        static bool peak(bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                         double windowSize, AddIntervalDialog::AddedInterval &peak);
+
+    private:
+        struct Windows {
+            QVector<double> sizes;
+            QVector<AddIntervalDialog::AddedInterval> peaks;
+            QVector<bool> found;
+        };
+
+        double start, stop;
+        PeakCache *previous;
+        QHash<const RideFile*, QHash<int, Windows> > rides;
+};
+
 #endif // _GC_AddIntervalDialog_h
 
@@ -25,8 +25,12 @@
 #include "RideCache.h"
 #include "HelpWhatsThis.h"
 #include "CsvRideFile.h"
+#include "../qzip/zipwriter.h"
 
-BatchExportDialog::BatchExportDialog(Context *context) : QDialog(context->mainWindow), context(context)
+#include <QtConcurrent>
+#include <QTemporaryDir>
+
+BatchExportDialog::BatchExportDialog(Context *context) : QDialog(context->mainWindow), context(context), zip(NULL), scratch(NULL)
 {
     setAttribute(Qt::WA_DeleteOnClose);
     //setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint); // must stop using this flag!
@@ -122,9 +126,11 @@ BatchExportDialog::BatchExportDialog(Context *context) : QDialog(context->mainWi
     status = new QLabel("", this);
     status->hide();
     overwrite = new QCheckBox(tr("Overwrite existing files"), this);
+    archive = new QCheckBox(tr("Single .zip archive"), this);
     cancel = new QPushButton(tr("Cancel"), this);
     ok = new QPushButton(tr("Export"), this);
     buttons->addWidget(overwrite);
+    buttons->addWidget(archive);
     buttons->addWidget(status);
     buttons->addStretch();
     buttons->addWidget(cancel);
@@ -141,6 +147,18 @@ BatchExportDialog::BatchExportDialog(Context *context) : QDialog(context->mainWi
     connect(ok, SIGNAL(clicked()), this, SLOT(okClicked()));
     connect(all, SIGNAL(stateChanged(int)), this, SLOT(allClicked()));
     connect(cancel, SIGNAL(clicked()), this, SLOT(cancelClicked()));
+    connect(&watcher, SIGNAL(resultReadyAt(int)), this, SLOT(exportDone(int)));
+    connect(&watcher, SIGNAL(finished()), this, SLOT(exportFinished()));
+}
+
+BatchExportDialog::~BatchExportDialog()
+{
+    // closed whilst still exporting
+    watcher.cancel();
+    watcher.waitForFinished();
+    foreach(BatchExportJob *job, jobs) delete job;
+    if (zip) delete zip;
+    if (scratch) delete scratch;
 }
 
 void
@@ -176,6 +194,7 @@ BatchExportDialog::okClicked()
         aborted = false;
 
         overwrite->hide();
+        archive->hide();
         status->setText(tr("Exporting..."));
         status->show();
         cancel->hide();
@@ -183,11 +202,9 @@ BatchExportDialog::okClicked()
         appsettings->setValue(GC_BE_LASTDIR, dirName->text());
         appsettings->setValue(GC_BE_LASTFMT, format->currentIndex());
         exportFiles();
-        status->setText(QString(tr("%1 activities exported, %2 failed or skipped.")).arg(exports).arg(fails));
-        ok->setText(tr("Finish"));
-
     } else if (ok->text() == "Abort" || ok->text() == tr("Abort")) {
         aborted = true;
+        watcher.cancel();
     } else if (ok->text() == "Finish" || ok->text() == tr("Finish")) {
         accept(); // our work is done!
     }
@@ -199,34 +216,88 @@ BatchExportDialog::cancelClicked()
     reject();
 }
 
+// read and write one activity on a worker thread, the
+// ride is freed as soon as it has been written
+static BatchExportJob *exportJob(BatchExportJob *job)
+{
+    QStringList errors;
+    QList<RideFile*> rides;
+    QFile thisfile(job->source);
+    RideFile *ride = RideFileFactory::instance().openRideFile(job->context, thisfile, errors, &rides);
+    foreach(RideFile *extracted, rides) if (extracted != ride) delete extracted;
+
+    // open failed
+    if (!ride) {
+        job->readError = true;
+        return job;
+    }
+
+    QFile out(job->target);
+    if (job->allData) {
+        CsvFileReader writer;
+        job->success = writer.writeRideFile(job->context, ride, out, CsvFileReader::gc);
+    } else {
+        job->success = RideFileFactory::instance().writeRideFile(job->context, ride, out, job->type);
+    }
+    delete ride; // free memory!
+
+    // hand the contents back for the archive
+    if (job->archive) {
+        if (job->success && out.open(QIODevice::ReadOnly)) {
+            job->data = out.readAll();
+            out.close();
+        } else {
+            job->success = false;
+        }
+        out.remove();
+    }
+    return job;
+}
+
 void
 BatchExportDialog::exportFiles()
 {
     // what format to export as?
     QString type = format->currentIndex() > 0 ? RideFileFactory::instance().writeSuffixes().at(format->currentIndex()-1) : "csv";
 
-    // loop through the table and export all selected
-    for(int i=0; i<files->invisibleRootItem()->childCount(); i++) {
+    // all in one archive? the members are written to a folder of
+    // our own first, so other exports can't clash with them
+    if (archive->isChecked()) {
+        scratch = new QTemporaryDir(QDir::tempPath() + "/export-XXXXXX");
+        if (!scratch->isValid()) {
+            delete scratch;
+            scratch = NULL;
+            status->setText(tr("Cannot create a temporary folder for the archive."));
+            ok->setText(tr("Finish"));
+            return;
+        }
 
-        // give user a chance to abort..
-        QApplication::processEvents();
+        QString zipname = QString("%1/%2.zip").arg(dirName->text())
+                          .arg(QDateTime::currentDateTime().toString("yyyy_MM_dd_hh_mm_ss"));
+        zip = new ZipWriter(zipname);
+    }
 
-        // did they?
-        if (aborted == true) return; // user aborted!
+    // loop through the table and queue all selected
+    for(int i=0; i<files->invisibleRootItem()->childCount(); i++) {
 
         QTreeWidgetItem *current = files->invisibleRootItem()->child(i);
 
         // is it selected
         if (static_cast<QCheckBox*>(files->itemWidget(current,0))->isChecked()) {
 
-            files->setCurrentItem(current); QApplication::processEvents();
+            QString name = QFileInfo(current->text(1)).baseName() + "." + type;
+            QString filename = dirName->text() + "/" + name;
+
+            if (zip) {
 
-            QString filename = dirName->text() + "/" + QFileInfo(current->text(1)).baseName() + "." + type;
+                // written to a temporary file then added to the archive,
+                // numbered since activities can share a name
+                filename = QString("%1/%2-%3").arg(scratch->path()).arg(i).arg(name);
 
-            if (QFile(filename).exists()) {
+            } else if (QFile(filename).exists()) {
                 if (overwrite->isChecked() == false) {
                     // skip existing files
-                    current->setText(4, tr("Exists - not exported")); QApplication::processEvents();
+                    current->setText(4, tr("Exists - not exported"));
                     fails++;
                     continue;
 
@@ -234,50 +305,79 @@ BatchExportDialog::exportFiles()
 
                     // remove existing
                     QFile(filename).remove();
-                    current->setText(4, tr("Removing...")); QApplication::processEvents();
                 }
 
             }
-            // this one then
-            current->setText(4, tr("Reading...")); QApplication::processEvents();
-
-            // open it..
-            QStringList errors;
-            QList<RideFile*> rides;
-            QFile thisfile(QString(context->athlete->home->activities().absolutePath()+"/"+current->text(1)));
-            RideFile *ride = RideFileFactory::instance().openRideFile(context, thisfile, errors, &rides);
-
-            // open success?
-            if (ride) {
 
+            // this one then
+            current->setText(4, tr("Queued"));
+
+            BatchExportJob *job = new BatchExportJob;
+            job->item = current;
+            job->context = context;
+            job->source = context->athlete->home->activities().absolutePath()+"/"+current->text(1);
+            job->target = filename;
+            job->type = type;
+            job->name = name;
+            job->allData = format->currentIndex() == 0;
+            job->archive = zip != NULL;
+            jobs << job;
+        }
+    }
 
-                current->setText(4, tr("Writing...")); QApplication::processEvents();
-                QFile out(filename);
-
-                bool success = false;
-                if (format->currentIndex() > 0)
-                    success = RideFileFactory::instance().writeRideFile(context, ride, out, type);
-                else {
-                    CsvFileReader writer;
-                    success = writer.writeRideFile(context, ride, out, CsvFileReader::gc);
-                }
+    // fan out across the thread pool, results come back
+    // to exportDone() as each one completes
+    if (jobs.isEmpty()) exportFinished();
+    else watcher.setFuture(QtConcurrent::mapped(jobs, exportJob));
+}
 
-                if (success) {
-                    exports++;
-                    current->setText(4, tr("Exported")); QApplication::processEvents();
-                } else {
-                    fails++;
-                    current->setText(4, tr("Write failed")); QApplication::processEvents();
-                }
+void
+BatchExportDialog::exportDone(int index)
+{
+    BatchExportJob *job = watcher.resultAt(index);
+    job->done = true;
+
+    if (job->readError) {
+        fails++;
+        job->item->setText(4, tr("Read error"));
+
+    } else if (job->success) {
+        exports++;
+        if (zip) {
+            zip->addFile(job->name, job->data);
+            job->data.clear();
+        }
+        job->item->setText(4, tr("Exported"));
 
-                delete ride; // free memory!
+    } else {
+        fails++;
+        job->item->setText(4, tr("Write failed"));
+    }
+    files->setCurrentItem(job->item);
 
-            // open failed
-            } else {
+    status->setText(QString(tr("Exporting %1 of %2...")).arg(exports+fails).arg(jobs.count()));
+}
 
-                current->setText(4, tr("Read error")); QApplication::processEvents();
+void
+BatchExportDialog::exportFinished()
+{
+    // any left over were aborted
+    foreach(BatchExportJob *job, jobs) {
+        if (!job->done) job->item->setText(4, tr("Aborted"));
+        delete job;
+    }
+    jobs.clear();
 
-            }
-        }
+    if (zip) {
+        zip->close();
+        delete zip;
+        zip = NULL;
     }
+    if (scratch) {
+        delete scratch;
+        scratch = NULL;
+    }
+
+    status->setText(QString(tr("%1 activities exported, %2 failed or skipped.")).arg(exports).arg(fails));
+    ok->setText(tr("Finish"));
 }
@@ -35,8 +35,28 @@
 #include <QCheckBox>
 #include <QLabel>
 #include <QListIterator>
+#include <QFutureWatcher>
 #include <QDebug>
 
+class ZipWriter;
+class QTemporaryDir;
+
+// One activity to export, read and written on a worker thread
+struct BatchExportJob
+{
+    BatchExportJob() : item(NULL), context(NULL), allData(false), archive(false),
+                       done(false), readError(false), success(false) {}
+
+    QTreeWidgetItem *item; // row in the list, only touched on the gui thread
+    Context *context;
+    QString source, target, type, name;
+    bool allData;          // csv with all the data series
+    bool archive;          // target is temporary, contents returned in data
+
+    bool done, readError, success;
+    QByteArray data;
+};
+
 // Dialog class to show filenames, import progress and to capture user input
 // of ride date and time
 
@@ -48,6 +68,7 @@ class BatchExportDialog : public QDialog
 
 public:
     BatchExportDialog(Context *context);
+    ~BatchExportDialog();
 
     QTreeWidget *files; // choose files to export
 
@@ -58,6 +79,8 @@ private slots:
     void okClicked();
     void selectClicked();
     void exportFiles();
+    void exportDone(int index);
+    void exportFinished();
     void allClicked();
 
 private:
@@ -73,10 +96,17 @@ private:
     QLabel *dirLabel, *dirName;
 
     QCheckBox *overwrite;
+    QCheckBox *archive;
     QPushButton *cancel, *ok;
 
     int exports, fails;
     QLabel *status;
+
+    // exports run on the global thread pool
+    QList<BatchExportJob*> jobs;
+    QFutureWatcher<BatchExportJob*> watcher;
+    ZipWriter *zip;
+    QTemporaryDir *scratch; // archive members are written here first
 };
 #endif // _BatchExportDialog_h
 
@@ -443,10 +443,11 @@ ComparePane::refreshTable()
             t->setFlags(t->flags() & (~Qt::ItemIsEditable));
             table->setItem(counter, 4, t);
 
-            // metrics
+            // metrics, all aggregated in one pass
+            QHash<QString, double> aggregates = x.sourceContext->athlete->rideCache->getAggregates(worklist, x.specification);
             for(int i = 0; i < worklist.count(); i++) {
 
-                QString value = x.sourceContext->athlete->rideCache->getAggregate(worklist[i], x.specification, context->athlete->useMetricUnits);
+                QString value = x.sourceContext->athlete->rideCache->formatAggregate(worklist[i], aggregates.value(worklist[i]), context->athlete->useMetricUnits);
 
                 // add to the table
                 t = new CTableWidgetItem;
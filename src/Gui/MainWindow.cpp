@@ -396,6 +396,7 @@ MainWindow::MainWindow(const QDir &home)
     connect(backupAthleteMenu, SIGNAL(aboutToShow()), this, SLOT(setBackupAthleteMenu()));
     backupMapper = new QSignalMapper(this); // maps each option
     connect(backupMapper, SIGNAL(mapped(const QString &)), this, SLOT(backupAthlete(const QString &)));
+    fileMenu->addAction(tr("Restore Athlete Backup..."), this, SLOT(restoreAthlete()));
 
     fileMenu->addSeparator();
     fileMenu->addAction(tr("Save all modified activities"), this, SLOT(saveAllUnsavedRides()));
@@ -1909,6 +1910,12 @@ MainWindow::backupAthlete(QString name)
     delete backup;
 }
 
+void
+MainWindow::restoreAthlete()
+{
+    AthleteBackup::restoreImmediate();
+}
+
 void
 MainWindow::saveGCState(Context *context)
 {
@@ -151,6 +151,7 @@ class MainWindow : public QMainWindow
         // Athlete Backup
         void setBackupAthleteMenu();
         void backupAthlete(QString name);
+        void restoreAthlete();
 
         // Search / Filter
         void setFilter(QStringList);
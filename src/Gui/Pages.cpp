@@ -919,6 +919,8 @@ BackupPage::BackupPage(Context *context) : context(context)
     backupInput->addWidget(autoBackupPeriod);
     //backupInput->addStretch();
     backupInput->addWidget(autoBackupUnitLabel);
+    autoBackupIncremental = new QCheckBox(tr("Incremental, only store what changed since the last backup"), this);
+    autoBackupIncremental->setChecked(appsettings->cvalue(context->athlete->cyclist, GC_AUTOBACKUP_INCREMENTAL, true).toBool());
 
     Qt::Alignment alignment = Qt::AlignLeft|Qt::AlignVCenter;
 
@@ -927,6 +929,7 @@ BackupPage::BackupPage(Context *context) : context(context)
     grid->addWidget(autoBackupFolderBrowse, 7, 2, alignment);
     grid->addWidget(autoBackupPeriodLabel, 8, 0,alignment);
     grid->addLayout(backupInput, 8, 1, alignment);
+    grid->addWidget(autoBackupIncremental, 9, 1, alignment);
 
     all->addLayout(grid);
     all->addStretch();
@@ -949,6 +952,7 @@ BackupPage::saveClicked()
     // Auto Backup
     appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_FOLDER, autoBackupFolder->text());
     appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_PERIOD, autoBackupPeriod->value());
+    appsettings->setCValue(context->athlete->cyclist, GC_AUTOBACKUP_INCREMENTAL, autoBackupIncremental->isChecked());
     return 0;
 }
 
@@ -342,6 +342,7 @@ class BackupPage : public QWidget
         QSpinBox *autoBackupPeriod;
         QLineEdit *autoBackupFolder;
         QPushButton *autoBackupFolderBrowse;
+        QCheckBox *autoBackupIncremental;
 
     private slots:
 
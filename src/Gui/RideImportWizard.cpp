@@ -40,6 +40,8 @@
 #include "RideMetadata.h" // for linked defaults processing
 
 #include <QDebug>
+#include <QtConcurrent>
+#include <QThread>
 #include <QWaitCondition>
 #include <QMessageBox>
 
@@ -285,6 +287,7 @@ RideImportWizard::init(QList<QString> original, Context * /*mainWindow*/)
 
     // NOTE: abort button morphs into save and finish button later
     connect(abortButton, SIGNAL(clicked()), this, SLOT(abortClicked()));
+    connect(&jobWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(jobDone(int)));
 
     // only used when editing dates
     connect(todayButton, SIGNAL(activated(int)), this, SLOT(todayClicked(int)));
@@ -457,6 +460,81 @@ RideImportWizard::getNumberOfFiles() {
     return numberOfFiles;
 }
 
+// the import pipeline stages that run on worker threads
+static RideImportJob *decodeJob(RideImportJob *job)
+{
+    QFile file(job->filename);
+    job->ride = RideFileFactory::instance().openRideFile(job->context, file, job->errors, job->expand ? &job->rides : NULL);
+    return job;
+}
+
+static RideImportJob *writeJob(RideImportJob *job)
+{
+    if (job->ride) {
+        JsonFileReader reader;
+        QFile target(job->tmpTarget);
+        job->saved = reader.writeRideFile(job->context, job->ride, target);
+    }
+    return job;
+}
+
+static void deleteJobs(QList<RideImportJob*> jobs)
+{
+    foreach(RideImportJob *job, jobs) {
+        if (!job->rides.contains(job->ride)) delete job->ride;
+        foreach(RideFile *extracted, job->rides) delete extracted;
+        delete job;
+    }
+}
+
+void
+RideImportWizard::runJobs(QList<RideImportJob*> &jobs, RideImportJob *(*function)(RideImportJob*))
+{
+    if (jobs.isEmpty()) return;
+
+    // results arrive in jobDone() as each one completes, keep the
+    // event loop running until the whole batch is finished or aborted
+    QEventLoop loop;
+    connect(&jobWatcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    jobWatcher.setFuture(QtConcurrent::mapped(jobs, function));
+    loop.exec();
+}
+
+void
+RideImportWizard::jobDone(int index)
+{
+    RideImportJob *job = jobWatcher.resultAt(index);
+    if (job->row < tableWidget->rowCount() && job->done != "")
+        tableWidget->item(job->row,STATUS_COLUMN)->setText(job->done);
+}
+
+void
+RideImportWizard::decodeAhead(int from)
+{
+    // the next batch of queued files that haven't been decoded yet
+    QList<RideImportJob*> batch;
+    int batchSize = QThread::idealThreadCount() * 2;
+    for (int i=from; i < filenames.count() && batch.count() < batchSize; i++) {
+
+        if (tableWidget->item(i,STATUS_COLUMN)->text().startsWith(tr("Error"))) continue;
+        if (decoded.contains(filenames[i])) continue;
+
+        RideImportJob *job = new RideImportJob;
+        job->row = i;
+        job->filename = filenames[i];
+        job->context = context;
+        job->expand = true; // archives are expanded in pass 2
+        job->done = tr("Parsed");
+        tableWidget->item(i,STATUS_COLUMN)->setText(tr("Parsing..."));
+        batch << job;
+    }
+    runJobs(batch, decodeJob);
+
+    // the ones that didn't run if we were aborted are
+    // left in, they just come back without a ride
+    foreach(RideImportJob *job, batch) decoded.insert(job->filename, job);
+}
+
 int
 RideImportWizard::process()
 {
@@ -544,16 +622,24 @@ RideImportWizard::process()
               QStringList errors;
               QFile thisfile(filenames[i]);
 
-              tableWidget->item(i,STATUS_COLUMN)->setText(tr("Parsing..."));
               tableWidget->setCurrentCell(i,5);
-              QApplication::processEvents();
+
+              // decode this and the next few files on worker threads
+              if (!decoded.contains(filenames[i])) decodeAhead(i);
 
               if (aborted) { done(0); return 0; }
               this->repaint();
               QApplication::processEvents();
 
               QList<RideFile*> rides;
-              RideFile *ride = RideFileFactory::instance().openRideFile(context, thisfile, errors, &rides);
+              RideFile *ride = NULL;
+              RideImportJob *job = decoded.take(filenames[i]);
+              if (job) {
+                  ride = job->ride;
+                  errors = job->errors;
+                  rides = job->rides;
+                  delete job;
+              }
 
               // is this an archive of files?
               if (rides.count() > 1) {
@@ -964,6 +1050,7 @@ RideImportWizard::abortClicked()
     if (label == tr("Abort")) {
         hide();
         aborted=true; // terminated. I'll be back.
+        jobWatcher.cancel();
         return;
     }
 
@@ -1001,135 +1088,180 @@ RideImportWizard::abortClicked()
     QChar zero = QLatin1Char ( '0' );
 
 
-    // Saving now - process the files one-by-one
-    for (int i=0; i< filenames.count(); i++) {
+    // Saving now - the files are decoded and serialized on worker threads a
+    // batch at a time, the data processors and the ride cache update run here
+    // on the gui thread in between since they are not safe to run in parallel
+    int batchSize = QThread::idealThreadCount() * 2;
+    int next = 0;
+    while (next < filenames.count()) {
+
+        QList<RideImportJob*> batch;
+        for (; next < filenames.count() && batch.count() < batchSize; next++) {
+
+            int i = next;
+            if (tableWidget->item(i,STATUS_COLUMN)->text().startsWith(tr("Error"))) continue; // skip errors
+
+            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving..."));
+            tableWidget->setCurrentCell(i,5);
+
+            // SAVE STEP 3 - prepare the new file names for the next steps - basic name and .JSON in GC format
+
+            QDateTime ridedatetime = QDateTime(QDate().fromString(tableWidget->item(i,DATE_COLUMN)->text(), Qt::ISODate),
+                                               QTime().fromString(tableWidget->item(i,TIME_COLUMN)->text(), "hh:mm:ss"));
+            QString targetnosuffix = QString ( "%1_%2_%3_%4_%5_%6" )
+                    .arg ( ridedatetime.date().year(), 4, 10, zero )
+                    .arg ( ridedatetime.date().month(), 2, 10, zero )
+                    .arg ( ridedatetime.date().day(), 2, 10, zero )
+                    .arg ( ridedatetime.time().hour(), 2, 10, zero )
+                    .arg ( ridedatetime.time().minute(), 2, 10, zero )
+                    .arg ( ridedatetime.time().second(), 2, 10, zero );
+            QString activitiesTarget = QString ("%1.%2" ).arg ( targetnosuffix ).arg ( "json" );
+
+            // create filenames incl. directory path for GC .JSON for both /tmpActivities and /activities directory
+            QString tmpActivitiesFulltarget = tmpActivities.canonicalPath() + "/" + activitiesTarget;
+            QString finalActivitiesFulltarget = homeActivities.canonicalPath() + "/" + activitiesTarget;
+
+            // check if a ride at this point of time already exists in /activities - if yes, skip import
+            if (QFileInfo(finalActivitiesFulltarget).exists()) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file exists")); continue; }
+
+            // in addition, also check the RideCache for a Ride with the same point in Time in UTC, which also indicates
+            // that there was already a ride imported - reason is that RideCache start time is in UTC, while the file Name is in "localTime"
+            // which causes problems when importing the same file (for files which do not have time/date in the file name),
+            // while the computer has been set to a different time zone
+            if (context->athlete->rideCache->getRide(ridedatetime.toUTC())) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file with same start date/time exists")); continue; };
+
+            // or is already in this batch
+            bool duplicate = false;
+            foreach(RideImportJob *queued, batch) if (queued->finalTarget == finalActivitiesFulltarget) duplicate = true;
+            if (duplicate) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file exists")); continue; }
+
+            // SAVE STEP 4 - copy the source file to "/imports" directory (if it's not taken from there as source)
+            // add the date/time of the target to the source file name (for identification)
+
+            // copy the sourceFile to /imports ONLY if the source is NOT coming from /imports itself
+            QFileInfo sourceFileInfo (filenames[i]);
+            QString importsTarget;
+            if (sourceFileInfo.canonicalPath() != homeImports.canonicalPath()) {
+
+                // add the GC file base name to create unique file names during import
+                // there should not be 2 ride files with exactly the same time stamp (as this is also not foreseen for the .json)
+                importsTarget = sourceFileInfo.baseName() + "_" + targetnosuffix + "." + sourceFileInfo.suffix();
+                QString importsFulltarget = homeImports.canonicalPath() + "/" + importsTarget;
+                // copy the source file to /imports with adjusted name
+                QFile source(filenames[i]);
+                if (!source.copy(importsFulltarget)) {
+                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - copy of %1 to import directory failed").arg(importsTarget));
+                }
+            } else {
+                // file is re-imported from /imports - keep the name for .JSON Source File Tag
+                importsTarget = sourceFileInfo.fileName();
+            }
 
-        if (tableWidget->item(i,STATUS_COLUMN)->text().startsWith(tr("Error"))) continue; // skip errors
+            RideImportJob *job = new RideImportJob;
+            job->row = i;
+            job->filename = filenames[i];
+            job->context = context;
+            job->done = tr("Processing...");
+            job->ridedatetime = ridedatetime;
+            job->importsTarget = importsTarget;
+            job->activitiesTarget = activitiesTarget;
+            job->tmpTarget = tmpActivitiesFulltarget;
+            job->finalTarget = finalActivitiesFulltarget;
+            batch << job;
+        }
 
-        tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving..."));
-        tableWidget->setCurrentCell(i,5);
         QApplication::processEvents();
-        if (aborted) { done(0); return; }
+        if (aborted) { deleteJobs(batch); done(0); return; }
         this->repaint();
 
-
-        // SAVE STEP 3 - prepare the new file names for the next steps - basic name and .JSON in GC format
-
-        QDateTime ridedatetime = QDateTime(QDate().fromString(tableWidget->item(i,DATE_COLUMN)->text(), Qt::ISODate),
-                                           QTime().fromString(tableWidget->item(i,TIME_COLUMN)->text(), "hh:mm:ss"));
-        QString targetnosuffix = QString ( "%1_%2_%3_%4_%5_%6" )
-                .arg ( ridedatetime.date().year(), 4, 10, zero )
-                .arg ( ridedatetime.date().month(), 2, 10, zero )
-                .arg ( ridedatetime.date().day(), 2, 10, zero )
-                .arg ( ridedatetime.time().hour(), 2, 10, zero )
-                .arg ( ridedatetime.time().minute(), 2, 10, zero )
-                .arg ( ridedatetime.time().second(), 2, 10, zero );
-        QString activitiesTarget = QString ("%1.%2" ).arg ( targetnosuffix ).arg ( "json" );
-
-        // create filenames incl. directory path for GC .JSON for both /tmpActivities and /activities directory
-        QString tmpActivitiesFulltarget = tmpActivities.canonicalPath() + "/" + activitiesTarget;
-        QString finalActivitiesFulltarget = homeActivities.canonicalPath() + "/" + activitiesTarget;
-
-        // check if a ride at this point of time already exists in /activities - if yes, skip import
-        if (QFileInfo(finalActivitiesFulltarget).exists()) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file exists")); continue; }
-
-        // in addition, also check the RideCache for a Ride with the same point in Time in UTC, which also indicates
-        // that there was already a ride imported - reason is that RideCache start time is in UTC, while the file Name is in "localTime"
-        // which causes problems when importing the same file (for files which do not have time/date in the file name),
-        // while the computer has been set to a different time zone
-        if (context->athlete->rideCache->getRide(ridedatetime.toUTC())) { tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Activity file with same start date/time exists")); continue; };
-
-        // SAVE STEP 4 - copy the source file to "/imports" directory (if it's not taken from there as source)
-        // add the date/time of the target to the source file name (for identification)
-
-        // copy the sourceFile to /imports ONLY if the source is NOT coming from /imports itself
-        QFileInfo sourceFileInfo (filenames[i]);
-        QString importsTarget;
-        if (sourceFileInfo.canonicalPath() != homeImports.canonicalPath()) {
-
-            // add the GC file base name to create unique file names during import
-            // there should not be 2 ride files with exactly the same time stamp (as this is also not foreseen for the .json)
-            importsTarget = sourceFileInfo.baseName() + "_" + targetnosuffix + "." + sourceFileInfo.suffix();
-            QString importsFulltarget = homeImports.canonicalPath() + "/" + importsTarget;
-            // copy the source file to /imports with adjusted name
-            QFile source(filenames[i]);
-            if (!source.copy(importsFulltarget)) {
-                tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - copy of %1 to import directory failed").arg(importsTarget));
-            }
-        } else {
-            // file is re-imported from /imports - keep the name for .JSON Source File Tag
-            importsTarget = sourceFileInfo.fileName();
-        }
-
-
         // SAVE STEP 5 - open the file with the respective format reader and export as .JSON
         // to track if addRideCache() has caused an error due to bad data we work with a interim directory for the activities
         // -- first   export to /tmpactivities
         // -- second  create RideCache() entry
         // -- third   move file from /tmpactivities to /activities
 
-        // serialize the file to .JSON
-        QStringList errors;
-        QFile thisfile(filenames[i]);
-        RideFile *ride(RideFileFactory::instance().openRideFile(context, thisfile, errors));
+        // decode the batch (should be fine here - since it was alrady checked before - but just in case)
+        runJobs(batch, decodeJob);
+        if (aborted) { deleteJobs(batch); done(0); return; }
+
+        // run the import processors, a processor at a time across the
+        // whole batch so python fix scripts can run concurrently
+        QList<RideFile*> rides;
+        foreach(RideImportJob *job, batch) {
 
-        // did the input file parse ok ? (should be fine here - since it was alrady checked before - but just in case)
-        if (ride) {
+            RideFile *ride = job->ride;
+            if (!ride) continue;
 
             // update ridedatetime and set the Source File name
-            ride->setStartTime(ridedatetime);
-            ride->setTag("Source Filename", importsTarget);
-            ride->setTag("Filename", activitiesTarget);
-            if (errors.count() > 0)
-                ride->setTag("Import errors", errors.join("\n"));
+            ride->setStartTime(job->ridedatetime);
+            ride->setTag("Source Filename", job->importsTarget);
+            ride->setTag("Filename", job->activitiesTarget);
+            if (job->errors.count() > 0)
+                ride->setTag("Import errors", job->errors.join("\n"));
 
             // process linked defaults
             context->athlete->rideMetadata()->setLinkedDefaults(ride);
+            rides << ride;
+        }
+        QStringList processErrors;
+        DataProcessorFactory::instance().autoProcess(rides, "Auto", "Import", &processErrors);
+        int n = 0;
+        foreach(RideImportJob *job, batch) {
+            if (!job->ride) continue;
+            job->processErrors = processErrors.value(n++);
+            job->ride->recalculateDerivedSeries();
+            job->done = tr("Saving file...");
+        }
+
+        // serialize
+        runJobs(batch, writeJob);
+        if (aborted) { deleteJobs(batch); done(0); return; }
+
+        // add to the ride cache in order
+        foreach(RideImportJob *job, batch) {
+
+            int i = job->row;
+            RideFile *ride = job->ride;
+
+            if (ride) {
+                if (job->saved) {
+
+                    // now try adding the Ride to the RideCache - since this may fail due to various reason, the activity file
+                    // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
+                    // - only after the step was successful the file is moved
+                    // to the "clean" activities folder
+                    context->athlete->addRide(QFileInfo(job->tmpTarget).fileName(),
+                                              tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
+                                              true, true);                                       // file is available only in /tmpActivities, so use this one please
+                    // rideCache is successfully updated, let's move the file to the real /activities
+                    if (moveFile(job->tmpTarget, job->finalTarget)) {
+                        tableWidget->item(i,STATUS_COLUMN)->setText(job->processErrors.isEmpty() ? tr("File Saved") : tr("File Saved, fix script errors"));
+                        tableWidget->item(i,STATUS_COLUMN)->setToolTip(job->processErrors);
+                        // and correct the path locally stored in Ride Item
+                        context->ride->setFileName(homeActivities.canonicalPath(), job->activitiesTarget);
+                    }  else {
+                        tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Moving %1 to activities folder").arg(job->activitiesTarget));
+                    }
 
-            // run the processor first... import
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Processing..."));
-            DataProcessorFactory::instance().autoProcess(ride, "Auto", "Import");
-            ride->recalculateDerivedSeries();
-
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Saving file..."));
-
-            // serialize
-            JsonFileReader reader;
-            QFile target(tmpActivitiesFulltarget);
-            if (reader.writeRideFile(context, ride, target)) {
-
-                // now try adding the Ride to the RideCache - since this may fail due to various reason, the activity file
-                // is stored in tmpActivities during this process to understand which file has create the problem when restarting GC
-                // - only after the step was successful the file is moved
-                // to the "clean" activities folder
-                context->athlete->addRide(QFileInfo(tmpActivitiesFulltarget).fileName(),
-                                          tableWidget->rowCount() < 20 ? true : false, // don't signal if mass importing
-                                          true, true);                                       // file is available only in /tmpActivities, so use this one please
-                // rideCache is successfully updated, let's move the file to the real /activities
-                if (moveFile(tmpActivitiesFulltarget, finalActivitiesFulltarget)) {
-                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("File Saved"));
-                    // and correct the path locally stored in Ride Item
-                    context->ride->setFileName(homeActivities.canonicalPath(), activitiesTarget);
                 }  else {
-                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Moving %1 to activities folder").arg(activitiesTarget));
+                    tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - .JSON creation failed"));
                 }
 
-            }  else {
-                tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - .JSON creation failed"));
+                // now metrics have been calculated
+                DataProcessorFactory::instance().autoProcess(ride, "Save", "ADD");
+
+            } else {
+                tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Import of activitiy file failed"));
             }
-        } else {
-            tableWidget->item(i,STATUS_COLUMN)->setText(tr("Error - Import of activitiy file failed"));
-        }
 
-        // now metrics have been calculated
-        DataProcessorFactory::instance().autoProcess(ride, "Save", "ADD");
+            progressBar->setValue(progressBar->value()+1);
+        }
 
         // clear
-        delete ride;
+        deleteJobs(batch);
 
         QApplication::processEvents();
         if (aborted) { done(0); return; }
-        progressBar->setValue(progressBar->value()+1);
         this->repaint();
     }
 
@@ -1200,6 +1332,9 @@ RideImportWizard::done(int rc)
 RideImportWizard::~RideImportWizard()
 {
     foreach(QString name, deleteMe) QFile(name).remove();
+    jobWatcher.cancel();
+    jobWatcher.waitForFinished();
+    deleteJobs(decoded.values());
 }
 
 
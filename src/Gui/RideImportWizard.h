@@ -30,9 +30,36 @@
 #include <QList>
 #include <QListIterator>
 #include <QItemDelegate>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QDateTime>
 #include "Context.h"
 #include "RideAutoImportConfig.h"
 
+class RideFile;
+
+// One file passing through the import pipeline, the decode and
+// write stages run on worker threads, everything else on the gui thread
+struct RideImportJob
+{
+    RideImportJob() : row(-1), context(NULL), expand(false), ride(NULL), saved(false) {}
+
+    int row;                // row in the table
+    QString filename;       // source file
+    Context *context;
+    bool expand;            // return all the rides from an archive
+
+    RideFile *ride;         // decoded
+    QList<RideFile*> rides; // all of them if expand and more than one
+    QStringList errors;
+    QString processErrors;  // from the import processors, e.g. fix scripts
+    QString done;           // status to show once the stage completes
+
+    QDateTime ridedatetime; // where to save it
+    QString importsTarget, activitiesTarget, tmpTarget, finalTarget;
+    bool saved;
+};
+
 // Dialog class to show filenames, import progress and to capture user input
 // of ride date and time
 
@@ -65,11 +92,18 @@ private slots:
     void todayClicked(int index);
     // void overClicked(); // deprecate for this release... XXX
     void activateSave();
+    void jobDone(int index);
 
 private:
     void init(QList<QString> files, Context *context);
     bool moveFile(const QString &source, const QString &target);
 
+    // decode and save on worker threads a batch at a time
+    void decodeAhead(int from);
+    void runJobs(QList<RideImportJob*> &jobs, RideImportJob *(*function)(RideImportJob*));
+    QFutureWatcher<RideImportJob*> jobWatcher;
+    QHash<QString, RideImportJob*> decoded; // pass 2 results by filename
+
     QList <QString> filenames; // list of filenames passed
     int numberOfFiles; // number of files to be processed
     QList <bool> blanks; // record of which have a RideFileReader returned date & time
@@ -81,6 +81,10 @@ private:
     QVector<int> sourceRowToGroupRow;
     QList<rankx> rankedRows;
 
+    // group number for each source row, worked out once in setGroups
+    // so mapFromSource doesn't need to call groupFromValue every time
+    QVector<int> sourceRowToGroup;
+
     void clearGroups() {
         // Wipe current
         QMapIterator<QString, QVector<int>*> i(groupToSourceRow);
@@ -92,6 +96,7 @@ private:
         groupIndexes.clear();
         groupToSourceRow.clear();
         sourceRowToGroupRow.clear();
+        sourceRowToGroup.clear();
         rankedRows.clear();
     }
 
@@ -197,15 +202,14 @@ public:
     QModelIndex mapFromSource(const QModelIndex &sourceIndex) const {
 
         // which group did we put this row into?
-        QString group = whichGroup(sourceIndex.row());
-        int groupNo = groups.indexOf(group);
+        int row = sourceIndex.row();
+        int groupNo = (row >= 0 && row < sourceRowToGroup.size()) ? sourceRowToGroup[row] : -1;
 
         if (groupNo < 0) {
             return QModelIndex();
         } else {
-            QModelIndex *p = new QModelIndex(createIndex(groupNo, 0, (void*)NULL));
-            if (sourceIndex.row() > 0 && sourceIndex.row() < sourceRowToGroupRow.size())
-                return createIndex(sourceRowToGroupRow[sourceIndex.row()], sourceIndex.column()+2, &p); // accommodate virtual columns
+            if (row > 0 && row < sourceRowToGroupRow.size())
+                return createIndex(sourceRowToGroupRow[row], sourceIndex.column()+2, (void*)&groupIndexes[groupNo]); // accommodate virtual columns
             else
                 return QModelIndex();
         }
@@ -516,10 +520,22 @@ public:
         // wipe whatever is there first
         clearGroups();
 
+        int nrows = sourceModel()->rowCount(QModelIndex());
+
+        // group key for each source row, we map these to group
+        // numbers once we know the full (sorted) set of groups
+        QVector<QVector<int>*> rowGroup;
+        rowGroup.reserve(nrows);
+        sourceRowToGroupRow.reserve(nrows);
+
         if (groupBy >= 0) {
 
+            // the heading doesn't change from row to row
+            QString heading = headerData(groupBy+2, Qt::Horizontal).toString(); // accommodate virtual column
+
             // rank all the values
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
+            rankedRows.reserve(nrows);
+            for (int i=0; i<nrows; i++) {
                 rankx rank;
                 rank.value = sourceModel()->data(sourceModel()->index(i,groupBy)).toDouble();
                 rank.row = i;
@@ -537,10 +553,12 @@ public:
 
 
             // create a QMap from 'group' string to list of rows in that group
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
+            for (int i=0; i<nrows; i++) {
 
                 // which group are we in?
-                QString value = whichGroup(i); // uses rankedRows
+                QString value = groupFromValue(heading,
+                                               sourceModel()->data(sourceModel()->index(i,groupBy)).toString(),
+                                               rankedRows[i].value, nrows); // uses rankedRows
 
                 QVector<int> *rows;
                 if ((rows=groupToSourceRow.value(value,NULL)) == NULL) {
@@ -555,29 +573,38 @@ public:
 
                 // add to this groups rows
                 rows->append(i);
+                rowGroup.append(rows);
             }
 
         } else {
 
             // Just one group by 'All Activities'
-            QVector<int> *rows = new QVector<int>;
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
-                rows->append(i);
+            QVector<int> *all = new QVector<int>;
+            all->reserve(nrows);
+            for (int i=0; i<nrows; i++) {
+                all->append(i);
                 sourceRowToGroupRow.append(i);
+                rowGroup.append(all);
             }
-            groupToSourceRow.insert("All Activities", rows);
+            groupToSourceRow.insert("All Activities", all);
 
         }
 
         // Update list of groups
         int group=0;
+        QHash<QVector<int>*, int> groupNo;
         QMapIterator<QString, QVector<int>*> j(groupToSourceRow);
         while (j.hasNext()) {
             j.next();
             groups << j.key();
+            groupNo.insert(j.value(), group);
             groupIndexes << createIndex(group++,0,(void*)NULL);
         }
 
+        // and now each source row knows its group number
+        sourceRowToGroup.resize(nrows);
+        for (int i=0; i<nrows; i++) sourceRowToGroup[i] = groupNo.value(rowGroup[i], -1);
+
         // all done. let the views know everything changed
         endResetModel();
     }
@@ -615,7 +642,7 @@ class SearchFilter : public QSortFilterProxyModel
 
     public:
 
-    SearchFilter(QWidget *p) : QSortFilterProxyModel(p), searchActive(false) {}
+    SearchFilter(QWidget *p) : QSortFilterProxyModel(p), searchActive(false), stale(true) {}
 
     void setSourceModel(QAbstractItemModel *model) {
         QAbstractProxyModel::setSourceModel(model);
@@ -630,32 +657,50 @@ class SearchFilter : public QSortFilterProxyModel
             }
         }
 
+        // row numbers are about to mean something else, we need to know
+        // before the proxy refilters on the rowsInserted etc signals
+        connect(model, SIGNAL(modelAboutToBeReset()), this, SLOT(sourceRowsChanged()));
+        connect(model, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)), this, SLOT(sourceRowsChanged()));
+        connect(model, SIGNAL(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(sourceRowsChanged()));
+        connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(sourceRowsChanged()));
+
+        // a rename changes the filename we match against, connected
+        // before the forwarding below so views refilter with new bits
+        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceRowsChanged()));
+
 	// make sure changes are propogated upstream
         connect(model, SIGNAL(modelReset()), this, SIGNAL(modelReset()));
         connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SIGNAL(dataChanged(QModelIndex, QModelIndex)));
         connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SIGNAL(modelReset()));
         connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SIGNAL(modelReset()));
         connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SIGNAL(modelReset()));
+        stale = true;
     }
 
     bool filterAcceptsRow (int source_row, const QModelIndex &source_parent) const {
 
         if (fileIndex == -1 || searchActive == false) return true; // nothing to do
 
-        // lets get the filename
-        QModelIndex source_index = model->index(source_row, fileIndex, source_parent);
-        if (!source_index.isValid()) return true;
+        // the source model is a flat list of rides
+        if (source_parent.isValid()) {
+            QModelIndex source_index = model->index(source_row, fileIndex, source_parent);
+            if (!source_index.isValid()) return true;
+            return strings.contains(model->data(source_index, Qt::DisplayRole).toString());
+        }
 
-        QString key = model->data(source_index, Qt::DisplayRole).toString();
-        return strings.contains(key);
+        // one pass over the filenames to mark matching rows, then
+        // every row the proxy asks about is just a bit test
+        if (stale) matchRows();
+        return source_row >= 0 && source_row < matches.size() && matches.testBit(source_row);
     }
 
     public slots:
 
     void setStrings(QStringList list) {
         beginResetModel();
-        strings = list;
+        strings = QSet<QString>::fromList(list);
         searchActive = true;
+        stale = true;
         endResetModel();
     }
 
@@ -663,13 +708,34 @@ class SearchFilter : public QSortFilterProxyModel
         beginResetModel();
         strings.clear();
         searchActive = false;
+        stale = true;
         endResetModel();
     }
 
+    void sourceRowsChanged() {
+        stale = true;
+    }
+
     private:
+
+        void matchRows() const {
+
+            int rows = model->rowCount(QModelIndex());
+            matches.fill(false, rows);
+            for (int i=0; i<rows; i++) {
+                QModelIndex source_index = model->index(i, fileIndex, QModelIndex());
+                if (!source_index.isValid() || strings.contains(model->data(source_index, Qt::DisplayRole).toString()))
+                    matches.setBit(i);
+            }
+            stale = false;
+        }
+
         QAbstractItemModel *model;
-        QStringList strings;
+        QSet<QString> strings;
         int fileIndex;
         bool searchActive;
+
+        mutable QBitArray matches; // source rows that match, valid when !stale
+        mutable bool stale;
 };
 #endif
@@ -22,6 +22,7 @@
 #include "Estimator.h"
 #include "GcRideFile.h"
 #include "JsonRideFile.h"
+#include "NativeRideFile.h"
 #include "RideItem.h"
 #include "RideFile.h"
 #include "RideFileCommand.h"
@@ -149,6 +150,9 @@ MainWindow::saveSilent(Context *context, RideItem *rideItem)
     // we also need to preserve the notes file
     if (currentFI.baseName() != targetnosuffix) {
 
+        // the native copy goes with the old name
+        NativeFileReader::removeCache(context, currentFile.fileName());
+
         // rename as backup current if converting, or just delete it if its already .gc
         // unlink previous .bak if it is already there
         if (convert) {
@@ -184,6 +188,11 @@ MainWindow::saveSilent(Context *context, RideItem *rideItem)
     JsonFileReader reader;
     reader.writeRideFile(context, rideItem->ride(), savedFile);
 
+    // the native copy is out of date, it is written from the saved .json
+    // when that is next opened, so it holds what the .json holds rather
+    // than the unrounded values we have in memory
+    NativeFileReader::removeCache(context, savedFile.fileName());
+
     // rename the file and update the rideItem list to reflect the change
     if (convert) {
 
@@ -269,10 +269,11 @@ Banister::refresh()
     //
 
     // we can now fill with ride values
+    int scoreIndex = RideMetricFactory::instance().metricIndex(symbol);
     foreach(RideItem *item, context->athlete->rideCache->rides()) {
 
         // load measure
-        double score = item->getForSymbol(symbol);
+        double score = item->getForMetric(scoreIndex);
         long day = item->dateTime.date().toJulianDay() - start.toJulianDay();
         data[day].score += score;
 
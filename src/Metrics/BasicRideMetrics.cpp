@@ -316,7 +316,7 @@ class TimeCarrying : public RideMetric {
         if (item->ride()->areDataPresent()->kph) {
 
             // hysteresis can be configured, we default to 3.0
-            double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+            double hysteresis = appsettings->snapshot()->elevationHysteresis;
             if (hysteresis <= 0.1) hysteresis = 3.00;
 
             RideFileIterator it(item->ride(), spec);
@@ -393,7 +393,7 @@ class ElevationGainCarrying : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = appsettings->snapshot()->elevationHysteresis;
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -583,7 +583,7 @@ class AthleteWeight : public RideMetric {
         if (!weight) weight = item->getText("Weight", "0.0").toDouble();
 
         // global options
-        if (!weight) weight = appsettings->cvalue(item->context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
+        if (!weight) weight = appsettings->snapshot()->athlete(item->context->athlete->cyclist).weight; // default to 75kg
 
         // No weight default is weird, we'll set to 80kg
         if (weight <= 0.00) weight = 80.00;
@@ -813,7 +813,7 @@ class ElevationGain : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = appsettings->snapshot()->elevationHysteresis;
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -881,7 +881,7 @@ class ElevationLoss : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = appsettings->snapshot()->elevationHysteresis;
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -1785,9 +1785,10 @@ struct AvgTemp : public RideMetric {
     bool aggregateZero() const { return true; }
 
     // override to special case NA
-    QString toString(bool useMetricUnits) const {
-        if (value() == RideFile::NA) return "-";
-        return RideMetric::toString(useMetricUnits);
+    QString toString(bool useMetricUnits) const { return toString(useMetricUnits, value()); }
+    QString toString(bool useMetricUnits, double v) const {
+        if (v == RideFile::NA) return "-";
+        return RideMetric::toString(useMetricUnits, v);
     }
 
     void initialize() {
@@ -2354,9 +2355,10 @@ class MaxTemp : public RideMetric {
     }
 
     // override to special case NA
-    QString toString(bool useMetricUnits) const {
-        if (value() == RideFile::NA) return "-";
-        return RideMetric::toString(useMetricUnits);
+    QString toString(bool useMetricUnits) const { return toString(useMetricUnits, value()); }
+    QString toString(bool useMetricUnits, double v) const {
+        if (v == RideFile::NA) return "-";
+        return RideMetric::toString(useMetricUnits, v);
     }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
@@ -2410,9 +2412,10 @@ class MinTemp : public RideMetric {
     }
 
     // override to special case NA
-    QString toString(bool useMetricUnits) const {
-        if (value() == RideFile::NA) return "-";
-        return RideMetric::toString(useMetricUnits);
+    QString toString(bool useMetricUnits) const { return toString(useMetricUnits, value()); }
+    QString toString(bool useMetricUnits, double v) const {
+        if (v == RideFile::NA) return "-";
+        return RideMetric::toString(useMetricUnits, v);
     }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
@@ -3753,8 +3756,8 @@ struct TotalCalories : public RideMetric {
         athlete_weight = deps.value("athlete_weight")->value(true);
         duration = deps.value("time_riding")->value(true); // time_riding or workout_time ?
 
-        athlete_age = item->dateTime.date().year() - appsettings->cvalue(item->context->athlete->cyclist, GC_DOB).toDate().year();
-        bool male = appsettings->cvalue(item->context->athlete->cyclist, GC_SEX).toInt() == 0;
+        athlete_age = item->dateTime.date().year() - appsettings->snapshot()->athlete(item->context->athlete->cyclist).dob.year();
+        bool male = appsettings->snapshot()->athlete(item->context->athlete->cyclist).sex == 0;
 
         double kcalories = 0.0;
 
@@ -23,7 +23,7 @@
 CPSolver::CPSolver(Context *context)
    : context(context)
 {
-    integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    integral = appsettings->snapshot()->wbalIntegral;
 }
 
 // set the data to solve
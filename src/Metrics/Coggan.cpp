@@ -184,7 +184,7 @@ class IntensityFactor : public RideMetric {
 
         int ftp = item->getText("FTP","0").toInt();
 
-        bool useCPForFTP = (appsettings->cvalue(item->context->athlete->cyclist, item->context->athlete->zones(item->isRun)->useCPforFTPSetting(), 0).toInt() == 0);
+        bool useCPForFTP = (appsettings->snapshot()->athlete(item->context->athlete->cyclist).useCPforFTP[item->isRun ? 1 : 0] == 0);
 
         if (useCPForFTP) {
             int cp = item->getText("CP","0").toInt();
@@ -245,7 +245,7 @@ class BikeStress : public RideMetric {
 
         int ftp = item->getText("FTP","0").toInt();
 
-        bool useCPForFTP = (appsettings->cvalue(item->context->athlete->cyclist, item->context->athlete->zones(item->isRun)->useCPforFTPSetting(), 0).toInt() == 0);
+        bool useCPForFTP = (appsettings->snapshot()->athlete(item->context->athlete->cyclist).useCPforFTP[item->isRun ? 1 : 0] == 0);
 
         if (useCPForFTP) {
             int cp = item->getText("CP","0").toInt();
@@ -79,6 +79,13 @@ void HrZones::initializeZoneParameters()
 
 // read zone file, allowing for zones with or without end dates
 bool HrZones::read(QFile &file)
+{
+    bool returning = parse(file);
+    indexRanges();
+    return returning;
+}
+
+bool HrZones::parse(QFile &file)
 {
 
     //
@@ -427,13 +434,19 @@ bool HrZones::read(QFile &file)
 // end of range
 int HrZones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-        const HrZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
+    // called a lot, so looked up in an index rather than searching ranges
+    const DateIndex *index = rangeIndex.get();
+    return index ? index->find(date) : -1;
+}
+
+void HrZones::indexRanges()
+{
+    QVector<QDate> begins, ends;
+    foreach(const HrZoneRange &range, ranges) {
+        begins << range.begin;
+        ends << range.end;
     }
-    return -1;
+    rangeIndex.publish(new DateIndex(begins, ends));
 }
 
 int HrZones::numZones(int rnum) const
@@ -724,6 +737,7 @@ void HrZones::write(QDir home)
 void HrZones::addHrZoneRange(QDate _start, QDate _end, int _lt, int _restHr, int _maxHr)
 {
     ranges.append(HrZoneRange(_start, _end, _lt, _restHr, _maxHr));
+    indexRanges();
 }
 
 // insert a new zone range using the current scheme
@@ -741,6 +755,7 @@ int HrZones::addHrZoneRange(QDate _start, int _lt, int _restHr, int _maxHr)
 
     // modify previous end date
     if (rnum) ranges[rnum-1].end = _start;
+    indexRanges();
 
     // set zones from LT
     if (_lt > 0) {
@@ -754,16 +769,19 @@ int HrZones::addHrZoneRange(QDate _start, int _lt, int _restHr, int _maxHr)
 void HrZones::addHrZoneRange()
 {
     ranges.append(HrZoneRange(date_zero, date_infinity));
+    indexRanges();
 }
 
 void HrZones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 void HrZones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 
@@ -830,6 +848,7 @@ int HrZones::deleteRange(int rnum) {
 
     // delete this range then
     ranges.removeAt(rnum);
+    indexRanges();
 
     return rnum-1;
 }
@@ -856,6 +875,7 @@ int HrZones::insertRangeAtDate(QDate date, int lt) {
             QDate endDate = getEndDate(rnum);
             setEndDate(rnum, date);
             ranges.insert(++ rnum, HrZoneRange(date, endDate));
+            indexRanges();
         }
     }
 
@@ -21,6 +21,7 @@
 #include "GoldenCheetah.h"
 
 #include <QtCore>
+#include "DateIndex.h"
 
 // A zone "scheme" defines how power zones
 // are calculated as a percentage of LT
@@ -97,6 +98,9 @@ class HrZones : public QObject
 
         // LT History
         QList<HrZoneRange> ranges;
+        Published<DateIndex> rangeIndex; // which range is in force by date
+        void indexRanges();
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -142,7 +146,7 @@ class HrZones : public QObject
 
         // Get / Set ZoneRange details
         HrZoneRange getHrZoneRange(int rnum) { return ranges[rnum]; }
-        void setHrZoneRange(int rnum, HrZoneRange x) { ranges[rnum] = x; }
+        void setHrZoneRange(int rnum, HrZoneRange x) { ranges[rnum] = x; indexRanges(); }
 
         // get and set LT for a given range
         int getLT(int rnum) const;
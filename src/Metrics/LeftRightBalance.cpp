@@ -69,9 +69,10 @@ class LeftRightBalance : public RideMetric {
         setCount(count);
     }
 
-    QString toString(bool useMetricUnits) const
+    QString toString(bool useMetricUnits) const { return toString(useMetricUnits, value()); }
+    QString toString(bool useMetricUnits, double v) const
     {
-        double v1 = value(useMetricUnits);
+        double v1 = value(v, useMetricUnits);
         double v2 = 100-v1;
         return QString("%1-%2").arg(v1, 0, 'f', this->precision()).arg(v2, 0, 'f', this->precision());
     }
@@ -29,15 +29,17 @@
 
 #include <stdio.h>
 #include <cmath>
+#include <algorithm>
 
 #include <QSharedPointer>
 #include <QProgressDialog>
 
 PMCData::PMCData(Context *context, Specification spec, QString metricName, int stsDays, int ltsDays) 
-    : context(context), specification_(spec), metricName_(metricName), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true)
+    : context(context), specification_(spec), metricName_(metricName), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true), fullrefresh(true)
 {
     // get defaults if not passed
     useDefaults = false;
+    days_ = 0;
 
     // we're not from a datafilter
     fromDataFilter = false;
@@ -59,18 +61,19 @@ PMCData::PMCData(Context *context, Specification spec, QString metricName, int s
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate(RideItem*)));
     connect(context->athlete->seasons, SIGNAL(seasonsChanged()), this, SLOT(invalidate()));
 }
 
 PMCData::PMCData(Context *context, Specification spec, Leaf *expr, DataFilterRuntime *df, int stsDays, int ltsDays) 
-    : context(context), specification_(spec), metricName_(""), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true)
+    : context(context), specification_(spec), metricName_(""), stsDays_(stsDays), ltsDays_(ltsDays), isstale(true), fullrefresh(true)
 {
     // get defaults if not passed
     useDefaults = false;
+    days_ = 0;
 
     // use an expression
     fromDataFilter = true;
@@ -92,15 +95,49 @@ PMCData::PMCData(Context *context, Specification spec, Leaf *expr, DataFilterRun
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideDeleted(RideItem*)));
     connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate(RideItem*)));
 }
 
 void PMCData::invalidate()
 {
     isstale=true;
+    fullrefresh=true;
+}
+
+// only days from the ride onwards need recomputing, including
+// the day it was on before if the date was changed
+void PMCData::invalidate(RideItem *item)
+{
+    QDate from = item->dateTime.date();
+    QHash<RideItem*, QDate>::const_iterator it = contributed.constFind(item);
+    if (it != contributed.constEnd() && it.value() < from) from = it.value();
+
+    // the date moved, the ride cache may not be in date order until it
+    // is sorted again and we search it by date, so recompute the lot
+    if (it != contributed.constEnd() && it.value() != item->dateTime.date()) fullrefresh=true;
+
+    if (dirtyFrom == QDate() || from < dirtyFrom) dirtyFrom = from;
+    isstale=true;
+}
+
+void PMCData::rideDeleted(RideItem *item)
+{
+    invalidate(item);
+    contributed.remove(item);
+}
+
+static bool pmcRideBefore(const RideItem *item, const QDate &date) { return item->dateTime.date() < date; }
+
+// we search the rides by date, which needs them in date order; after a
+// date is edited they may not be until the ride cache sorts them again
+static bool pmcRidesInOrder(const QVector<RideItem*> &rides)
+{
+    for (int i=1; i<rides.count(); i++)
+        if (rides[i]->dateTime.date() < rides[i-1]->dateTime.date()) return false;
+    return true;
 }
 
 void PMCData::refresh()
@@ -122,6 +159,10 @@ void PMCData::refresh()
     QTime timer;
     timer.start();
 
+    // what we computed last time, to see if we can just update
+    QDate wasStart = start_;
+    int wasDays = days_;
+
     //
     // STEP ONE: What is the date range ?
     //
@@ -214,28 +255,56 @@ void PMCData::refresh()
     double lte = (double)exp(-1.0/ltsDays_);
     double ste = (double)exp(-1.0/stsDays_);
 
+    // when only rides changed we recompute from the earliest day affected,
+    // the days before it are unchanged so we carry on from where they left off
+    // anything else (parameters, seasons, range starts earlier, a new day
+    // for expected values) and we recompute the lot
+    int from = 0;
+    if (!fullrefresh && wasStart == start_ && wasDays > 0 && dirtyFrom != QDate() &&
+        computedSts == stsDays_ && computedLts == ltsDays_ && computedSbToday == sbToday &&
+        computedOn == QDate::currentDate() && pmcRidesInOrder(context->athlete->rideCache->rides())) {
+
+        from = qMax(0, qMin(qMin(wasDays, days_), start_.daysTo(dirtyFrom)));
+    }
+
     // clear what's there
-    stress_.fill(0);
-    lts_.fill(0);
-    sts_.fill(0);
-    sb_.fill(0);
-    rr_.fill(0);
-
-    planned_stress_.fill(0);
-    planned_lts_.fill(0);
-    planned_sts_.fill(0);
-    planned_sb_.fill(0);
-    planned_rr_.fill(0);
-
-    expected_lts_.fill(0);
-    expected_sts_.fill(0);
-    expected_sb_.fill(0);
-    expected_rr_.fill(0);
+    if (from == 0) {
+
+        stress_.fill(0);
+        lts_.fill(0);
+        sts_.fill(0);
+        sb_.fill(0);
+        rr_.fill(0);
+
+        planned_stress_.fill(0);
+        planned_lts_.fill(0);
+        planned_sts_.fill(0);
+        planned_sb_.fill(0);
+        planned_rr_.fill(0);
+
+        expected_lts_.fill(0);
+        expected_sts_.fill(0);
+        expected_sb_.fill(0);
+        expected_rr_.fill(0);
+
+        contributed.clear();
+
+    } else {
+
+        // the derived series are overwritten as we go
+        // but stress is accumulated and lts/sts are seeded
+        for (int day=from; day < days_; day++) {
+            stress_[day] = lts_[day] = sts_[day] = 0;
+            planned_stress_[day] = planned_lts_[day] = planned_sts_[day] = 0;
+        }
+    }
 
     // add the seeded values from seasons
     foreach(Season x, context->athlete->seasons->seasons) {
         if (x.getSeed()) {
             int offset = start_.daysTo(x.getStart());
+            if (offset < from) continue;
+
             lts_[offset] = x.getSeed() * -1;
             sts_[offset] = x.getSeed() * -1;
 
@@ -244,8 +313,17 @@ void PMCData::refresh()
         }
     }
 
-    // add the stress scores
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+    // add the stress scores, rides are sorted by date so skip to the first
+    // one we need
+    int metricIndex = RideMetricFactory::instance().metricIndex(metricName_);
+    const QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+    QVector<RideItem*>::const_iterator first = rides.constBegin();
+    if (from) first = std::lower_bound(rides.constBegin(), rides.constEnd(), start_.addDays(from), pmcRideBefore);
+
+    for (QVector<RideItem*>::const_iterator it = first; it != rides.constEnd(); ++it) {
+
+        RideItem *item = *it;
+        contributed.insert(item, item->dateTime.date());
 
         if (!specification_.pass(item)) continue;
 
@@ -257,7 +335,7 @@ void PMCData::refresh()
             // builds have a rideDB.json that has nan and inf values in it.
             double value = 0;;
             if (fromDataFilter) value = expr->eval(df, expr, 0, item).number;
-            else value = item->getForSymbol(metricName_);
+            else value = item->getForMetric(metricIndex);
 
             if (!std::isinf(value) && !std::isnan(value)) {
                 if (item->planned)
@@ -289,7 +367,14 @@ void PMCData::refresh()
 
     double expected_rollingStress=0;
 
-    for(int day=0; day < days_; day++) {
+    // carry on from the last unchanged day
+    if (from) {
+        rollingStress = rr_[from-1];
+        planned_rollingStress = planned_rr_[from-1];
+        expected_rollingStress = expected_rr_[from-1];
+    }
+
+    for(int day=from; day < days_; day++) {
 
         // not seeded
         if (lts_[day] >=0 || sts_[day]>=0) {
@@ -432,7 +517,15 @@ void PMCData::refresh()
 
     }
 
-    //qDebug()<<"refresh PMC in="<<timer.elapsed()<<"ms";
+    //qDebug()<<"refresh PMC from="<<from<<"in="<<timer.elapsed()<<"ms";
+
+    // remember what we computed with
+    computedSts = stsDays_;
+    computedLts = ltsDays_;
+    computedSbToday = sbToday;
+    computedOn = QDate::currentDate();
+    dirtyFrom = QDate();
+    fullrefresh=false;
 
     isstale=false;
 }
@@ -32,6 +32,7 @@
 #include <QTreeWidgetItem>
 
 class Context;
+class RideItem;
 
 class PMCData : public QObject {
 
@@ -107,6 +108,8 @@ class PMCData : public QObject {
         // as underlying ride data changes the
         // contents are invalidated and refreshed
         void invalidate();
+        void invalidate(RideItem *); // from the ride date onwards
+        void rideDeleted(RideItem *);
         void refresh();
 
     private:
@@ -133,6 +136,14 @@ class PMCData : public QObject {
         QVector<double> expected_lts_, expected_sts_, expected_sb_, expected_rr_;
 
         bool isstale; // needs refreshing
+
+        // incremental updates, we recompute from dirtyFrom onwards
+        // unless fullrefresh, or the parameters changed since computed
+        bool fullrefresh;
+        QDate dirtyFrom, computedOn;
+        int computedSts, computedLts;
+        bool computedSbToday;
+        QHash<RideItem*, QDate> contributed; // date each ride was added on
 };
 
 #endif // _GC_StressCalculator_h
@@ -117,6 +117,13 @@ void PaceZones::initializeZoneParameters()
 
 // read zone file, allowing for zones with or without end dates
 bool PaceZones::read(QFile &file)
+{
+    bool returning = parse(file);
+    indexRanges();
+    return returning;
+}
+
+bool PaceZones::parse(QFile &file)
 {
     defaults_from_user = false;
     scheme.zone_default.clear();
@@ -510,15 +517,19 @@ next_line: {}
 // end of range
 int PaceZones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-
-        const PaceZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
+    // called a lot, so looked up in an index rather than searching ranges
+    const DateIndex *index = rangeIndex.get();
+    return index ? index->find(date) : -1;
+}
 
+void PaceZones::indexRanges()
+{
+    QVector<QDate> begins, ends;
+    foreach(const PaceZoneRange &range, ranges) {
+        begins << range.begin;
+        ends << range.end;
     }
-    return -1;
+    rangeIndex.publish(new DateIndex(begins, ends));
 }
 
 int PaceZones::numZones(int rnum) const
@@ -837,6 +848,7 @@ void PaceZones::write(QDir home)
 void PaceZones::addZoneRange(QDate _start, QDate _end, double _cv)
 {
     ranges.append(PaceZoneRange(_start, _end, _cv));
+    indexRanges();
 }
 
 // insert a new zone range using the current scheme
@@ -854,6 +866,7 @@ int PaceZones::addZoneRange(QDate _start, double _cv)
 
     // modify previous end date
     if (rnum) ranges[rnum-1].end = _start;
+    indexRanges();
 
     // set zones from CV
     if (_cv > 0) {
@@ -867,17 +880,20 @@ int PaceZones::addZoneRange(QDate _start, double _cv)
 void PaceZones::addZoneRange()
 {
     ranges.append(PaceZoneRange(date_zero, date_infinity));
+    indexRanges();
 }
 
 void PaceZones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 
 void PaceZones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 
@@ -942,6 +958,7 @@ int PaceZones::deleteRange(int rnum) {
     if (rnum > 0) setEndDate(rnum-1, getEndDate(rnum));
     // delete this range then
     ranges.removeAt(rnum);
+    indexRanges();
 
     return rnum-1;
 }
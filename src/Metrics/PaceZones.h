@@ -26,6 +26,7 @@
 #include "Athlete.h"
 
 #include <QtCore>
+#include "DateIndex.h"
 
 // A zone "scheme" defines how power zones
 // are calculated as a percentage of CV
@@ -97,6 +98,9 @@ class PaceZones : public QObject
 
         // CV History
         QList<PaceZoneRange> ranges;
+        Published<DateIndex> rangeIndex; // which range is in force by date
+        void indexRanges();
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -138,7 +142,7 @@ class PaceZones : public QObject
 
         // Get / Set ZoneRange details
         PaceZoneRange getZoneRange(int rnum) { return ranges[rnum]; }
-        void setZoneRange(int rnum, PaceZoneRange x) { ranges[rnum] = x; }
+        void setZoneRange(int rnum, PaceZoneRange x) { ranges[rnum] = x; indexRanges(); }
 
         // get and set CV for a given range
         double getCV(int rnum) const;
@@ -111,7 +111,7 @@ class PeakHr : public RideMetric {
     {
         setType(RideMetric::Peak);
     }
-    void setSecs(double secs) { this->secs=secs; }
+    void setSecs(double secs) { this->secs=secs; PeakCache::declare(true, RideFile::hr, secs); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
@@ -43,17 +43,22 @@ class PeakPace : public RideMetric {
     bool isLowerBetter() const { return true; }
     // Overrides to use Pace units setting
     QString units(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
         return RideMetric::units(metricRunPace);
     }
     double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
         return RideMetric::value(metricRunPace);
     }
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    double value(double v, bool) const {
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
+        return RideMetric::value(v, metricRunPace);
     }
-    void setSecs(double secs) { this->secs=secs; }
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
+    }
+    void setSecs(double secs) { this->secs=secs; PeakCache::declare(true, RideFile::kph, secs); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
@@ -386,17 +391,22 @@ class PeakPaceSwim : public RideMetric {
     bool isLowerBetter() const { return true; }
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metricSwimPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricSwimPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metricSwimPace);
     }
     double value(bool) const {
-        bool metricSwimPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricSwimPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metricSwimPace);
     }
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    double value(double v, bool) const {
+        bool metricSwimPace = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metricSwimPace);
+    }
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
-    void setSecs(double secs) { this->secs=secs; }
+    void setSecs(double secs) { this->secs=secs; PeakCache::declare(true, RideFile::kph, secs); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
@@ -726,10 +736,11 @@ class BestTime : public RideMetric {
     }
     // BestTime ordering is reversed
     bool isLowerBetter() const { return true; }
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
-    void setMeters(double meters) { this->meters=meters; }
+    void setMeters(double meters) { this->meters=meters; PeakCache::declare(false, RideFile::kph, meters); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
@@ -1126,7 +1137,7 @@ class PeakPaceHr : public RideMetric {
     {
         setType(RideMetric::Peak);
     }
-    void setSecs(double secs) { this->secs=secs; }
+    void setSecs(double secs) { this->secs=secs; PeakCache::declare(true, RideFile::kph, secs); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
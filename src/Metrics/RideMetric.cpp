@@ -20,6 +20,7 @@
 #include "RideItem.h"
 #include "IntervalItem.h"
 #include "Specification.h"
+#include "AddIntervalDialog.h"
 #include "UserMetricSettings.h"
 #include "TimeUtils.h"
 #include "Zones.h"
@@ -206,9 +207,13 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
     // this is what we've completed as we go
     QHash<QString,RideMetric*> done;
 
+    // the peak metrics share their passes over the samples
+    PeakCache peaks(spec);
+
     // resize the metric array in the interval if needed
-    if (spec.interval() && spec.interval()->metrics().size() < factory.metricCount()) 
-        spec.interval()->metrics().resize(factory.metricCount());
+    // (raw access, intervals compute their metrics by calling us)
+    if (spec.interval() && spec.interval()->metrics_.size() < factory.metricCount()) 
+        spec.interval()->metrics_.resize(factory.metricCount());
 
     // resize the metric array in the interval if needed
     if (!spec.interval() && item->metrics().size() < factory.metricCount())
@@ -261,7 +266,7 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
             // update their values directly. But only need to bother if the
             // user has defined any local metrics.
             if (user.count()) {
-                if (spec.interval()) spec.interval()->metrics()[m->index()] = m->value();
+                if (spec.interval()) spec.interval()->metrics_[m->index()] = m->value();
                 else item->metrics()[m->index()] = m->value();
             }
 
@@ -315,6 +320,6 @@ RideMetric::toString(bool useMetricUnits) const
 QString
 RideMetric::toString(bool useMetricUnits, double v) const
 {
-    if (isTime()) return time_to_string(value(useMetricUnits));
+    if (isTime()) return time_to_string(value(v, useMetricUnits));
     return QString("%1").arg(value(v, useMetricUnits), 0, 'f', this->precision());
 }
@@ -139,7 +139,7 @@ public:
 
     // The actual value of this ride metric, in the units above.
     virtual double value(bool metric) const { return metric ? value_ : (value_ * conversion_ + conversionSum_); }
-    virtual double value(double v, bool metric) const { return metric ? v : (v * conversion_ + conversionSum_); }
+    virtual double value(double v, bool metric) const { return metric ? v : (v * conversion() + conversionSum()); }
 
     // The internal value of this ride metric, useful to cache and then setValue.
     double value() const { return value_; }
@@ -397,6 +397,11 @@ private:
     const QString &metricName(int i) const { return metricNames[i]; }
     const RideMetric::MetricType &metricType(int i) const { return metricTypes[i]; }
     const RideMetric *rideMetric(QString name) const { return metrics.value(name, NULL); }
+    const RideMetric *rideMetricAt(int i) const { return metrics.value(metricNames[i], NULL); }
+
+    // resolve once outside of hot loops, then use the index based
+    // accessors e.g. RideItem::getForMetric, -1 if not known
+    int metricIndex(QString name) const { const RideMetric *m = metrics.value(name, NULL); return m ? m->index() : -1; }
 
     bool haveMetric(const QString &symbol) const {
         return metrics.contains(symbol);
@@ -275,17 +275,22 @@ class Pace : public RideMetric {
 
     // Overrides to use Pace units setting
     QString units(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
         return RideMetric::units(metricRunPace);
     }
 
     double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_PACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
         return RideMetric::value(metricRunPace);
     }
+    double value(double v, bool) const {
+        bool metricRunPace = appsettings->snapshot()->metricRunPace;
+        return RideMetric::value(v, metricRunPace);
+    }
 
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
 
     void initialize() {
@@ -42,13 +42,17 @@ class DistanceSwim : public RideMetric {
     }
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metricSwPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricSwPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metricSwPace);
     }
     double value(bool) const {
-        bool metricSwPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricSwPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metricSwPace);
     }
+    double value(double v, bool) const {
+        bool metricSwPace = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metricSwPace);
+    }
     void initialize() {
         setName(tr("Distance Swim"));
         setType(RideMetric::Total);
@@ -103,17 +107,22 @@ class PaceSwim : public RideMetric {
 
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metricRunPace);
     }
 
     double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metricRunPace);
     }
+    double value(double v, bool) const {
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metricRunPace);
+    }
 
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
 
     void initialize() {
@@ -173,17 +182,22 @@ class SwimPace : public RideMetric {
 
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metric = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metric);
     }
 
     double value(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metric = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metric);
     }
+    double value(double v, bool) const {
+        bool metric = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metric);
+    }
 
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
 
     void initialize() {
@@ -456,17 +470,22 @@ class SwimPaceStroke : public RideMetric {
 
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metric = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metric);
     }
 
     double value(bool) const {
-        bool metric = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metric = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metric);
     }
+    double value(double v, bool) const {
+        bool metric = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metric);
+    }
 
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60, true);
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60, true);
     }
 
     void initialize() {
@@ -144,15 +144,20 @@ class XPaceSwim : public RideMetric {
     bool isLowerBetter() const { return true; }
     // Overrides to use Swim Pace units setting
     QString units(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::units(metricRunPace);
     }
     double value(bool) const {
-        bool metricRunPace = appsettings->value(NULL, GC_SWIMPACE, true).toBool();
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
         return RideMetric::value(metricRunPace);
     }
-    QString toString(bool metric) const {
-        return time_to_string(value(metric)*60);
+    double value(double v, bool) const {
+        bool metricRunPace = appsettings->snapshot()->metricSwimPace;
+        return RideMetric::value(v, metricRunPace);
+    }
+    QString toString(bool metric) const { return toString(metric, value()); }
+    QString toString(bool metric, double v) const {
+        return time_to_string(value(v, metric)*60);
     }
     void initialize() {
         setName(tr("xPace Swim"));
@@ -89,7 +89,7 @@ class TRIMPPoints : public RideMetric {
 
         // gender
         double ksex = 1.92;
-        if (appsettings->cvalue(item->context->athlete->cyclist, GC_SEX).toInt() == 1) ksex = 1.67; // Female
+        if (appsettings->snapshot()->athlete(item->context->athlete->cyclist).sex == 1) ksex = 1.67; // Female
         else ksex = 1.92; // Male
 
         // ok lets work the score out
@@ -151,7 +151,7 @@ public:
 
         // gender
         double ksex = 1.92;
-        if (appsettings->cvalue(item->context->athlete->cyclist, GC_SEX).toInt() == 1) ksex = 1.67; // Female
+        if (appsettings->snapshot()->athlete(item->context->athlete->cyclist).sex == 1) ksex = 1.67; // Female
         else ksex = 1.92; // Male
 
         score = trimp == 0.0 ? 0.0 :  100 * trimp /
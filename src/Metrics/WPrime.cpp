@@ -86,13 +86,13 @@ WPrime::WPrime()
 {
     // XXX will need to reset metrics when they are added
     minY = maxY = 0;
-    wasIntegral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    wasIntegral = appsettings->snapshot()->wbalIntegral;
 }
 
 void
 WPrime::check()
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = appsettings->snapshot()->wbalIntegral;
     if (integral == wasIntegral) return;
     else if (rideFile) {
         wasIntegral = integral;
@@ -103,7 +103,7 @@ WPrime::check()
 void
 WPrime::setRide(RideFile *input)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = appsettings->snapshot()->wbalIntegral;
 
     QTime time; // for profiling performance of the code
     time.start();
@@ -372,7 +372,7 @@ WPrime::setRide(RideFile *input)
 void
 WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = appsettings->snapshot()->wbalIntegral;
 
     QTime time; // for profiling performance of the code
     time.start();
@@ -407,7 +407,7 @@ WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
             } else EXP += value; // total expenditure above CP
         }
 
-        TAU = appsettings->cvalue(context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+        TAU = appsettings->snapshot()->athlete(context->athlete->cyclist).wbaltau;
 
         // lets run forward from 0s to end of ride
         values.resize(last+1);
@@ -471,7 +471,7 @@ WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
 void
 WPrime::setErg(ErgFile *input)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = appsettings->snapshot()->wbalIntegral;
 
     QTime time; // for profiling performance of the code
     time.start();
@@ -524,7 +524,7 @@ WPrime::setErg(ErgFile *input)
             } else EXP += value; // total expenditure above CP
         }
 
-        TAU = appsettings->cvalue(input->context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+        TAU = appsettings->snapshot()->athlete(input->context->athlete->cyclist).wbaltau;
 
         // lets run forward from 0s to end of ride
         values.resize(last+1);
@@ -78,7 +78,7 @@ class PeakWPK : public RideMetric {
         setImperialUnits(tr("w/kg"));
         setPrecision(2);
     }
-    void setSecs(double secs) { this->secs=secs; }
+    void setSecs(double secs) { this->secs=secs; PeakCache::declare(true, RideFile::watts, secs); }
 
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
 
@@ -75,6 +75,13 @@ void Zones::initializeZoneParameters()
 
 // read zone file, allowing for zones with or without end dates
 bool Zones::read(QFile &file)
+{
+    bool returning = parse(file);
+    indexRanges();
+    return returning;
+}
+
+bool Zones::parse(QFile &file)
 {
     defaults_from_user = false;
     scheme.zone_default.clear();
@@ -519,15 +526,19 @@ next_line: {}
 // end of range
 int Zones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-
-        const ZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
+    // called a lot, so looked up in an index rather than searching ranges
+    const DateIndex *index = rangeIndex.get();
+    return index ? index->find(date) : -1;
+}
 
+void Zones::indexRanges()
+{
+    QVector<QDate> begins, ends;
+    foreach(const ZoneRange &range, ranges) {
+        begins << range.begin;
+        ends << range.end;
     }
-    return -1;
+    rangeIndex.publish(new DateIndex(begins, ends));
 }
 
 int Zones::numZones(int rnum) const
@@ -882,6 +893,7 @@ void Zones::write(QDir home)
 void Zones::addZoneRange(QDate _start, QDate _end, int _cp, int _ftp, int _wprime, int _pmax)
 {
     ranges.append(ZoneRange(_start, _end, _cp, _ftp, _wprime, _pmax));
+    indexRanges();
 }
 
 // insert a new zone range using the current scheme
@@ -899,6 +911,7 @@ int Zones::addZoneRange(QDate _start, int _cp, int _ftp, int _wprime, int _pmax)
 
     // modify previous end date
     if (rnum) ranges[rnum-1].end = _start;
+    indexRanges();
 
     // set zones from CP
     if (_cp > 0) {
@@ -913,17 +926,20 @@ int Zones::addZoneRange(QDate _start, int _cp, int _ftp, int _wprime, int _pmax)
 void Zones::addZoneRange()
 {
     ranges.append(ZoneRange(date_zero, date_infinity));
+    indexRanges();
 }
 
 void Zones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 
 void Zones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
+    indexRanges();
     modificationTime = QDateTime::currentDateTime();
 }
 
@@ -988,6 +1004,7 @@ int Zones::deleteRange(int rnum) {
     if (rnum > 0) setEndDate(rnum-1, getEndDate(rnum));
     // delete this range then
     ranges.removeAt(rnum);
+    indexRanges();
 
     return rnum-1;
 }
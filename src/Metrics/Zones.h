@@ -22,6 +22,7 @@
 #include "Athlete.h"
 
 #include <QtCore>
+#include "DateIndex.h"
 
 // A zone "scheme" defines how power zones
 // are calculated as a percentage of CP
@@ -96,6 +97,9 @@ class Zones : public QObject
 
         // CP History
         QList<ZoneRange> ranges;
+        Published<DateIndex> rangeIndex; // which range is in force by date
+        void indexRanges();
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -137,7 +141,7 @@ class Zones : public QObject
 
         // Get / Set ZoneRange details
         ZoneRange getZoneRange(int rnum) { return ranges[rnum]; }
-        void setZoneRange(int rnum, ZoneRange x) { ranges[rnum] = x; }
+        void setZoneRange(int rnum, ZoneRange x) { ranges[rnum] = x; indexRanges(); }
 
         // get and set CP for a given range
         int getCP(int rnum) const;
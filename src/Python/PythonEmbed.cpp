@@ -237,11 +237,15 @@ PythonEmbed::PythonEmbed(const bool verbose, const bool interactive) : verbose(v
                                      "import os\n"
                                      "sys.setdlopenflags(os.RTLD_NOW | os.RTLD_DEEPBIND)\n"
  #endif
+                                     "import _thread\n"
                                      "class CatchOutErr:\n"
                                      "    def __init__(self):\n"
-                                     "        self.value = ''\n"
+                                     "        self.values = {}\n"
                                      "    def write(self, txt):\n"
-                                     "        self.value += txt\n"
+                                     "        i = _thread.get_ident()\n"
+                                     "        self.values[i] = self.values.get(i, '') + txt\n"
+                                     "    def take(self):\n"
+                                     "        return self.values.pop(_thread.get_ident(), '')\n"
                                      "    def flush(self):\n"
                                      "        pass\n"
                                      "catchOutErr = CatchOutErr()\n"
@@ -267,7 +271,6 @@ PythonEmbed::PythonEmbed(const bool verbose, const bool interactive) : verbose(v
             printd("Get catcher refs\n");
             PyObject *pModule = PyImport_AddModule("__main__"); //create main module
             catcher = static_cast<void*>(PyObject_GetAttrString(pModule,"catchOutErr"));
-            clear = static_cast<void*>(PyObject_GetAttrString(static_cast<PyObject*>(catcher), "__init__"));
             PyErr_Print(); //make python print any errors
             PyErr_Clear(); //and clear them !
 
@@ -294,6 +297,38 @@ PythonEmbed::PythonEmbed(const bool verbose, const bool interactive) : verbose(v
     return;
 }
 
+// Python's id for the calling thread, must hold the GIL
+static long currentThreadId()
+{
+    PyObject* thread = PyImport_ImportModule("_thread");
+    PyObject* get_ident = PyObject_GetAttrString(thread, "get_ident");
+    PyObject* ident = PyObject_CallObject(get_ident, 0);
+    Py_DECREF(get_ident);
+    long id = PyLong_AsLong(ident);
+    Py_DECREF(ident);
+    return id;
+}
+
+// stdout and stderr written by the calling thread, must hold the GIL
+static QStringList takeOutput(PyObject *catcher)
+{
+    QStringList output;
+
+    PyObject *value = PyObject_CallMethod(catcher, "take", NULL);
+    if (value) {
+        // allocated as unicodeA
+        Py_ssize_t size;
+        wchar_t *string = PyUnicode_AsWideCharString(value, &size);
+        if (string) {
+            if (size) output = QString::fromWCharArray(string).split("\n");
+            PyMem_Free(string);
+            if (output.count()) output << "\n"; // always add a newline after anything
+        }
+        Py_DECREF(value);
+    }
+    return output;
+}
+
 // run on called thread
 void PythonEmbed::runline(ScriptContext scriptContext, QString line)
 {
@@ -301,12 +336,7 @@ void PythonEmbed::runline(ScriptContext scriptContext, QString line)
     gstate = PyGILState_Ensure();
 
     // Get current thread ID via Python thread functions
-    PyObject* thread = PyImport_ImportModule("_thread");
-    PyObject* get_ident = PyObject_GetAttrString(thread, "get_ident");
-    PyObject* ident = PyObject_CallObject(get_ident, 0);
-    Py_DECREF(get_ident);
-    threadid = PyLong_AsLong(ident);
-    Py_DECREF(ident);
+    threadid = currentThreadId();
 
     // add to the thread/context map
     contexts.insert(threadid, scriptContext);
@@ -328,25 +358,37 @@ void PythonEmbed::runline(ScriptContext scriptContext, QString line)
     PyErr_Clear(); //and clear them !
 
     // capture results
-    PyObject *output = PyObject_GetAttrString(static_cast<PyObject*>(catcher),"value"); //get the stdout and stderr from our catchOutErr object
-    if (output) {
-        // allocated as unicodeA
-        Py_ssize_t size;
-        wchar_t *string = PyUnicode_AsWideCharString(output, &size);
-        if (string) {
-            if (size) messages = QString::fromWCharArray(string).split("\n");
-            PyMem_Free(string);
-            if (messages.count()) messages << "\n"; // always add a newline after anything
-        }
-
-        // clear results
-        PyObject_CallFunction(static_cast<PyObject*>(clear), NULL);
-    }
+    messages = takeOutput(static_cast<PyObject*>(catcher));
 
     PyGILState_Release(gstate);
     threadid=-1;
 }
 
+// run on called thread, each script gets a copy of __main__ to run in
+// so their variables don't leak into one another
+bool PythonEmbed::runscript(ScriptContext scriptContext, QString script, QStringList &output)
+{
+    PyGILState_STATE gstate;
+    gstate = PyGILState_Ensure();
+
+    long id = currentThreadId();
+    contexts.insert(id, scriptContext);
+
+    PyObject *globals = PyDict_Copy(PyModule_GetDict(PyImport_AddModule("__main__")));
+    PyObject *v = PyRun_String(script.toStdString().c_str(), Py_file_input, globals, globals);
+    bool ok = (v != NULL);
+    if (v) Py_DECREF(v);
+    else PyErr_Print();
+    PyErr_Clear(); //and clear them !
+    Py_DECREF(globals);
+
+    output = takeOutput(static_cast<PyObject*>(catcher));
+
+    contexts.remove(id);
+    PyGILState_Release(gstate);
+    return ok;
+}
+
 void
 PythonEmbed::cancel()
 {
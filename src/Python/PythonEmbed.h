@@ -77,21 +77,25 @@ class PythonEmbed {
     // scripts can set a result value
     double result;
 
-    // catch and clear output - we use void* because we cannot
+    // catch output - we use void* because we cannot
     // include the python headers here as they redefine the slots
     // mechanism that QT needs in header files. As a result they
     // are cast to PyObject* the CPP source code (which are in turn
     // typedefs so we can't even declare the class type here).
     void *catcher;
-    void *clear;
 
     // run a single line from console
     void runline(ScriptContext, QString);
 
+    // run a fix script in a namespace of its own, output is returned
+    // instead of messages; false if the script raised an exception
+    bool runscript(ScriptContext, QString, QStringList &output);
+
     // stop current execution
     void cancel();
 
-    // context for caller - can be called in a thread
+    // context for caller - can be called in a thread, only
+    // accessed whilst holding the GIL so there is no locking
     QMap<long, ScriptContext> contexts;
     PythonChart *chart;
     QWidget *canvas;
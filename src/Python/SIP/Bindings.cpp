@@ -574,10 +574,9 @@ Bindings::series(int type, PyObject* activity) const
     RideFile *f = selectRideFile(activity);
     if (f == nullptr) return nullptr;
 
-    // count the included points, create data series output and copy data
-    int pCount = 0;
+    // the included points are a contiguous range, so no need to count
     RideFileIterator it(f, python->contexts.value(threadid()).spec);
-    while (it.hasNext()) { it.next(); pCount++; }
+    int pCount = it.firstIndex() >= 0 ? it.lastIndex() - it.firstIndex() + 1 : 0;
     RideFile::SeriesType seriesType = static_cast<RideFile::SeriesType>(type);
     bool readOnly = python->contexts.value(threadid()).readOnly;
     QList<RideFile *> *editedRideFiles = python->contexts.value(threadid()).editedRideFiles;
@@ -586,12 +585,10 @@ Bindings::series(int type, PyObject* activity) const
         editedRideFiles->append(f);
     }
 
+    // samples are stored by point, so this is the one copy we make
     PythonDataSeries* ds = new PythonDataSeries(seriesName(type), pCount, readOnly, seriesType, f);
-    it.toFront();
-    for(int i=0; i<pCount && it.hasNext(); i++) {
-        struct RideFilePoint *point = it.next();
-        ds->data[i] = point->value(seriesType);
-    }
+    const RideFilePoint * const *points = f->dataPoints().constData() + it.firstIndex();
+    for(int i=0; i<pCount; i++) ds->data[i] = points[i]->value(seriesType);
 
     return ds;
 }
@@ -618,8 +615,12 @@ Bindings::activityWbal(PyObject* activity) const
         if (pCount == 0) idxStart = i;
         pCount++;
     }
+    // the whole ride can share W'bal as it is, otherwise copy the slice
+    const QVector<double> &ydata = w->ydata();
+    if (idxStart == 0 && pCount == ydata.count()) return new PythonDataSeries("WBal", ydata);
+
     PythonDataSeries* ds = new PythonDataSeries("WBal", pCount);
-    for(int i=0; i<pCount; i++) ds->data[i] = w->ydata()[i+idxStart];
+    if (pCount > 0) std::copy(ydata.constBegin() + idxStart, ydata.constBegin() + idxStart + pCount, ds->data);
 
     return ds;
 }
@@ -759,13 +760,27 @@ Bindings::seriesPresent(int type, PyObject* activity) const
 PythonDataSeries::PythonDataSeries(QString name, Py_ssize_t count, bool readOnly, RideFile::SeriesType seriesType, RideFile *rideFile)
     : name(name), count(count), data(NULL), readOnly(readOnly), seriesType(seriesType), rideFile(rideFile)
 {
-    if (count > 0) data = new double[count];
+    if (count > 0) {
+        storage.resize(count);
+        data = storage.data();
+    }
 }
 
 PythonDataSeries::PythonDataSeries(QString name, Py_ssize_t count) : name(name), count(count), data(NULL),
     readOnly(true), seriesType(RideFile::none), rideFile(NULL)
 {
-    if (count > 0) data = new double[count];
+    if (count > 0) {
+        storage.resize(count);
+        data = storage.data();
+    }
+}
+
+// the values are implicitly shared with the caller, we only get our
+// own copy if someone asks to write to them (see detach)
+PythonDataSeries::PythonDataSeries(QString name, const QVector<double> &values) : name(name), count(values.count()),
+    data(NULL), storage(values), readOnly(true), seriesType(RideFile::none), rideFile(NULL)
+{
+    if (count > 0) data = const_cast<double*>(storage.constData());
 }
 
 // default constructor and copy constructor
@@ -783,7 +798,6 @@ PythonDataSeries::PythonDataSeries(PythonDataSeries *clone)
 
 PythonDataSeries::~PythonDataSeries()
 {
-    if (data) delete[] data;
     data=NULL;
     rideFile = NULL;
 }
@@ -1283,6 +1297,9 @@ Bindings::seasonIntervals(DateRange range, QString type) const
         if (!specification.pass(ride)) continue;
         if (!range.pass(ride->dateTime.date())) continue;
 
+        // we return all the metrics, compute any we haven't in one go
+        ride->computeIntervalMetrics();
+
         if (type.isEmpty()) intervals += ride->intervals().count();
         else {
             foreach(IntervalItem *item, ride->intervals())
@@ -1372,7 +1389,7 @@ Bindings::seasonIntervals(DateRange range, QString type) const
 
                 foreach(IntervalItem *interval, item->intervals()) {
                     if (type.isEmpty() || type == RideFileInterval::typeDescription(interval->type))
-                        PyList_SET_ITEM(metriclist, index++, PyFloat_FromDouble(interval->metrics()[i] * (useMetricUnits ? 1.0f : metric->conversion()) + (useMetricUnits ? 0.0f : metric->conversionSum())));
+                        PyList_SET_ITEM(metriclist, index++, PyFloat_FromDouble(interval->getForMetric(i) * (useMetricUnits ? 1.0f : metric->conversion()) + (useMetricUnits ? 0.0f : metric->conversionSum())));
                 }
             }
         }
@@ -1400,6 +1417,9 @@ Bindings::activityIntervals(QString type, PyObject* activity) const
 
     // how many interval to return in the currently selected RideItem ?
 
+    // we return all the metrics, compute any we haven't in one go
+    ride->computeIntervalMetrics();
+
     // we need to count intervals that are of requested type
     intervals = 0;
     if (type.isEmpty()) intervals = ride->intervals().count();
@@ -1480,7 +1500,7 @@ Bindings::activityIntervals(QString type, PyObject* activity) const
         int index=0;
         foreach(IntervalItem *item, ride->intervals()) {
             if (type.isEmpty() || type == RideFileInterval::typeDescription(item->type))
-                PyList_SET_ITEM(metriclist, index++, PyFloat_FromDouble(item->metrics()[i] * (useMetricUnits ? 1.0f : metric->conversion()) + (useMetricUnits ? 0.0f : metric->conversionSum())));
+                PyList_SET_ITEM(metriclist, index++, PyFloat_FromDouble(item->getForMetric(i) * (useMetricUnits ? 1.0f : metric->conversion()) + (useMetricUnits ? 0.0f : metric->conversionSum())));
         }
 
         // add to the dict
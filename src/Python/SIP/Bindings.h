@@ -15,13 +15,19 @@ class PythonDataSeries {
     public:
         PythonDataSeries(QString name, Py_ssize_t count, bool readOnly, RideFile::SeriesType seriesType, RideFile *rideFile);
         PythonDataSeries(QString name, Py_ssize_t count);
+        PythonDataSeries(QString name, const QVector<double> &values); // shares, no copy
         PythonDataSeries(PythonDataSeries*);
         PythonDataSeries();
         ~PythonDataSeries();
 
+        // take our own copy before writing if the values are shared
+        bool isShared() const { return !storage.isDetached(); }
+        void detach() { if (count > 0) data = storage.data(); }
+
         QString name;
         Py_ssize_t count;
-        double *data;
+        double *data;       // points into storage
+        QVector<double> storage;
 
         bool readOnly;
         int seriesType;
@@ -6,7 +6,7 @@
 
 #include "sipAPIgoldencheetah.h"
 
-#line 221 "goldencheetah.sip"
+#line 225 "goldencheetah.sip"
 //#include "Bindings.h"
 #line 12 "./sipgoldencheetahBindings.cpp"
 
@@ -16,7 +16,7 @@
 #line 59 "goldencheetah.sip"
 #include "Bindings.h"
 #line 19 "./sipgoldencheetahBindings.cpp"
-#line 131 "goldencheetah.sip"
+#line 135 "goldencheetah.sip"
 #include "Bindings.h"
 #line 22 "./sipgoldencheetahBindings.cpp"
 
@@ -33,13 +33,14 @@ static int slot_PythonDataSeries___setitem__(PyObject *sipSelf,PyObject *sipArgs
         {
             sipErrorState sipError = sipErrorNone;
 
-#line 104 "goldencheetah.sip"
+#line 107 "goldencheetah.sip"
         if (sipCpp->readOnly) {
             PyErr_SetString(PyExc_AttributeError, "Object is read-only");
             sipError = sipErrorFail;
         } else {
             if (a0 < 0) a0 += sipCpp->count;
             if (a0 >= 0 && a0 < sipCpp->count) {
+                sipCpp->detach();
                 sipCpp->data[a0] = a1;
                 RideFile *rideFile = sipCpp->rideFile;
                 if (rideFile) {
@@ -52,7 +53,7 @@ static int slot_PythonDataSeries___setitem__(PyObject *sipSelf,PyObject *sipArgs
                 sipError = sipErrorFail;
             }
         }
-#line 56 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 57 "./sipgoldencheetahPythonDataSeries.cpp"
 
             if (sipError == sipErrorFail)
                 return -1;
@@ -91,7 +92,7 @@ static PyObject *slot_PythonDataSeries___getitem__(PyObject *sipSelf,PyObject *s
             double sipRes = 0;
             sipErrorState sipError = sipErrorNone;
 
-#line 94 "goldencheetah.sip"
+#line 97 "goldencheetah.sip"
         if (a0 < 0) a0 += sipCpp->count;
         if (a0 >= 0 && a0 < sipCpp->count) {
             sipRes = sipCpp->data[a0];
@@ -99,7 +100,7 @@ static PyObject *slot_PythonDataSeries___getitem__(PyObject *sipSelf,PyObject *s
             PyErr_SetString(PyExc_IndexError, "Index out of range");
             sipError = sipErrorFail;
         }
-#line 103 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 104 "./sipgoldencheetahPythonDataSeries.cpp"
 
             if (sipError == sipErrorFail)
                 return 0;
@@ -133,9 +134,9 @@ static SIP_SSIZE_T slot_PythonDataSeries___len__(PyObject *sipSelf)
         {
             SIP_SSIZE_T sipRes = 0;
 
-#line 90 "goldencheetah.sip"
+#line 93 "goldencheetah.sip"
         sipRes = sipCpp->count;
-#line 139 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 140 "./sipgoldencheetahPythonDataSeries.cpp"
 
             return sipRes;
         }
@@ -158,9 +159,9 @@ static PyObject *slot_PythonDataSeries___str__(PyObject *sipSelf)
         {
              ::QString*sipRes = 0;
 
-#line 86 "goldencheetah.sip"
+#line 89 "goldencheetah.sip"
         sipRes = new QString(sipCpp->name);
-#line 164 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 165 "./sipgoldencheetahPythonDataSeries.cpp"
 
             return sipConvertFromNewType(sipRes,sipType_QString,NULL);
         }
@@ -180,16 +181,19 @@ static void release_PythonDataSeries(void *sipCppV, int)
 
 #if PY_MAJOR_VERSION >= 3
 extern "C" {static int getbuffer_PythonDataSeries(PyObject *, void *, Py_buffer *, int);}
-static int getbuffer_PythonDataSeries(PyObject *sipSelf, void *sipCppV, Py_buffer *sipBuffer, int )
+static int getbuffer_PythonDataSeries(PyObject *sipSelf, void *sipCppV, Py_buffer *sipBuffer, int sipFlags)
 {
      ::PythonDataSeries *sipCpp = reinterpret_cast< ::PythonDataSeries *>(sipCppV);
     int sipRes;
 
 #line 63 "goldencheetah.sip"
+    // shared values are copied before anyone gets to write to them
+    if (sipFlags & PyBUF_WRITABLE) sipCpp->detach();
+
     sipBuffer->obj = sipSelf;
     sipBuffer->buf = (void*)sipCpp->data;
     sipBuffer->len = sipCpp->count * sizeof(double);
-    sipBuffer->readonly = 0;
+    sipBuffer->readonly = sipCpp->isShared() ? 1 : 0;
     sipBuffer->itemsize = sizeof(double);
     sipBuffer->format = (char*)"d";  // double
     sipBuffer->ndim = 1;
@@ -200,7 +204,7 @@ static int getbuffer_PythonDataSeries(PyObject *sipSelf, void *sipCppV, Py_buffe
 
     Py_INCREF(sipSelf);  // need to increase the reference count
     sipRes = 0;
-#line 204 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 208 "./sipgoldencheetahPythonDataSeries.cpp"
 
     return sipRes;
 }
@@ -211,9 +215,9 @@ static int getbuffer_PythonDataSeries(PyObject *sipSelf, void *sipCppV, Py_buffe
 extern "C" {static void releasebuffer_PythonDataSeries(PyObject *, void *, Py_buffer *);}
 static void releasebuffer_PythonDataSeries(PyObject *, void *, Py_buffer *)
 {
-#line 80 "goldencheetah.sip"
+#line 83 "goldencheetah.sip"
     // we do not require any special release function
-#line 217 "./sipgoldencheetahPythonDataSeries.cpp"
+#line 221 "./sipgoldencheetahPythonDataSeries.cpp"
 }
 #endif
 
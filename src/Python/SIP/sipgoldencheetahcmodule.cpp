@@ -9,10 +9,10 @@
 #line 59 "goldencheetah.sip"
 #include "Bindings.h"
 #line 12 "./sipgoldencheetahcmodule.cpp"
-#line 131 "goldencheetah.sip"
+#line 135 "goldencheetah.sip"
 #include "Bindings.h"
 #line 15 "./sipgoldencheetahcmodule.cpp"
-#line 221 "goldencheetah.sip"
+#line 225 "goldencheetah.sip"
 //#include "Bindings.h"
 #line 18 "./sipgoldencheetahcmodule.cpp"
 
@@ -26,6 +26,7 @@ typedef void *QFunctionPointer;
 #endif
 
 #include <QStringList>
+
 class QString;
 class QLibrary;
 class RLibrary {
@@ -53,6 +54,14 @@ class RLibrary {
 // Must only be included after standard R headers
 // in order to redefine the entry points via QLibrary
 
+// ALTREP arrived in R 3.5, when compiled against older headers we
+// just copy vectors into R as we always have
+#include <Rversion.h>
+#if R_VERSION >= R_Version(3,5,0)
+#define GC_WANT_R_ALTREP 1
+#include <R_ext/Altrep.h>
+#endif
+
 // R Library Entry Points used by REmbed
 extern void GC_R_dot_Last(void);
 extern void GC_R_CheckUserInterrupt(void);
@@ -122,6 +131,22 @@ extern SEXP GC_Rf_install(const char *);
 extern SEXP GC_Rf_setAttrib(SEXP, SEXP, SEXP);
 extern Rboolean (GC_Rf_isNull)(SEXP s);
 extern const char *(GC_R_CHAR)(SEXP x);
+extern SEXP GC_R_MakeExternalPtr(void *p, SEXP tag, SEXP prot);
+extern void *GC_R_ExternalPtrAddr(SEXP s);
+extern void GC_R_RegisterCFinalizerEx(SEXP s, R_CFinalizer_t fun, Rboolean onexit);
+
+// ALTREP, optional so resolved quietly, check GC_R_haveAltrep()
+#ifdef GC_WANT_R_ALTREP
+extern bool GC_R_haveAltrep();
+extern R_altrep_class_t GC_R_make_altreal_class(const char *cname, const char *pname, DllInfo *info);
+extern SEXP GC_R_new_altrep(R_altrep_class_t aclass, SEXP data1, SEXP data2);
+extern SEXP GC_R_altrep_data1(SEXP x);
+extern void GC_R_set_altrep_Length_method(R_altrep_class_t cls, R_altrep_Length_method_t fun);
+extern void GC_R_set_altvec_Dataptr_method(R_altrep_class_t cls, R_altvec_Dataptr_method_t fun);
+extern void GC_R_set_altvec_Dataptr_or_null_method(R_altrep_class_t cls, R_altvec_Dataptr_or_null_method_t fun);
+extern void GC_R_set_altreal_Elt_method(R_altrep_class_t cls, R_altreal_Elt_method_t fun);
+extern void GC_R_set_altreal_Get_region_method(R_altrep_class_t cls, R_altreal_Get_region_method_t fun);
+#endif
 
 // Graphics Device
 #ifdef R_RGB // only redo graphics device if its included
@@ -213,6 +238,21 @@ extern double *pGC_R_NaReal;          // XXX TODO NaReal value
 #define INTEGER                     GC_INTEGER
 #define LOGICAL                     GC_LOGICAL
 #define R_CHAR                      GC_R_CHAR
+#define R_MakeExternalPtr           GC_R_MakeExternalPtr
+#define R_ExternalPtrAddr           GC_R_ExternalPtrAddr
+#define R_RegisterCFinalizerEx      GC_R_RegisterCFinalizerEx
+
+// ALTREP
+#ifdef GC_WANT_R_ALTREP
+#define R_make_altreal_class        GC_R_make_altreal_class
+#define R_new_altrep                GC_R_new_altrep
+#define R_altrep_data1              GC_R_altrep_data1
+#define R_set_altrep_Length_method  GC_R_set_altrep_Length_method
+#define R_set_altvec_Dataptr_method GC_R_set_altvec_Dataptr_method
+#define R_set_altvec_Dataptr_or_null_method GC_R_set_altvec_Dataptr_or_null_method
+#define R_set_altreal_Elt_method    GC_R_set_altreal_Elt_method
+#define R_set_altreal_Get_region_method GC_R_set_altreal_Get_region_method
+#endif
 
 // Graphics device
 #define GEcreateDevDesc             GC_GEcreateDevDesc
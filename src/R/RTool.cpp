@@ -61,6 +61,56 @@ typedef struct {
 
 } R_CMethodDef33;
 
+#ifdef GC_WANT_R_ALTREP
+// An ALTREP real vector that is backed by a QVector<double>, since
+// QVector is implicitly shared we can hand series over to R without
+// copying them. If R asks for a writeable pointer we detach first
+// so changes made in R never make their way back into GC.
+static R_altrep_class_t gc_shared_real;
+static bool gc_shared_real_registered = false;
+
+static QVector<double> *sharedRealVector(SEXP x)
+{
+    return static_cast<QVector<double>*>(R_ExternalPtrAddr(R_altrep_data1(x)));
+}
+
+static void sharedRealFinalize(SEXP ptr)
+{
+    delete static_cast<QVector<double>*>(R_ExternalPtrAddr(ptr));
+}
+
+static R_xlen_t sharedRealLength(SEXP x)
+{
+    return sharedRealVector(x)->count();
+}
+
+static void *sharedRealDataptr(SEXP x, Rboolean writeable)
+{
+    QVector<double> *v = sharedRealVector(x);
+    if (writeable) return v->data();
+    return const_cast<double*>(v->constData());
+}
+
+static const void *sharedRealDataptrOrNull(SEXP x)
+{
+    return sharedRealVector(x)->constData();
+}
+
+static double sharedRealElt(SEXP x, R_xlen_t i)
+{
+    return sharedRealVector(x)->at(i);
+}
+
+static R_xlen_t sharedRealGetRegion(SEXP x, R_xlen_t i, R_xlen_t n, double *buf)
+{
+    const QVector<double> *v = sharedRealVector(x);
+    R_xlen_t count = v->count() - i;
+    if (count > n) count = n;
+    if (count > 0) memcpy(buf, v->constData() + i, count * sizeof(double));
+    return count < 0 ? 0 : count;
+}
+#endif
+
 RTool::RTool()
 {
     // setup the R runtime elements
@@ -243,6 +293,19 @@ RTool::RTool()
         if (majorN > 3 || (majorN == 3 && minorN > 3)) R_registerRoutines(info, (const R_CMethodDef*)(cMethods34), callMethods, NULL, NULL);
         else R_registerRoutines(info, (const R_CMethodDef*)(cMethods33), callMethods, NULL, NULL);
 
+#ifdef GC_WANT_R_ALTREP
+        // share series with R without copying, needs ALTREP from 3.5 onwards
+        if ((majorN > 3 || (majorN == 3 && minorN > 4)) && GC_R_haveAltrep()) {
+            gc_shared_real = R_make_altreal_class("gc_shared_real", "GoldenCheetah", info);
+            R_set_altrep_Length_method(gc_shared_real, sharedRealLength);
+            R_set_altvec_Dataptr_method(gc_shared_real, sharedRealDataptr);
+            R_set_altvec_Dataptr_or_null_method(gc_shared_real, sharedRealDataptrOrNull);
+            R_set_altreal_Elt_method(gc_shared_real, sharedRealElt);
+            R_set_altreal_Get_region_method(gc_shared_real, sharedRealGetRegion);
+            gc_shared_real_registered = true;
+        }
+#endif
+
         // what version are we running?
         #ifdef GC_WANT_ALLDEBUG
         fprintf(stderr,"R loaded. [Compiled=%s.%s, Loaded=%d.%d, Loaded DeviceEngine=%d]\n", R_MAJOR, R_MINOR, majorN, minorN, GC_R_GE_getVersion());
@@ -1387,6 +1450,9 @@ RTool::dfForDateRangeIntervals(DateRange range, QStringList types)
         if (!specification.pass(ride)) continue;
         if (!range.pass(ride->dateTime.date())) continue;
 
+        // we return all the metrics, compute any we haven't in one go
+        ride->computeIntervalMetrics();
+
         if (types.isEmpty()) intervals += ride->intervals().count();
         else {
             foreach(IntervalItem *item, ride->intervals())
@@ -1529,7 +1595,7 @@ RTool::dfForDateRangeIntervals(DateRange range, QStringList types)
 
                 foreach(IntervalItem *interval, item->intervals()) {
                     if (types.isEmpty() || types.contains(RideFileInterval::typeDescription(interval->type)))
-                        REAL(m)[index++] = interval->metrics()[i] * (useMetricUnits ? 1.0f : metric->conversion())
+                        REAL(m)[index++] = interval->getForMetric(i) * (useMetricUnits ? 1.0f : metric->conversion())
                                                           + (useMetricUnits ? 0.0f : metric->conversionSum());
                 }
             }
@@ -1835,6 +1901,9 @@ RTool::activityIntervals(SEXP pTypes, SEXP datetime)
     int intervals = 0;
     int metrics = factory.metricCount();
 
+    // we return all the metrics, compute any we haven't in one go
+    ride->computeIntervalMetrics();
+
     // we need to count intervals that are in range...
     if (types.isEmpty()) intervals = ride->intervals().count();
     else {
@@ -1948,7 +2017,7 @@ RTool::activityIntervals(SEXP pTypes, SEXP datetime)
         int index=0;
         foreach(IntervalItem *interval, ride->intervals()) {
             if (types.isEmpty() || types.contains(RideFileInterval::typeDescription(interval->type)))
-                REAL(m)[index++] = interval->metrics()[i] * (useMetricUnits ? 1.0f : metric->conversion())
+                REAL(m)[index++] = interval->getForMetric(i) * (useMetricUnits ? 1.0f : metric->conversion())
                                                   + (useMetricUnits ? 0.0f : metric->conversionSum());
         }
 
@@ -2567,6 +2636,32 @@ RTool::dfForDateRangeMeanmax(bool all, DateRange range, SEXP filter)
 }
 
 
+// a real vector with the values passed, shared rather than
+// copied when the R runtime supports it
+SEXP
+RTool::sharedReal(const QVector<double> &values)
+{
+#ifdef GC_WANT_R_ALTREP
+    if (gc_shared_real_registered) {
+
+        // R owns a reference to the values until it is collected
+        SEXP ptr;
+        PROTECT(ptr = R_MakeExternalPtr(new QVector<double>(values), R_NilValue, R_NilValue));
+        R_RegisterCFinalizerEx(ptr, sharedRealFinalize, TRUE);
+
+        SEXP ans = R_new_altrep(gc_shared_real, ptr, R_NilValue);
+        UNPROTECT(1);
+        return ans;
+    }
+#endif
+
+    SEXP ans;
+    PROTECT(ans=Rf_allocVector(REALSXP, values.count()));
+    if (values.count()) memcpy(REAL(ans), values.constData(), values.count() * sizeof(double));
+    UNPROTECT(1);
+    return ans;
+}
+
 SEXP
 RTool::dfForRideFileCache(RideFileCache *cache)
 {
@@ -2614,14 +2709,11 @@ RTool::dfForRideFileCache(RideFileCache *cache)
         if (values.count()==0) continue;
 
 
-        // set a vector
-        SEXP vector;
-        PROTECT(vector=Rf_allocVector(REALSXP, values.count()));
-
-        // will have different sizes e.g. when a daterange
+        // set a vector, will have different sizes e.g. when a daterange
         // since longest ride with e.g. power may be different
         // to longest ride with heartrate
-        for(int j=0; j<values.count(); j++) REAL(vector)[j] = values[j];
+        SEXP vector;
+        PROTECT(vector=sharedReal(values));
 
         // add to the list
         SET_VECTOR_ELT(ans, next, vector);
@@ -3693,16 +3785,8 @@ RTool::dfForActivityWBal(RideFile*f)
 
         if (w && w->ydata().count() >0) {
 
-                // construct a vector
-                SEXP ans;
-                PROTECT(ans=Rf_allocVector(REALSXP, w->ydata().count()));
-
-                // add values
-                for(int i=0; i<w->ydata().count(); i++) REAL(ans)[i] = w->ydata()[i];
-
-                UNPROTECT(1);
-
-                return ans;
+                // construct a vector sharing the values
+                return sharedReal(w->ydata());
         }
     }
 
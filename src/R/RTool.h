@@ -110,6 +110,9 @@ class RTool {
         SEXP dfForDateRangePeaks(bool all, DateRange range, SEXP filter, QList<RideFile::SeriesType> series, QList<int> durations);
         SEXP dfForRideFileCache(RideFileCache *p);      // returns meanmax for a cache
 
+        // real vector for R, shares rather than copies on R 3.5 or higher
+        static SEXP sharedReal(const QVector<double> &values);
+
 };
 
 // there is a global instance created in main
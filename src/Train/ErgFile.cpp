@@ -26,6 +26,7 @@
 #include <QXmlSimpleReader>
 
 #include <stdint.h>
+#include <algorithm> // for std::lower_bound
 #include "Units.h"
 #include "Utils.h"
 
@@ -51,7 +52,7 @@ bool ErgFile::isWorkout(QString name)
     return false;
 }
 ErgFile::ErgFile(QString filename, int mode, Context *context) :
-    filename(filename), mode(mode), context(context)
+    filename(filename), mode(mode), lapsSorted(true), context(context)
 {
     if (context->athlete->zones(false)) {
         int zonerange = context->athlete->zones(false)->whichRange(QDateTime::currentDateTime().date());
@@ -60,7 +61,7 @@ ErgFile::ErgFile(QString filename, int mode, Context *context) :
     reload();
 }
 
-ErgFile::ErgFile(Context *context) : mode(0), context(context)
+ErgFile::ErgFile(Context *context) : mode(0), leftPoint(0), rightPoint(0), lapsSorted(true), context(context)
 {
     if (context->athlete->zones(false)) {
         int zonerange = context->athlete->zones(false)->whichRange(QDateTime::currentDateTime().date());
@@ -166,6 +167,7 @@ void ErgFile::parseZwift()
         leftPoint = 0;
         rightPoint = 1;
         interpolatorReadIndex = 0;
+        indexPoints();
 
         // calculate climbing etc
         calculateMetrics();
@@ -229,6 +231,9 @@ void ErgFile::parseErg2(QString p)
 
         qDebug() << "document" << object["title"];
         valid = true;
+
+        // lookups need the segments for these points, not the last file's
+        indexPoints();
     }
 }
 
@@ -415,6 +420,7 @@ void ErgFile::parseTacx()
         leftPoint = 0;
         rightPoint = 1;
         interpolatorReadIndex = 0;
+        indexPoints();
 
         // calculate climbing etc
         calculateMetrics();
@@ -669,6 +675,7 @@ void ErgFile::parseComputrainer(QString p)
         leftPoint = 0;
         rightPoint = 1;
         interpolatorReadIndex = 0;
+        indexPoints();
 
         calculateMetrics();
 
@@ -796,6 +803,7 @@ void ErgFile::parseGpx()
     leftPoint = 0;                   // setup initial sample bracketing
     rightPoint = 1;
     interpolatorReadIndex = 0;
+    indexPoints();
 
     // calculate climbing etc
     calculateMetrics();
@@ -1151,49 +1159,24 @@ ErgFile::wattsAt(long x, int &lapnum)
     if (x < 0 || x > Duration) return -100;   // out of bounds!!!
 
     // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        int lap=0;
-        for (int i=0; i<Laps.count(); i++) {
-            if (x>=Laps.at(i).x) lap += 1;
-        }
-        lapnum = lap;
-
-    } else lapnum = 0;
+    lapnum = lapAt(x);
 
     // find right section of the file
-    while (x < Points.at(leftPoint).x || x > Points.at(rightPoint).x) {
-        if (x < Points.at(leftPoint).x) {
-            leftPoint--;
-            rightPoint--;
-        } else if (x > Points.at(rightPoint).x) {
-            leftPoint++;
-            rightPoint++;
-        }
-    }
+    int index = segmentAt(x);
+    if (index < 0) return Points.count() ? Points.first().val : -100;
+    const ErgFileSegment &segment = segments.at(index);
 
     // two different points in time but the same watts
-    // at both, it doesn't really matter which value
-    // we use
-    if (Points.at(leftPoint).val == Points.at(rightPoint).val)
-        return Points.at(rightPoint).val;
-
-    // the erg file will list the point in time twice
-    // to show a jump from one wattage to another
-    // at this point in ime (i.e x=100 watts=100 followed
+    // at both, or the erg file lists the point in time
+    // twice to show a jump from one wattage to another
+    // at this point in time (i.e x=100 watts=100 followed
     // by x=100 watts=200)
-    if (Points.at(leftPoint).x == Points.at(rightPoint).x)
-        return Points.at(rightPoint).val;
+    if (segment.flat) return segment.v1;
 
     // so this point in time between two points and
     // we are ramping from one point and another
-    // the steps in the calculation have been explicitly
-    // listed for code clarity
-    double deltaW = Points.at(rightPoint).val - Points.at(leftPoint).val;
-    double deltaT = Points.at(rightPoint).x - Points.at(leftPoint).x;
-    double offT = x - Points.at(leftPoint).x;
-    double factor = offT / deltaT;
-
-    double nowW = Points.at(leftPoint).val + (deltaW * factor);
+    double factor = (x - segment.x0) / segment.dx;
+    double nowW = segment.v0 + (segment.dv * factor);
 
     return nowW;
 }
@@ -1209,26 +1192,12 @@ ErgFile::gradientAt(long x, int &lapnum)
     if (x < 0 || x > Duration) return -100;   // out of bounds!!! (-10 through +15 are valid return vals)
 
     // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        int lap=0;
-        for (int i=0; i<Laps.count(); i++) {
-            if (x>=Laps.at(i).x) lap += 1;
-        }
-        lapnum = lap;
-
-    } else lapnum = 0;
+    lapnum = lapAt(x);
 
     // find right section of the file
-    while (x < Points.at(leftPoint).x || x > Points.at(rightPoint).x) {
-        if (x < Points.at(leftPoint).x) {
-            leftPoint--;
-            rightPoint--;
-        } else if (x > Points.at(rightPoint).x) {
-            leftPoint++;
-            rightPoint++;
-        }
-    }
-    return Points.at(leftPoint).val;
+    int index = segmentAt(x);
+    if (index < 0) return Points.count() ? Points.first().val : -100;
+    return segments.at(index).v0;
 }
 
 // Returns true if a location is determined, otherwise returns false.
@@ -1242,29 +1211,12 @@ bool ErgFile::locationAt(long meters, int &lapnum, geolocation &geoLoc)
     // No location unless... format contains location...
     if (format != CRS_LOC)  return false;
 
-    if (Laps.count() > 0) {
-        int lap = 0;
-        for (int i = 0; i<Laps.count(); i++) {
-            if (meters >= Laps.at(i).x) lap += 1;
-        }
-        lapnum = lap;
-
-    }
-    else lapnum = 0;
+    lapnum = lapAt(meters);
 
     // Ensure that interpolator is correctly primed for this request.
 
     // find right section of the file
-    while (meters < Points.at(leftPoint).x || meters > Points.at(rightPoint).x) {
-        if (meters < Points.at(leftPoint).x) {
-            leftPoint--;
-            rightPoint--;
-        }
-        else if (meters > Points.at(rightPoint).x) {
-            leftPoint++;
-            rightPoint++;
-        }
-    }
+    if (segmentAt(meters) < 0) return false;
 
     // At this point leftpoint and rightpoint bracket the query distance. Three cases:
     // Bracket Covered: If query bracket compatible with the current interpolation bracket then simply interpolate
@@ -1317,10 +1269,14 @@ bool ErgFile::locationAt(long meters, int &lapnum, geolocation &geoLoc)
 int ErgFile::nextLap(long x)
 {
     if (!isValid()) return -1; // not a valid ergfile
+    if (lapsStale()) indexPoints();
 
-    // do we need to return the Lap marker?
-    if (Laps.count() > 0) {
-        // If the current position is before the start the lap, then the lap is next
+    // If the current position is before the start the lap, then the lap is next
+    if (lapsSorted) {
+        QVector<long>::const_iterator i = std::upper_bound(lapStarts.constBegin(), lapStarts.constEnd(), x);
+        if (i != lapStarts.constEnd()) return *i;
+
+    } else {
         for (int i=0; i<Laps.count(); i++) {
             if (x<Laps.at(i).x) return Laps.at(i).x;
         }
@@ -1335,14 +1291,102 @@ int
 ErgFile::currentLap(long x)
 {
     if (!isValid()) return -1; // not a valid ergfile
+    if (lapsStale()) indexPoints();
 
     // If the current position is before the start of the next lap, return this lap
-    for (int i=0; i<Laps.count() - 1; i++) {
-        if (x<Laps.at(i+1).x) return Laps.at(i).x;
+    if (lapsSorted) {
+        int next = std::upper_bound(lapStarts.constBegin(), lapStarts.constEnd(), x) - lapStarts.constBegin();
+        if (next < 1) next = 1;
+        if (next < lapStarts.count()) return lapStarts.at(next-1);
+
+    } else {
+        for (int i=0; i<Laps.count() - 1; i++) {
+            if (x<Laps.at(i+1).x) return Laps.at(i).x;
+        }
     }
     return -1; // No matching lap
 }
 
+void
+ErgFile::indexPoints()
+{
+    // a segment between each pair of points, with what we need to
+    // interpolate along it worked out up front rather than every tick
+    segments.resize(Points.count() > 1 ? Points.count() - 1 : 0);
+    segmentStarts.resize(Points.count());
+    for (int i=0; i<Points.count(); i++) {
+        segmentStarts[i] = Points.at(i).x;
+        if (i+1 == Points.count()) break;
+
+        ErgFileSegment &segment = segments[i];
+        const ErgFilePoint &left = Points.at(i);
+        const ErgFilePoint &right = Points.at(i+1);
+        segment.x0 = left.x;
+        segment.x1 = right.x;
+        segment.v0 = left.val;
+        segment.v1 = right.val;
+        segment.dv = right.val - left.val;
+        segment.dx = right.x - left.x;
+        segment.flat = (left.val == right.val || left.x == right.x);
+    }
+
+    // lap starts, as counting them doesn't depend upon order we can
+    // always sort for lapAt, the rest need them in order already
+    lapStarts.resize(Laps.count());
+    lapsSorted = true;
+    for (int i=0; i<Laps.count(); i++) {
+        lapStarts[i] = Laps.at(i).x;
+        if (i && lapStarts[i] < lapStarts[i-1]) lapsSorted = false;
+    }
+    lapCounts = lapStarts;
+    std::sort(lapCounts.begin(), lapCounts.end());
+
+    // stay where we are if we can, e.g. intensity changed mid workout
+    if (leftPoint < 0 || leftPoint >= segments.count()) leftPoint = 0;
+    rightPoint = segments.count() ? leftPoint + 1 : 0;
+}
+
+int
+ErgFile::segmentAt(double x)
+{
+    if (segments.count() != (Points.count() > 1 ? Points.count() - 1 : 0)) indexPoints();
+    if (segments.isEmpty()) return -1;
+
+    // usually still in the same segment, or just moved into the next
+    // one, so check those before searching. When we do search we pick
+    // the same segment that stepping there one at a time would
+    if (leftPoint < 0 || leftPoint >= segments.count()) leftPoint = 0;
+    const ErgFileSegment &current = segments.at(leftPoint);
+
+    if (x < current.x0) {
+
+        // back to the last segment starting at or before x
+        int i = std::upper_bound(segmentStarts.constBegin(), segmentStarts.constBegin() + leftPoint, x) - segmentStarts.constBegin();
+        leftPoint = i > 0 ? i - 1 : 0;
+
+    } else if (x > current.x1) {
+
+        if (leftPoint+1 < segments.count() && x <= segments.at(leftPoint+1).x1) {
+            leftPoint++;
+        } else {
+            // forward to the first segment ending at or after x
+            int i = std::lower_bound(segmentStarts.constBegin() + leftPoint + 1, segmentStarts.constEnd(), x) - segmentStarts.constBegin();
+            leftPoint = qMin(i - 1, segments.count() - 1);
+        }
+    }
+    rightPoint = leftPoint + 1;
+    return leftPoint;
+}
+
+int
+ErgFile::lapAt(long x)
+{
+    if (lapsStale()) indexPoints();
+
+    // how many laps have started by x
+    return std::upper_bound(lapCounts.constBegin(), lapCounts.constEnd(), x) - lapCounts.constBegin();
+}
+
 void
 ErgFile::calculateMetrics()
 {
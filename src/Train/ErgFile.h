@@ -73,6 +73,19 @@ class ErgFileSection
         double start, end;
 };
 
+// the stretch between two points, set up by ErgFile::indexPoints()
+// so looking up the load or gradient on each tick is cheap
+class ErgFileSegment
+{
+    public:
+        ErgFileSegment() : x0(0), x1(0), v0(0), v1(0), dv(0), dx(0), flat(true) {}
+
+        double x0, x1;  // start and end, time in msecs or distance in meters
+        double v0, v1;  // value at start and end
+        double dv, dx;  // for interpolating along a ramp
+        bool flat;      // same value throughout, or a step (x0 == x1)
+};
+
 class ErgFileText
 {
     public:
@@ -127,6 +140,10 @@ class ErgFile
         int nextLap(long);      // return the start value (erg - time(ms) or slope - distance(m)) for the next lap
         int currentLap(long);   // return the start value (erg - time(ms) or slope - distance(m)) for the current lap
 
+        // must be called after changing Points or Laps, the lookups above
+        // will notice if the count changes but not if values are edited
+        void indexPoints();
+
         // turn the ergfile into a series of sections rather
         // than a list of points
         QList<ErgFileSection> Sections();
@@ -154,6 +171,15 @@ class ErgFile
         QList<ErgFileLap>   Laps;      // interval markers in the file
         QList<ErgFileText>  Texts;     // texts to display
 
+        // index over Points and Laps for the lookups
+        QVector<ErgFileSegment> segments;   // between Points i and i+1
+        QVector<double> segmentStarts;      // x of each point, for searching
+        QVector<long> lapStarts, lapCounts; // in file order and sorted
+        bool lapsSorted;
+        int segmentAt(double x);            // moves leftPoint/rightPoint, -1 if none
+        int lapAt(long x);                  // laps started by x
+        bool lapsStale() const { return lapStarts.count() != Laps.count(); }
+
         GeoPointInterpolator gpi; // Location interpolator
 
         void calculateMetrics(); // calculate IsoPower value for ErgFile
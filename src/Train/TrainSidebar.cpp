@@ -2517,6 +2517,7 @@ void TrainSidebar::adjustIntensity(int value)
     }
 
     // recalculate metrics
+    context->currentErgFile()->indexPoints();
     context->currentErgFile()->calculateMetrics();
     setLabels();
 
@@ -86,7 +86,8 @@ void WorkoutWidget::adjustLayout()
 }
 
 WorkoutWidget::WorkoutWidget(WorkoutWindow *parent, Context *context) :
-    QWidget(parent),  state(none), ergFile(NULL), dragging(NULL), parent(parent), context(context), stackptr(0), recording_(false)
+    QWidget(parent),  state(none), ergFile(NULL), dragging(NULL), parent(parent), context(context), stackptr(0),
+    mmpStale(true), computedCP(0), computedWPRIME(0), computedK(0), recording_(false)
 {
     minVX_=0;
     maxVX_=maxWX_=3600;
@@ -124,6 +125,7 @@ WorkoutWidget::updateErgFile(ErgFile *f)
     }
 
     f->Laps = laps_;
+    f->indexPoints();
 
     // update METADATA too
     // XXX missing!
@@ -1486,6 +1488,7 @@ WorkoutWidget::save()
         ergFile->Duration = p->x * 1000; // whatever the last is
     }
     ergFile->Laps = laps_;
+    ergFile->indexPoints();
 
     //
     // SAVE
@@ -1555,9 +1558,9 @@ WorkoutWidget::recompute(bool editing)
     if (PMAX<=0) PMAX=1000;
     int K=WPRIME/(PMAX-CP);
 
-    // truncate
-    wattsArray.resize(0);
-    mmpArray.resize(0);
+    // keep the last one to see what changed
+    QVector<int> previous;
+    previous.swap(wattsArray);
 
     // running time and watts for interpolating
     int ctime = 0;
@@ -1586,6 +1589,27 @@ WorkoutWidget::recompute(bool editing)
     if (maxY_ < maxy) maxY_ = maxy *1.5; // too small
     if (maxy == 0) maxY_ = 400;
 
+    //
+    // WHAT CHANGED?
+    //
+    // The derived series below are all cumulative, so everything before the
+    // first second that changed is still valid and we only need to recompute
+    // from there onwards. Dragging a block late in a long workout is cheap.
+    //
+    int secs=wattsArray.size();
+    int from = 0;
+    int common = qMin(previous.size(), secs);
+    while (from < common && previous[from] == wattsArray[from]) from++;
+
+    // CP changed so the TTE search needs to be redone
+    if (CP != computedCP || WPRIME != computedWPRIME || K != computedK) {
+        computedCP = CP;
+        computedWPRIME = WPRIME;
+        computedK = K;
+        from = 0;
+    }
+    bool changed = (from < secs || previous.size() != secs);
+
     //
     // COMPUTE KEY METRICS BikeStress/Intensity
     //
@@ -1593,15 +1617,19 @@ WorkoutWidget::recompute(bool editing)
     // The Workout Window has labels for BikeStress and IF.
     double IsoPower=0, BikeStress=0, IF=0;
 
-    // calculating IsoPower
-    QVector<int> NProlling(30);
-    NProlling.fill(0,30);
-    double NPtotal=0;
+    // calculating IsoPower, NPtotal is kept for each second
+    // so we can carry on from the last one that didn't change
+    // the rolling 30s sum is rebuilt from the watts before it
+    npTotal.resize(secs);
+    integrated.resize(secs);
+    double NPtotal = from ? npTotal[from-1] : 0;
     double NPsum=0;
-    int NPindex=0;
-    int NPcount=0;
+    long rt = from ? integrated[from-1] : 0;
+    for(int i=qMax(0, from-30); i<from; i++) NPsum += wattsArray[i];
+
+    for(int i=from; i<secs; i++) {
 
-    foreach(int watts, wattsArray) {
+        int watts = wattsArray[i];
 
         //
         // Iso Power
@@ -1609,20 +1637,21 @@ WorkoutWidget::recompute(bool editing)
 
         // sum last 30secs
         NPsum += watts;
-        NPsum -= NProlling[NPindex];
-        NProlling[NPindex] = watts;
+        if (i >= 30) NPsum -= wattsArray[i-30];
 
-        // running total and count
+        // running total
         NPtotal += pow(NPsum/30,4); // raise rolling average to 4th power
-        NPcount ++;
+        npTotal[i] = NPtotal;
 
-        // it moves up and down during the ride
-        if (NPcount > 30) {
-            IsoPower = pow(double(NPtotal) / double(NPcount), 0.25f);
-        }
+        // integrated for TTE search below
+        rt += watts;
+        integrated[i] = rt;
+    }
+    int NPcount = secs;
 
-        // move index on/round
-        NPindex = (NPindex >= 29) ? 0 : NPindex+1;
+    // it moves up and down during the ride
+    if (NPcount > 30) {
+        IsoPower = pow(double(npTotal[NPcount-1]) / double(NPcount), 0.25f);
     }
 
     // IF.....
@@ -1640,35 +1669,42 @@ WorkoutWidget::recompute(bool editing)
     //
     // COMPUTE W'BAL
     //
-    wpBal.setWatts(context, wattsArray, CP, WPRIME);
+    if (changed) wpBal.setWatts(context, wattsArray, CP, WPRIME);
 
     //
     // MEAN MAX [works but need to think about UI]
     //
-    RideFileCache::fastSearch(wattsArray, mmpArray, mmpOffsets);
+    // computed when its painted, see mmp()
+    if (changed) mmpStale = true;
     //qDebug()<<"RECOMPUTE:"<<timer.elapsed()<<"ms"<<wattsArray.count()<<"samples";
 
     //
     // SEARCH FOR IMPOSSIBLE TTE SECTIONS
     //
-    QVector<long> integrated;
-    integrated.resize(wattsArray.size());
-    long rt=0;
-    int secs=wattsArray.size();
-    for(int i=0; i<wattsArray.size(); i++) {
-        rt += wattsArray[i];
-        integrated[i] = rt;
-    }
 
-    // clear what we found last time
-    efforts.clear();
+    // efforts starting at i look up to an hour ahead, so those
+    // starting more than an hour before the change are still valid
+    // and the search state before each second is kept to restart
+    int restart = changed ? qMax(0, from-3601) : secs;
 
     for (int j=0; j<2; j++) {
 
         // 2 iterations:- 85% sustained, then 100% or higher
         WWEffort tte; tte.start = tte.duration = 0;
+        if (restart) {
+            tte = tteState[j][restart];
+            tteEfforts[j] = tteEfforts[j].mid(0, tteFound[j][restart]);
+        } else {
+            tteEfforts[j].clear();
+        }
+        tteState[j].resize(secs+1);
+        tteFound[j].resize(secs+1);
+
+        for (int i=restart; i<secs; i++) {
 
-        for (int i=0; i<secs; i++) {
+            // where we were, in case we need to restart here
+            tteState[j][i] = tte;
+            tteFound[j][i] = tteEfforts[j].count();
 
             // start out at 30 minutes and drop back to
             // 2 minutes, anything shorter and we are done
@@ -1713,7 +1749,7 @@ WorkoutWidget::recompute(bool editing)
 
                         // add 100 or more on second round
                         // quick way of doing overlapping
-                        if ((j && tc >= t) || (!j && tc < t)) efforts << tte;
+                        if ((j && tc >= t) || (!j && tc < t)) tteEfforts[j] << tte;
                     }
 
 
@@ -1728,8 +1764,13 @@ WorkoutWidget::recompute(bool editing)
                 }
             }
         }
+        tteState[j][secs] = tte;
+        tteFound[j][secs] = tteEfforts[j].count();
     }
 
+    // 85% sustained first, then 100% or higher
+    efforts = tteEfforts[0] + tteEfforts[1];
+
     // set the properties if not editing
     if (!editing) {
         qwkactive = true;
@@ -1741,6 +1782,18 @@ WorkoutWidget::recompute(bool editing)
     parent->setScroller(QPointF(minVX_,maxVX_));
 }
 
+const QVector<int> &
+WorkoutWidget::mmp()
+{
+    // only when its needed, it isn't cheap
+    if (mmpStale) {
+        mmpArray.resize(0);
+        RideFileCache::fastSearch(wattsArray, mmpArray, mmpOffsets);
+        mmpStale = false;
+    }
+    return mmpArray;
+}
+
 // as 1m or 60s etc
 static QString qduration(int t)
 {
@@ -209,6 +209,7 @@ class WorkoutWidget : public QWidget
         QVector<int> wattsArray;
         QVector<int> mmpArray, mmpOffsets;
         QList<WWEffort> efforts;
+        const QVector<int> &mmp(); // mean max, computed on demand
 
         // get regions for items to paint in
         void adjustLayout(); // sets margins etc
@@ -362,6 +363,16 @@ class WorkoutWidget : public QWidget
         // for computing W'bal
         WPrime wpBal;
 
+        // state kept between recomputes so edits only
+        // recompute from the first second that changed
+        bool mmpStale;
+        int computedCP, computedWPRIME, computedK;
+        QVector<double> npTotal;    // IsoPower running total
+        QVector<long> integrated;   // joules so far
+        QVector<WWEffort> tteState[2]; // TTE search state before each second
+        QVector<int> tteFound[2];      // efforts found before each second
+        QList<WWEffort> tteEfforts[2];
+
         // sizing
         double IHEIGHT;         // interval gap at bottom (used for TTE warning)
         double THEIGHT;         // top section height (lap markers)
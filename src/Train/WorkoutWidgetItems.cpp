@@ -600,7 +600,7 @@ WWMMPCurve::paint(QPainter *painter)
 
     // run through the wpBal values...
     int secs=0;
-    foreach(int watts, workoutWidget()->mmpArray) {
+    foreach(int watts, workoutWidget()->mmp()) {
 
         // skip zero
         if (watts == 0) { secs++; continue; }